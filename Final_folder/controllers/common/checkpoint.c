@@ -0,0 +1,115 @@
+/*****************************************************************************/
+/* File:         checkpoint.c                                                */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Atomic binary checkpoints of a state (PSO swarm) to resume  */
+/*               a long run after a crash                                    */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "checkpoint.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
+
+/* The state is written to <path>.<pid>.tmp, flushed to the disk and renamed to <path>: a crash
+   during the save leaves the previous checkpoint intact, and two processes saving the same file
+   never write to the same temporary file. A checkpoint with another tag or
+   size (other parameters) or a wrong checksum is ignored. */
+
+static uint32_t fnv1a(const void *data, uint32_t size) {
+    const unsigned char *p = data;
+    uint32_t hash = 2166136261u;
+    uint32_t i;
+    for (i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief      Save a state atomically
+ *
+ * @param[in]  path   The checkpoint file
+ * @param[in]  state  The state
+ * @param[in]  size   The size of the state [bytes]
+ * @param[in]  tag    The layout of the state
+ *
+ * @return     1 on failure (the previous checkpoint is kept)
+ */
+int checkpoint_save(const char *path, const void *state, uint32_t size, uint32_t tag) {
+    checkpoint_header_t header = {CHECKPOINT_MAGIC, CHECKPOINT_VERSION, tag, size, fnv1a(state, size)};
+    char tmp[512];
+    FILE *fp;
+    int ok;
+
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid());
+    fp = fopen(tmp, "wb");
+    if (fp == NULL)
+        return 1;
+    ok = fwrite(&header, sizeof(header), 1, fp) == 1 && fwrite(state, 1, size, fp) == size && fflush(fp) == 0;
+#ifndef _WIN32
+    ok = ok && fsync(fileno(fp)) == 0;
+#endif
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok) {
+        remove(tmp);
+        return 1;
+    }
+#ifdef _WIN32
+    remove(path);  // rename() does not replace a file on Windows
+#endif
+    if (rename(tmp, path) != 0) {
+        remove(tmp);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief      Load a state saved by checkpoint_save()
+ *
+ * @param[in]  path   The checkpoint file
+ * @param[out] state  The state (unchanged on failure)
+ * @param[in]  size   The size of the state [bytes]
+ * @param[in]  tag    The layout of the state
+ *
+ * @return     1 if there is no valid checkpoint for this state
+ */
+int checkpoint_load(const char *path, void *state, uint32_t size, uint32_t tag) {
+    checkpoint_header_t header;
+    void *buffer;
+    FILE *fp;
+    int ok;
+
+    fp = fopen(path, "rb");
+    if (fp == NULL)
+        return 1;
+    buffer = malloc(size);
+    ok = buffer != NULL && fread(&header, sizeof(header), 1, fp) == 1 && header.magic == CHECKPOINT_MAGIC &&
+         header.version == CHECKPOINT_VERSION && header.tag == tag && header.size == size &&
+         fread(buffer, 1, size, fp) == size && fnv1a(buffer, size) == header.checksum;
+    fclose(fp);
+    if (ok)
+        memcpy(state, buffer, size);
+    else
+        printf("Ignoring the invalid checkpoint %s\n", path);
+    free(buffer);
+    return !ok;
+}
+
+/**
+ * @brief      Remove a checkpoint (the run is over)
+ */
+void checkpoint_remove(const char *path) {
+    remove(path);
+}
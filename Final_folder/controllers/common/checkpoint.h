@@ -0,0 +1,24 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+
+#define CHECKPOINT_MAGIC    0x54504b43  // "CKPT"
+#define CHECKPOINT_VERSION  1
+
+/// Header of a checkpoint file, followed by size bytes of state
+typedef struct
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t tag;           // Identifies the layout of the state (e.g. NB_PARTICLE and DATASIZE)
+  uint32_t size;          // Size of the state [bytes]
+  uint32_t checksum;      // FNV-1a of the state
+} checkpoint_header_t;
+
+/// Documentation in c file
+int checkpoint_save(const char *path, const void *state, uint32_t size, uint32_t tag);
+int checkpoint_load(const char *path, void *state, uint32_t size, uint32_t tag);
+void checkpoint_remove(const char *path);
+
+#endif
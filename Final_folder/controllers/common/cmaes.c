@@ -0,0 +1,254 @@
+/*****************************************************************************/
+/* File:         cmaes.c                                                     */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  CMA-ES (covariance matrix adaptation evolution strategy),   */
+/*               optimizer of the pso supervisors alongside the PSO          */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "cmaes.h"
+
+/* Standard CMA-ES (Hansen, "The CMA Evolution Strategy: A Tutorial") with the default
+   parameters, maximizing the fitness. cmaes_ask() samples lambda candidates from
+   N(mean, sigma^2 C); the caller may repair them (domain of the weights) before evaluating
+   them, cmaes_tell() then adapts the mean, the evolution paths, C and sigma from the
+   candidates as they were evaluated. C is decomposed (Jacobi) at every generation, which is
+   cheap for the 4 to 13 weights of the supervisors next to an episode. The restarts (IPOP,
+   BIPOP) are driven by the caller with cmaes_stop(). */
+
+#define JACOBI_SWEEPS  50
+
+/* Default population */
+int cmaes_default_lambda(int dim) {
+    return 4 + (int)(3.0 * log((double)dim));
+}
+
+static double gauss(rng_t *r) {
+    return sqrt(-2.0 * log(1.0 - rng_uniform(r))) * cos(2.0 * M_PI * rng_uniform(r));
+}
+
+/* Eigen decomposition of C (cyclic Jacobi): C = B diag(D^2) B^T */
+static void eigen(cmaes_t *es) {
+    double A[CMAES_MAX_DIM][CMAES_MAX_DIM];
+    double off, theta, t, c, s, a, b;
+    int n = es->dim, i, j, k, sweep;
+
+    memcpy(A, es->C, sizeof(A));
+    for (i = 0; i < n; i++)
+        for (j = 0; j < n; j++)
+            es->B[i][j] = i == j ? 1.0 : 0.0;
+
+    for (sweep = 0; sweep < JACOBI_SWEEPS; sweep++) {
+        off = 0;
+        for (i = 0; i < n; i++)
+            for (j = i + 1; j < n; j++)
+                off += A[i][j] * A[i][j];
+        if (off < 1e-30)
+            break;
+        for (i = 0; i < n; i++) {
+            for (j = i + 1; j < n; j++) {
+                if (fabs(A[i][j]) < 1e-300)
+                    continue;
+                theta = (A[j][j] - A[i][i]) / (2.0 * A[i][j]);
+                t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                c = 1.0 / sqrt(t * t + 1.0);
+                s = t * c;
+                for (k = 0; k < n; k++) {  // Columns i and j
+                    a = A[k][i];
+                    b = A[k][j];
+                    A[k][i] = c * a - s * b;
+                    A[k][j] = s * a + c * b;
+                }
+                for (k = 0; k < n; k++) {  // Rows i and j
+                    a = A[i][k];
+                    b = A[j][k];
+                    A[i][k] = c * a - s * b;
+                    A[j][k] = s * a + c * b;
+                }
+                for (k = 0; k < n; k++) {
+                    a = es->B[k][i];
+                    b = es->B[k][j];
+                    es->B[k][i] = c * a - s * b;
+                    es->B[k][j] = s * a + c * b;
+                }
+            }
+        }
+    }
+    for (i = 0; i < n; i++)
+        es->D[i] = sqrt(fmax(A[i][i], 1e-300));
+}
+
+/**
+ * @brief      Start a CMA-ES run
+ *
+ * @param[out] es      The strategy
+ * @param[in]  dim     The number of elements of a candidate (at most CMAES_MAX_DIM)
+ * @param[in]  lambda  The population (clamped to [4, CMAES_MAX_LAMBDA])
+ * @param[in]  mean    The initial mean
+ * @param[in]  sigma   The initial step size
+ * @param[in]  scale   Initial standard deviation of each element relative to sigma (NULL: 1)
+ * @param[in]  seed    Seed of the samples (see common/rng.h)
+ */
+void cmaes_init(cmaes_t *es, int dim, int lambda, const double *mean, double sigma, const double *scale, uint64_t seed) {
+    double sum = 0, sum2 = 0;
+    int i, n;
+
+    memset(es, 0, sizeof(*es));
+    n = es->dim = dim < CMAES_MAX_DIM ? dim : CMAES_MAX_DIM;
+    es->lambda = lambda < 4 ? 4 : (lambda > CMAES_MAX_LAMBDA ? CMAES_MAX_LAMBDA : lambda);
+    es->mu = es->lambda / 2;
+    for (i = 0; i < es->mu; i++) {
+        es->weights[i] = log(es->mu + 0.5) - log(i + 1.0);
+        sum += es->weights[i];
+    }
+    for (i = 0; i < es->mu; i++) {
+        es->weights[i] /= sum;
+        sum2 += es->weights[i] * es->weights[i];
+    }
+    es->mueff = 1.0 / sum2;
+    es->cc = (4.0 + es->mueff / n) / (n + 4.0 + 2.0 * es->mueff / n);
+    es->cs = (es->mueff + 2.0) / (n + es->mueff + 5.0);
+    es->c1 = 2.0 / ((n + 1.3) * (n + 1.3) + es->mueff);
+    es->cmu = fmin(1.0 - es->c1, 2.0 * (es->mueff - 2.0 + 1.0 / es->mueff) / ((n + 2.0) * (n + 2.0) + es->mueff));
+    es->damps = 1.0 + 2.0 * fmax(0.0, sqrt((es->mueff - 1.0) / (n + 1.0)) - 1.0) + es->cs;
+    es->chin = sqrt((double)n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+
+    es->sigma = es->sigma0 = sigma;
+    memcpy(es->mean, mean, n * sizeof(double));
+    for (i = 0; i < n; i++) {
+        es->D[i] = scale != NULL ? scale[i] : 1.0;
+        es->C[i][i] = es->D[i] * es->D[i];
+        es->B[i][i] = 1.0;
+    }
+    rng_init(&es->rng, seed, RNG_STREAM(RNG_PARTICLE, 0));
+}
+
+/**
+ * @brief      Sample the candidates of the next generation in es->x
+ */
+void cmaes_ask(cmaes_t *es) {
+    double z[CMAES_MAX_DIM];
+    int i, j, k, n = es->dim;
+
+    for (k = 0; k < es->lambda; k++) {
+        for (i = 0; i < n; i++)
+            z[i] = es->D[i] * gauss(&es->rng);
+        for (i = 0; i < n; i++) {
+            es->x[k][i] = es->mean[i];
+            for (j = 0; j < n; j++)
+                es->x[k][i] += es->sigma * es->B[i][j] * z[j];
+        }
+    }
+}
+
+/**
+ * @brief      Adapt the distribution to the fitness of the candidates es->x
+ *
+ * @param      es    The strategy
+ * @param[in]  fit   The fitness of the lambda candidates (maximized)
+ */
+void cmaes_tell(cmaes_t *es, const double *fit) {
+    int order[CMAES_MAX_LAMBDA];
+    double old[CMAES_MAX_DIM], dm[CMAES_MAX_DIM], t[CMAES_MAX_DIM], y[CMAES_MAX_DIM];
+    double norm = 0, hsig, h;
+    int i, j, k, m, n = es->dim;
+
+    // Candidates by decreasing fitness (insertion sort, lambda is small)
+    for (k = 0; k < es->lambda; k++) {
+        for (m = k; m > 0 && fit[order[m - 1]] < fit[k]; m--)
+            order[m] = order[m - 1];
+        order[m] = k;
+    }
+
+    // Mean
+    memcpy(old, es->mean, n * sizeof(double));
+    for (i = 0; i < n; i++) {
+        es->mean[i] = 0;
+        for (k = 0; k < es->mu; k++)
+            es->mean[i] += es->weights[k] * es->x[order[k]][i];
+        dm[i] = (es->mean[i] - old[i]) / es->sigma;
+    }
+
+    // Evolution paths (ps with C^-1/2 dm = B D^-1 B^T dm)
+    for (j = 0; j < n; j++) {
+        t[j] = 0;
+        for (i = 0; i < n; i++)
+            t[j] += es->B[i][j] * dm[i];
+        t[j] /= es->D[j];
+    }
+    for (i = 0; i < n; i++) {
+        double c = 0;
+        for (j = 0; j < n; j++)
+            c += es->B[i][j] * t[j];
+        es->ps[i] = (1.0 - es->cs) * es->ps[i] + sqrt(es->cs * (2.0 - es->cs) * es->mueff) * c;
+        norm += es->ps[i] * es->ps[i];
+    }
+    norm = sqrt(norm);
+    es->generation++;
+    hsig = norm / sqrt(1.0 - pow(1.0 - es->cs, 2.0 * es->generation)) / es->chin < 1.4 + 2.0 / (n + 1.0);
+    for (i = 0; i < n; i++)
+        es->pc[i] = (1.0 - es->cc) * es->pc[i] + hsig * sqrt(es->cc * (2.0 - es->cc) * es->mueff) * dm[i];
+
+    // Covariance: rank one (pc) and rank mu (steps of the mu best)
+    h = (1.0 - hsig) * es->cc * (2.0 - es->cc);
+    for (i = 0; i < n; i++)
+        for (j = 0; j <= i; j++)
+            es->C[i][j] = (1.0 - es->c1 - es->cmu + es->c1 * h) * es->C[i][j] + es->c1 * es->pc[i] * es->pc[j];
+    for (k = 0; k < es->mu; k++) {
+        for (i = 0; i < n; i++)
+            y[i] = (es->x[order[k]][i] - old[i]) / es->sigma;
+        for (i = 0; i < n; i++)
+            for (j = 0; j <= i; j++)
+                es->C[i][j] += es->cmu * es->weights[k] * y[i] * y[j];
+    }
+    for (i = 0; i < n; i++)
+        for (j = 0; j < i; j++)
+            es->C[j][i] = es->C[i][j];
+
+    // Step size
+    es->sigma *= exp(es->cs / es->damps * (norm / es->chin - 1.0));
+    eigen(es);
+
+    // Best fitness of the last generations
+    memmove(&es->history[1], &es->history[0], (CMAES_MAX_LAMBDA - 1) * sizeof(double));
+    es->history[0] = fit[order[0]];
+    if (es->n_history < CMAES_MAX_LAMBDA)
+        es->n_history++;
+}
+
+/**
+ * @brief      Stop criterion of the run (a restart is due)
+ *
+ * @return     0 to continue, else CMAES_TOLX, CMAES_TOLFUN or CMAES_CONDITION
+ */
+int cmaes_stop(const cmaes_t *es) {
+    int window = 10 + (30 * es->dim + es->lambda - 1) / es->lambda;
+    double dmin = es->D[0], dmax = es->D[0], lo = es->history[0], hi = es->history[0];
+    int i, tolx = 1;
+
+    for (i = 0; i < es->dim; i++) {
+        dmin = es->D[i] < dmin ? es->D[i] : dmin;
+        dmax = es->D[i] > dmax ? es->D[i] : dmax;
+        if (es->sigma * fmax(fabs(es->pc[i]), sqrt(es->C[i][i])) > 1e-12 * es->sigma0)
+            tolx = 0;
+    }
+    if (tolx)
+        return CMAES_TOLX;
+    if (dmax * dmax > 1e14 * dmin * dmin)
+        return CMAES_CONDITION;
+    if (es->n_history >= window) {
+        for (i = 0; i < window; i++) {
+            lo = es->history[i] < lo ? es->history[i] : lo;
+            hi = es->history[i] > hi ? es->history[i] : hi;
+        }
+        if (hi - lo < 1e-12)
+            return CMAES_TOLFUN;
+    }
+    return 0;
+}
@@ -0,0 +1,46 @@
+#ifndef CMAES_H
+#define CMAES_H
+
+#include "rng.h"
+
+#define CMAES_MAX_DIM     32       // Maximum dimension of a particle (DATASIZE)
+#define CMAES_MAX_LAMBDA  256      // Maximum population (the restarts of IPOP double it)
+
+/* Restart strategies */
+#define CMAES_NONE        0        // No CMA-ES (PSO)
+#define CMAES_IPOP        1        // Population doubled at each restart
+#define CMAES_BIPOP       2        // Alternate the doubled population and small populations with a smaller step
+
+/* Stop criteria (cmaes_stop()) */
+#define CMAES_TOLX        1        // Step below 1e-12 of the initial one in every direction
+#define CMAES_TOLFUN      2        // Range of the fitness of the last generations below 1e-12
+#define CMAES_CONDITION   3        // Condition of the covariance above 1e14
+
+/// Covariance matrix adaptation evolution strategy (maximization), ask/tell interface
+typedef struct
+{
+  int dim, lambda, mu;
+  double weights[CMAES_MAX_LAMBDA];      // Recombination weights of the mu best
+  double mueff, cc, cs, c1, cmu, damps, chin;
+
+  double sigma, sigma0;       // Step size, initial step size
+  double mean[CMAES_MAX_DIM];
+  double pc[CMAES_MAX_DIM], ps[CMAES_MAX_DIM];           // Evolution paths
+  double C[CMAES_MAX_DIM][CMAES_MAX_DIM];                // Covariance
+  double B[CMAES_MAX_DIM][CMAES_MAX_DIM];                // Eigenvectors of C (columns)
+  double D[CMAES_MAX_DIM];                               // Square roots of the eigenvalues of C
+  double x[CMAES_MAX_LAMBDA][CMAES_MAX_DIM];             // Candidates of the generation (may be repaired before cmaes_tell())
+  int generation;
+  double history[CMAES_MAX_LAMBDA];      // Best fitness of the last generations (TOLFUN)
+  int n_history;
+  rng_t rng;
+} cmaes_t;
+
+/// Documentation in c file
+void cmaes_init(cmaes_t *es, int dim, int lambda, const double *mean, double sigma, const double *scale, uint64_t seed);
+void cmaes_ask(cmaes_t *es);
+void cmaes_tell(cmaes_t *es, const double *fit);
+int cmaes_stop(const cmaes_t *es);
+int cmaes_default_lambda(int dim);
+
+#endif
@@ -0,0 +1,214 @@
+/*****************************************************************************/
+/* File:         fitness_cache.c                                             */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Cache of the noisy fitness of the PSO particles, keyed on   */
+/*               the particle quantized to cells of a given size             */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "fitness_cache.h"
+#include "checkpoint.h"
+
+/* Two particles in the same cell (same round(particle/quantum) in every dimension) are taken as
+   the same controller: the samples of their fitness go to the same entry, whatever the iteration
+   or the run. The table is an open addressing hash table of fixed size (linear probing), so that
+   it can be saved and loaded as one block with checkpoint_save().
+
+   Once FCACHE_MAX_LOAD of the table is used, a new cell takes the place of the least recently
+   used one, removed with a backward shift of the cells after it (no tombstones), so that the
+   cache keeps learning around the current swarm; an entry returned by fcache_find() is thus only
+   valid until the next fcache_find() that creates a cell. The file is tagged with the dimension
+   and the signature of the fitness (the build of the supervisor and its world), so that the
+   samples of another fitness function are never taken. */
+
+static void quantize(const fcache_t *cache, const double *particle, int32_t *key) {
+    int i;
+    for (i = 0; i < cache->dim; i++)
+        key[i] = (int32_t)floor(particle[i] / cache->quantum + 0.5);
+}
+
+static uint32_t fnv1a(uint32_t h, const void *data, size_t size) {
+    const unsigned char *p = data;
+    size_t i;
+    for (i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t hash(const int32_t *key, int dim) {
+    uint32_t h = 2166136261u;
+    int i;
+    for (i = 0; i < dim; i++) {
+        h ^= (uint32_t)key[i];
+        h *= 16777619u;
+        h ^= h >> 15;
+    }
+    return h;
+}
+
+/* Tag of the cache file: its dimension and the signature of the fitness */
+static uint32_t tag(const fcache_t *cache) {
+    return fnv1a(cache->signature, &cache->dim, sizeof(cache->dim));
+}
+
+/* Remove the entry i, the entries after it that it displaced move back (linear probing) */
+static void erase(fcache_t *cache, uint32_t i) {
+    uint32_t j = i, home;
+
+    for (;;) {
+        j = (j + 1) & (FCACHE_CAPACITY - 1);
+        if (!cache->entries[j].used)
+            break;
+        home = hash(cache->entries[j].key, cache->dim) & (FCACHE_CAPACITY - 1);
+        if (((j - home) & (FCACHE_CAPACITY - 1)) >= ((j - i) & (FCACHE_CAPACITY - 1))) {
+            cache->entries[i] = cache->entries[j];  // Its probe from home still reaches i
+            i = j;
+        }
+    }
+    memset(&cache->entries[i], 0, sizeof(cache->entries[i]));
+    cache->count--;
+}
+
+/* Remove the least recently used entry */
+static void evict(fcache_t *cache) {
+    uint32_t i, oldest = 0, age, max_age = 0;
+
+    for (i = 0; i < FCACHE_CAPACITY; i++) {
+        age = cache->clock - cache->entries[i].stamp;
+        if (cache->entries[i].used && age >= max_age) {
+            max_age = age;
+            oldest = i;
+        }
+    }
+    erase(cache, oldest);
+    cache->evicted++;
+}
+
+/**
+ * @brief      Signature of a fitness function, whose samples a cache holds
+ *
+ * @param[in]  text  The version of the fitness (e.g. the build of the supervisor)
+ * @param[in]  path  A file the fitness depends on (e.g. the world, NULL: none)
+ *
+ * @return     A hash of the text and of the content of the file
+ */
+uint32_t fcache_signature(const char *text, const char *path) {
+    unsigned char buffer[4096];
+    uint32_t h = fnv1a(2166136261u, text, strlen(text));
+    size_t n;
+    FILE *fp;
+
+    fp = path != NULL ? fopen(path, "rb") : NULL;
+    if (fp == NULL)
+        return h;
+    while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+        h = fnv1a(h, buffer, n);
+    fclose(fp);
+    return h;
+}
+
+/**
+ * @brief      Initialize an empty cache
+ *
+ * @param      cache      The cache
+ * @param[in]  dim        The dimension of the particles (at most FCACHE_MAX_DIM)
+ * @param[in]  quantum    The size of a cell in each dimension
+ * @param[in]  signature  The fitness function (fcache_signature()), a file of another one is not loaded
+ */
+void fcache_init(fcache_t *cache, int dim, double quantum, uint32_t signature) {
+    memset(cache, 0, sizeof(*cache));
+    cache->dim = dim < FCACHE_MAX_DIM ? dim : FCACHE_MAX_DIM;
+    cache->quantum = quantum;
+    cache->signature = signature;
+}
+
+/**
+ * @brief      Load the cache saved by a previous run, with the dimension, signature and quantum of the cache
+ *
+ * @param      cache  The cache, initialized with fcache_init() (unchanged on failure)
+ * @param[in]  path   The cache file
+ *
+ * @return     1 if there is no cache of this dimension, fitness and quantum
+ */
+int fcache_load(fcache_t *cache, const char *path) {
+    static fcache_t loaded;
+
+    if (checkpoint_load(path, &loaded, sizeof(loaded), tag(cache)))
+        return 1;  // Other dimension or fitness function
+    if (loaded.dim != cache->dim || loaded.signature != cache->signature || loaded.quantum != cache->quantum) {
+        printf("Ignoring the fitness cache %s (quantum %g instead of %g)\n", path, loaded.quantum,
+               cache->quantum);
+        return 1;
+    }
+    memcpy(cache, &loaded, sizeof(loaded));
+    printf("Loaded %d cells from the fitness cache %s\n", cache->count, path);
+    return 0;
+}
+
+/**
+ * @brief      Save the cache atomically
+ *
+ * @return     1 on failure
+ */
+int fcache_save(const fcache_t *cache, const char *path) {
+    return checkpoint_save(path, cache, sizeof(*cache), tag(cache));
+}
+
+/**
+ * @brief      Find the entry of the cell of a particle
+ *
+ * @param      cache     The cache
+ * @param[in]  particle  The particle (dim values)
+ * @param[in]  create    Add an entry without samples if the cell has none, in the place of the least
+ *                       recently used one if the cache is full (the entries found before may move)
+ *
+ * @return     The entry, or NULL if there is none
+ */
+fcache_entry_t *fcache_find(fcache_t *cache, const double *particle, int create) {
+    int32_t key[FCACHE_MAX_DIM];
+    uint32_t i;
+    fcache_entry_t *e;
+
+    quantize(cache, particle, key);
+    cache->clock++;
+    for (;;) {
+        i = hash(key, cache->dim) & (FCACHE_CAPACITY - 1);
+        for (;;) {
+            e = &cache->entries[i];
+            if (!e->used)
+                break;
+            if (memcmp(e->key, key, cache->dim * sizeof(int32_t)) == 0) {
+                e->stamp = cache->clock;
+                return e;
+            }
+            i = (i + 1) & (FCACHE_CAPACITY - 1);
+        }
+        if (!create)
+            return NULL;
+        if (cache->count + 1 <= FCACHE_MAX_LOAD * FCACHE_CAPACITY)
+            break;
+        evict(cache);  // The free entry of the key may have moved
+    }
+    e->used = 1;
+    e->stamp = cache->clock;
+    memcpy(e->key, key, cache->dim * sizeof(int32_t));
+    cache->count++;
+    return e;
+}
+
+/**
+ * @brief      Add a sample of the fitness to an entry (Welford)
+ */
+void fcache_add(fcache_entry_t *entry, double value) {
+    double delta = value - entry->mean;
+    entry->n += 1;
+    entry->mean += delta / entry->n;
+    entry->m2 += delta * (value - entry->mean);
+}
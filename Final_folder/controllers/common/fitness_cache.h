@@ -0,0 +1,40 @@
+#ifndef FITNESS_CACHE_H
+#define FITNESS_CACHE_H
+
+#include <stdint.h>
+
+#define FCACHE_CAPACITY  4096     // Number of entries of the table (power of 2)
+#define FCACHE_MAX_DIM   32       // Maximum dimension of a particle (DATASIZE)
+#define FCACHE_MAX_LOAD  0.75     // Fill ratio beyond which the least recently used cell makes room for a new one
+
+/// Statistics of the fitness of one cell of the quantized search space
+typedef struct
+{
+  int32_t used;                 // 0: free entry
+  uint32_t stamp;               // Clock of the cache at the last use of the cell
+  int32_t key[FCACHE_MAX_DIM];  // round(particle/quantum)
+  double n;                     // Number of samples
+  double mean;
+  double m2;                    // Sum of the squared deviations to the mean (Welford)
+} fcache_entry_t;
+
+typedef struct
+{
+  int dim;
+  double quantum;               // Size of a cell in each dimension
+  uint32_t signature;           // Fitness function whose samples the cache holds (see fcache_signature())
+  uint32_t clock;               // Uses of the cells so far
+  int count;                    // Number of used entries
+  int evicted;                  // Cells dropped to make room for new ones
+  fcache_entry_t entries[FCACHE_CAPACITY];
+} fcache_t;
+
+/// Documentation in c file
+uint32_t fcache_signature(const char *text, const char *path);
+void fcache_init(fcache_t *cache, int dim, double quantum, uint32_t signature);
+int fcache_load(fcache_t *cache, const char *path);
+int fcache_save(const fcache_t *cache, const char *path);
+fcache_entry_t *fcache_find(fcache_t *cache, const double *particle, int create);
+void fcache_add(fcache_entry_t *entry, double value);
+
+#endif
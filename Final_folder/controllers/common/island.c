@@ -0,0 +1,223 @@
+/*****************************************************************************/
+/* File:         island.c                                                    */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Island model of the PSO: independent swarms in separate     */
+/*               supervisors exchange their best particles                   */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "island.h"
+
+/* Each island is the supervisor of its own Webots instance (with its own pool of workers if
+   any), running a whole swarm with its own seed. Every cfg.migration_interval iterations it
+   sends its best particle to the next island (ring) or to all of them (full) and takes the
+   migrants received since the last migration. The messages are datagrams on Unix sockets,
+   one per island: an island never waits for another one, a send to an island that is not
+   started yet or died is simply lost, and a lost island does not stop the others. */
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static int socket_path(const island_t *is, int id, struct sockaddr_un *addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    return snprintf(addr->sun_path, sizeof(addr->sun_path), "%s.%d.sock", is->prefix, id) >= (int)sizeof(addr->sun_path);
+}
+
+/**
+ * @brief      Open the island according to the environment: PSO_ISLAND ("i/n": island i of n, no island
+ *             if unset) and PSO_ISLAND_SOCKET (prefix of the socket paths, ISLAND_SOCKET by default)
+ *
+ * @param      is        The island
+ * @param[in]  topology  The migration topology (ISLAND_RING or ISLAND_FULL)
+ *
+ * @return     1 if PSO_ISLAND is set but the socket cannot be opened
+ */
+int island_open(island_t *is, int topology) {
+    const char *env = getenv("PSO_ISLAND");
+    const char *prefix = getenv("PSO_ISLAND_SOCKET");
+    struct sockaddr_un addr;
+
+    memset(is, 0, sizeof(*is));
+    is->fd = -1;
+    is->topology = topology;
+    if (env == NULL || env[0] == '\0')
+        return 0;
+    if (sscanf(env, "%d/%d", &is->id, &is->n_islands) != 2 || is->n_islands < 1 || is->n_islands > ISLAND_MAX ||
+        is->id < 0 || is->id >= is->n_islands) {
+        printf("Island: PSO_ISLAND must be i/n with 0 <= i < n <= %d, not %s\n", ISLAND_MAX, env);
+        is->n_islands = 0;
+        return 1;
+    }
+
+    if (prefix == NULL || prefix[0] == '\0')
+        prefix = ISLAND_SOCKET;
+    if (strlen(prefix) >= sizeof(is->prefix) || socket_path(is, is->id, &addr)) {
+        printf("Island: socket prefix too long %s\n", prefix);
+        is->n_islands = 0;
+        return 1;
+    }
+    strcpy(is->prefix, prefix);
+    socket_path(is, is->id, &addr);
+
+    is->fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    unlink(addr.sun_path);
+    if (is->fd < 0 || bind(is->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        printf("Island: cannot bind %s\n", addr.sun_path);
+        island_close(is);
+        return 1;
+    }
+    printf("Island %d of %d on %s (%s migration)\n", is->id, is->n_islands, addr.sun_path,
+           topology == ISLAND_FULL ? "full" : "ring");
+    return 0;
+}
+
+/**
+ * @brief      Whether the swarm is an island of more than one
+ */
+int island_active(const island_t *is) {
+    return is != NULL && is->fd >= 0 && is->n_islands > 1;
+}
+
+/**
+ * @brief      Send a particle to the next islands of the topology
+ *
+ * @param      is    The island
+ * @param[in]  x     The particle
+ * @param[in]  dim   The number of elements (at most ISLAND_MAX_DIM)
+ * @param[in]  perf  Its performance
+ *
+ * @return     The number of islands reached (the others are not started or lost)
+ */
+int island_send(island_t *is, const double *x, int dim, double perf) {
+    char buf[sizeof(island_msg_t) + ISLAND_MAX_DIM * sizeof(double)];
+    island_msg_t msg = {ISLAND_MIGRANT, is->id, dim, 0, perf};
+    struct sockaddr_un addr;
+    int i, to, n_sent = 0;
+
+    if (!island_active(is) || dim > ISLAND_MAX_DIM)
+        return 0;
+    memcpy(buf, &msg, sizeof(msg));
+    memcpy(buf + sizeof(msg), x, dim * sizeof(double));
+    for (i = 1; i < is->n_islands; i++) {
+        to = (is->id + i) % is->n_islands;
+        socket_path(is, to, &addr);
+        if (sendto(is->fd, buf, sizeof(msg) + dim * sizeof(double), MSG_DONTWAIT,
+                   (struct sockaddr *)&addr, sizeof(addr)) >= 0)
+            n_sent++;
+        if (is->topology == ISLAND_RING)
+            break;
+    }
+    is->sent += n_sent;
+    return n_sent;
+}
+
+/**
+ * @brief      Take the next migrant received, without waiting
+ *
+ * @param      is    The island
+ * @param[out] x     The particle (dim elements)
+ * @param[in]  dim   The number of elements
+ * @param[out] perf  Its performance on its island
+ *
+ * @return     1 if a migrant was received, 0 if there is none left
+ */
+int island_receive(island_t *is, double *x, int dim, double *perf) {
+    char buf[sizeof(island_msg_t) + ISLAND_MAX_DIM * sizeof(double)];
+    island_msg_t msg;
+    ssize_t r;
+
+    if (!island_active(is))
+        return 0;
+    while ((r = recv(is->fd, buf, sizeof(buf), MSG_DONTWAIT)) >= 0 || errno == EINTR) {
+        if (r < (ssize_t)sizeof(msg))
+            continue;
+        memcpy(&msg, buf, sizeof(msg));
+        if (msg.type != ISLAND_MIGRANT || msg.dim != dim || r != (ssize_t)(sizeof(msg) + dim * sizeof(double)))
+            continue;  // Another swarm on the same sockets
+        memcpy(x, buf + sizeof(msg), dim * sizeof(double));
+        *perf = msg.perf;
+        is->received++;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief      Close the socket of the island
+ */
+void island_close(island_t *is) {
+    struct sockaddr_un addr;
+
+    if (is->fd >= 0) {
+        close(is->fd);
+        socket_path(is, is->id, &addr);
+        unlink(addr.sun_path);
+        printf("Island %d: %d migrants sent, %d received\n", is->id, is->sent, is->received);
+    }
+    is->fd = -1;
+}
+
+#else
+
+/* No Unix sockets: the swarm runs alone */
+
+int island_open(island_t *is, int topology) {
+    memset(is, 0, sizeof(*is));
+    is->fd = -1;
+    is->topology = topology;
+    if (getenv("PSO_ISLAND") != NULL)
+        printf("Island: not available on Windows\n");
+    return 0;
+}
+
+int island_active(const island_t *is) {
+    (void)is;
+    return 0;
+}
+
+int island_send(island_t *is, const double *x, int dim, double perf) {
+    (void)is; (void)x; (void)dim; (void)perf;
+    return 0;
+}
+
+int island_receive(island_t *is, double *x, int dim, double *perf) {
+    (void)is; (void)x; (void)dim; (void)perf;
+    return 0;
+}
+
+void island_close(island_t *is) {
+    (void)is;
+}
+
+#endif
+
+/**
+ * @brief      File of the island, <path>.<island> in an island model (the islands of a world share its
+ *             directory), else path
+ *
+ * @param[in]  is    The island
+ * @param[in]  path  The file (NULL: none)
+ * @param[out] file  The file of the island
+ * @param[in]  size  The size of file [bytes]
+ *
+ * @return     file, NULL if path is NULL
+ */
+char *island_file(const island_t *is, const char *path, char *file, int size) {
+    if (path == NULL)
+        return NULL;
+    if (island_active(is))
+        snprintf(file, size, "%s.%d", path, is->id);
+    else
+        snprintf(file, size, "%s", path);
+    return file;
+}
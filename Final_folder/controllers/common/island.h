@@ -0,0 +1,44 @@
+#ifndef ISLAND_H
+#define ISLAND_H
+
+#include <stdint.h>
+
+#define ISLAND_SOCKET    "/tmp/dis_pso_island"  // Default prefix of the sockets, island i binds <prefix>.<i>.sock (PSO_ISLAND_SOCKET)
+#define ISLAND_MAX       64                     // Maximum number of islands
+#define ISLAND_MAX_DIM   64                     // Maximum number of elements of a migrant
+
+/* Migration topologies */
+#define ISLAND_RING      0    // Island i sends its best to island i+1
+#define ISLAND_FULL      1    // Every island sends its best to all the others
+
+/* Message types */
+#define ISLAND_MIGRANT   1    // Best particle of an island, followed by dim doubles
+
+typedef struct
+{
+  uint32_t type;
+  int32_t from;           // Island of the particle
+  int32_t dim;            // Number of doubles of the particle
+  int32_t reserved;
+  double perf;            // Performance of the particle on its island
+} island_msg_t;
+
+typedef struct
+{
+  int id;                 // Island of this process
+  int n_islands;          // 0: not an island
+  int topology;           // ISLAND_RING or ISLAND_FULL
+  char prefix[80];        // Prefix of the socket paths
+  int fd;                 // Datagram socket of this island
+  int sent, received;     // Migrants so far
+} island_t;
+
+/// Documentation in c file
+int island_open(island_t *is, int topology);
+int island_active(const island_t *is);
+int island_send(island_t *is, const double *x, int dim, double perf);
+int island_receive(island_t *is, double *x, int dim, double *perf);
+void island_close(island_t *is);
+char *island_file(const island_t *is, const char *path, char *file, int size);
+
+#endif
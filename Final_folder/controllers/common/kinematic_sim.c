@@ -0,0 +1,526 @@
+/*****************************************************************************/
+/* File:         kinematic_sim.c                                             */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Webots-free simulation of the e-pucks of the pso worlds:    */
+/*               differential drive kinematics, infrared ray casts, range    */
+/*               and bearing of the pings, and the simplified controllers    */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "kinematic_sim.h"
+
+/* The plane is (x, y = -z of Webots) so that the headings are counterclockwise as in the
+   odometry of the controllers. There is no dynamics: the wheels reach their speed at once and
+   a robot touching a wall or another robot is pushed out of it. It is good enough to rank the
+   weights of the PSO much faster than real time, the best ones are then confirmed in Webots. */
+
+#define MIN_SENS             350     // Minimum sensibility value (controllers)
+#define MAX_SENS             4096    // Maximum sensibility value (controllers)
+#define MAX_DIFF             (2*KSIM_MAX_SPEED)
+#define AVOIDANCE_THRESHOLD  2100    // Threshold of avoidance mode
+#define FOLLOW_THRESHOLD     1300    // Follow wall threshold
+#define TARGET_FLOCKING_DISTANCE (0.035*4)  // Targeted flocking distance of pso_simplified_sup_flock
+#define N_TABLE              9
+
+/* Infrared sensors of the e-puck (DistanceSensor of the worlds): position (forward, left) in
+   the frame of the robot, direction (counterclockwise from the front) and lookup table */
+static const double sensor_pos[KSIM_NB_SENSORS][2] = {{0.03, -0.01}, {0.022, -0.025}, {0, -0.031}, {-0.03, -0.015},
+                                                      {-0.03, 0.015}, {0, 0.031}, {0.022, 0.025}, {0.03, 0.01}};
+static const double sensor_dir[KSIM_NB_SENSORS] = {-0.30, -0.80, -M_PI/2, -2.64, 2.64, M_PI/2, 0.80, 0.30};
+static const double lookup[N_TABLE][3] = {{0, 4095, 0.005}, {0.005, 3474, 0.037}, {0.01, 2211, 0.071},
+                                          {0.02, 676, 0.105}, {0.03, 306, 0.125}, {0.04, 164, 0.206},
+                                          {0.05, 90, 0.269}, {0.06, 56, 0.438}, {0.07, 34, 0.704}};
+
+static double rnd_uniform(ksim_world_t *w) {
+    // xorshift32
+    w->rng ^= w->rng << 13;
+    w->rng ^= w->rng >> 17;
+    w->rng ^= w->rng << 5;
+    return (w->rng + 0.5) / 4294967296.0;
+}
+
+static double rnd_gauss(ksim_world_t *w) {
+    return sqrt(-2.0*log(rnd_uniform(w))) * cos(2.0*M_PI*rnd_uniform(w));
+}
+
+/**
+ * @brief      Initialize an empty world
+ *
+ * @param      w      The world
+ * @param[in]  seed   Seed of the noise
+ * @param[in]  noise  Add the noise of the lookup tables to the infrared sensors
+ */
+void ksim_init(ksim_world_t *w, uint32_t seed, int noise) {
+    memset(w, 0, sizeof(*w));
+    w->noise = noise;
+    w->rng = seed ? seed : 0x9e3779b9;
+}
+
+/**
+ * @brief      Add a wall or an obstacle (box bounding object of a Solid)
+ *
+ * @param      w       The world
+ * @param[in]  x       Translation x of the Solid
+ * @param[in]  z       Translation z of the Solid
+ * @param[in]  size_x  Size of the box along x
+ * @param[in]  size_z  Size of the box along z
+ * @param[in]  angle   Rotation around the y-axis (angle of a rotation 0 1 0 angle)
+ *
+ * @return     1 if there are too many boxes
+ */
+int ksim_add_box(ksim_world_t *w, double x, double z, double size_x, double size_z, double angle) {
+    if (w->n_boxes == KSIM_MAX_BOXES)
+        return 1;
+    ksim_box_t *b = &w->boxes[w->n_boxes++];
+    b->x = x;
+    b->y = -z;
+    b->half_x = size_x/2;
+    b->half_y = size_z/2;
+    b->cos_a = cos(angle);
+    b->sin_a = sin(angle);
+    return 0;
+}
+
+/**
+ * @brief      Add a robot
+ *
+ * @param      w        The world
+ * @param[in]  x        Translation x of the robot
+ * @param[in]  z        Translation z of the robot
+ * @param[in]  heading  Heading counterclockwise from the x-axis (0 for the rotation 0 -1 0 1.5708 of init_pos())
+ *
+ * @return     The index of the robot or -1 if there are too many robots
+ */
+int ksim_add_robot(ksim_world_t *w, double x, double z, double heading) {
+    if (w->n_robots == KSIM_MAX_ROBOTS)
+        return -1;
+    ksim_robot_t *r = &w->robots[w->n_robots];
+    memset(r, 0, sizeof(*r));
+    r->x = x;
+    r->y = -z;
+    r->heading = heading;
+    return w->n_robots++;
+}
+
+/* Distance along the ray (ox, oy) + t (dx, dy) to the box, or INFINITY */
+static double ray_box(const ksim_box_t *b, double ox, double oy, double dx, double dy) {
+    double lx = (ox - b->x)*b->cos_a + (oy - b->y)*b->sin_a;
+    double ly = -(ox - b->x)*b->sin_a + (oy - b->y)*b->cos_a;
+    double ldx = dx*b->cos_a + dy*b->sin_a;
+    double ldy = -dx*b->sin_a + dy*b->cos_a;
+    double t_min = 0, t_max = INFINITY;
+    double o[2] = {lx, ly}, d[2] = {ldx, ldy}, h[2] = {b->half_x, b->half_y};
+    int k;
+
+    for (k = 0; k < 2; k++) {
+        if (fabs(d[k]) < 1e-12) {
+            if (fabs(o[k]) > h[k])
+                return INFINITY;
+            continue;
+        }
+        double t1 = (-h[k] - o[k])/d[k];
+        double t2 = (h[k] - o[k])/d[k];
+        if (t1 > t2) {
+            double tmp = t1;
+            t1 = t2;
+            t2 = tmp;
+        }
+        t_min = fmax(t_min, t1);
+        t_max = fmin(t_max, t2);
+        if (t_min > t_max)
+            return INFINITY;
+    }
+    return t_min;
+}
+
+/* Distance along the ray to the body of a robot, or INFINITY */
+static double ray_robot(const ksim_robot_t *r, double ox, double oy, double dx, double dy) {
+    double px = ox - r->x, py = oy - r->y;
+    double b = px*dx + py*dy;
+    double c = px*px + py*py - KSIM_ROBOT_RADIUS*KSIM_ROBOT_RADIUS;
+    double disc = b*b - c;
+    if (disc < 0)
+        return INFINITY;
+    double t = -b - sqrt(disc);
+    if (t < 0)
+        t = -b + sqrt(disc);
+    return t < 0 ? INFINITY : t;
+}
+
+static double sensor_value(ksim_world_t *w, double distance) {
+    int k;
+    double value, noise;
+
+    if (distance >= lookup[N_TABLE-1][0]) {
+        value = lookup[N_TABLE-1][1];
+        noise = lookup[N_TABLE-1][2];
+    }
+    else {
+        for (k = 1; k < N_TABLE-1 && distance > lookup[k][0]; k++)
+            ;
+        double a = (distance - lookup[k-1][0])/(lookup[k][0] - lookup[k-1][0]);
+        value = lookup[k-1][1] + a*(lookup[k][1] - lookup[k-1][1]);
+        noise = lookup[k-1][2] + a*(lookup[k][2] - lookup[k-1][2]);
+    }
+    if (w->noise)
+        value += value*noise*rnd_gauss(w);
+    return value < 0 ? 0 : value;
+}
+
+/**
+ * @brief      Compute the infrared sensor values of all robots (ray casts against the boxes and the other robots)
+ */
+void ksim_sense(ksim_world_t *w) {
+    int i, s, k;
+
+    for (i = 0; i < w->n_robots; i++) {
+        ksim_robot_t *r = &w->robots[i];
+        double c = cos(r->heading), sn = sin(r->heading);
+        for (s = 0; s < KSIM_NB_SENSORS; s++) {
+            double ox = r->x + sensor_pos[s][0]*c - sensor_pos[s][1]*sn;
+            double oy = r->y + sensor_pos[s][0]*sn + sensor_pos[s][1]*c;
+            double dx = cos(r->heading + sensor_dir[s]);
+            double dy = sin(r->heading + sensor_dir[s]);
+            double d = INFINITY;
+            for (k = 0; k < w->n_boxes; k++)
+                d = fmin(d, ray_box(&w->boxes[k], ox, oy, dx, dy));
+            for (k = 0; k < w->n_robots; k++)
+                if (k != i)
+                    d = fmin(d, ray_robot(&w->robots[k], ox, oy, dx, dy));
+            r->ds[s] = (int)sensor_value(w, d);  // The controllers read the values in an int
+        }
+    }
+}
+
+/**
+ * @brief      Range and bearing of robot k measured by robot i (emitter/receiver of the pings)
+ *
+ * @param[out] range    Distance between the centers [m]
+ * @param[out] bearing  Direction of k counterclockwise from the front of i [rad]
+ */
+void ksim_range_bearing(const ksim_world_t *w, int i, int k, double *range, double *bearing) {
+    const ksim_robot_t *a = &w->robots[i], *b = &w->robots[k];
+    *range = sqrt(pow(b->x - a->x, 2) + pow(b->y - a->y, 2));
+    *bearing = atan2(b->y - a->y, b->x - a->x) - a->heading;
+}
+
+/* Push a robot out of a box */
+static void collide_box(ksim_robot_t *r, const ksim_box_t *b) {
+    double lx = (r->x - b->x)*b->cos_a + (r->y - b->y)*b->sin_a;
+    double ly = -(r->x - b->x)*b->sin_a + (r->y - b->y)*b->cos_a;
+    double cx = fmax(-b->half_x, fmin(b->half_x, lx));
+    double cy = fmax(-b->half_y, fmin(b->half_y, ly));
+    double nx = lx - cx, ny = ly - cy;
+    double d = sqrt(nx*nx + ny*ny);
+
+    if (d >= KSIM_ROBOT_RADIUS)
+        return;
+    if (d > 1e-9) {
+        lx = cx + nx/d*KSIM_ROBOT_RADIUS;
+        ly = cy + ny/d*KSIM_ROBOT_RADIUS;
+    }
+    else if (b->half_x - fabs(lx) < b->half_y - fabs(ly))  // Center inside the box: leave by the closest side
+        lx = (lx < 0 ? -1 : 1)*(b->half_x + KSIM_ROBOT_RADIUS);
+    else
+        ly = (ly < 0 ? -1 : 1)*(b->half_y + KSIM_ROBOT_RADIUS);
+    r->x = b->x + lx*b->cos_a - ly*b->sin_a;
+    r->y = b->y + lx*b->sin_a + ly*b->cos_a;
+}
+
+/**
+ * @brief      Move the robots during dt with their wheel speeds, then solve the contacts
+ */
+void ksim_step(ksim_world_t *w, double dt) {
+    int i, k;
+
+    for (i = 0; i < w->n_robots; i++) {
+        ksim_robot_t *r = &w->robots[i];
+        double v = KSIM_WHEEL_RADIUS*(r->left + r->right)/2;
+        double omega = KSIM_WHEEL_RADIUS*(r->right - r->left)/KSIM_AXLE_LENGTH;
+        r->x += v*dt*cos(r->heading + omega*dt/2);
+        r->y += v*dt*sin(r->heading + omega*dt/2);
+        r->heading += omega*dt;
+    }
+
+    for (i = 0; i < w->n_robots; i++) {
+        for (k = i+1; k < w->n_robots; k++) {
+            ksim_robot_t *a = &w->robots[i], *b = &w->robots[k];
+            double dx = b->x - a->x, dy = b->y - a->y;
+            double d = sqrt(dx*dx + dy*dy);
+            if (d >= 2*KSIM_ROBOT_RADIUS || d < 1e-9)
+                continue;
+            double push = (2*KSIM_ROBOT_RADIUS - d)/2/d;
+            a->x -= dx*push;
+            a->y -= dy*push;
+            b->x += dx*push;
+            b->y += dy*push;
+        }
+    }
+    for (i = 0; i < w->n_robots; i++)
+        for (k = 0; k < w->n_boxes; k++)
+            collide_box(&w->robots[i], &w->boxes[k]);
+
+    w->time += dt;
+}
+
+static void limit(int *number, int limit) {
+    if (*number > limit)
+        *number = limit;
+    if (*number < -limit)
+        *number = -limit;
+}
+
+/* float -> int of the wheel speeds without overflow (the float can be huge with Reynolds' rule 2) */
+static int to_speed(float value) {
+    if (!(value > -KSIM_MAX_SPEED))
+        return -KSIM_MAX_SPEED;
+    if (value > KSIM_MAX_SPEED)
+        return KSIM_MAX_SPEED;
+    return (int)value;
+}
+
+/* State of a controller, as the globals of the robot controllers */
+typedef struct
+{
+  float relative_pos[KSIM_MAX_ROBOTS][2];
+  float my_position[3];
+  float prev_my_position[3];
+  float speed[2];
+  double origin_y;            // y of the robot at the start (origin of its odometry)
+  int msl, msr;
+  int avoidance, side;
+  double fit_speed, fit_diff;
+  double sens_val[KSIM_NB_SENSORS];
+} controller_state_t;
+
+/* Reynolds' rules and wheel speeds, copied from reynolds_rules() and compute_wheel_speeds() of pso_simplified_robot_flock.c */
+static void reynolds(const ksim_controller_t *c, controller_state_t *st, int me, int n) {
+    float rel_avg_loc[2] = {0, 0};
+    float cohesion[2] = {0, 0};
+    float dispersion[2] = {0, 0};
+    int j, k;
+
+    for (k = 0; k < n; k++) {
+        if (k == me)
+            continue;
+        for (j = 0; j < 2; j++)
+            rel_avg_loc[j] += st->relative_pos[k][j];
+    }
+    for (j = 0; j < 2; j++)
+        rel_avg_loc[j] /= n-1;
+
+    for (j = 0; j < 2; j++)
+        if (sqrt(pow(rel_avg_loc[0], 2) + pow(rel_avg_loc[1], 2)) > (float)c->rule1_threshold)
+            cohesion[j] = rel_avg_loc[j];
+    for (k = 0; k < n; k++) {
+        if (k == me)
+            continue;
+        if (sqrt(pow(st->relative_pos[k][0], 2) + pow(st->relative_pos[k][1], 2)) < (float)c->rule2_threshold)
+            for (j = 0; j < 2; j++)
+                dispersion[j] -= 1/(st->relative_pos[k][j]);
+    }
+
+    for (j = 0; j < 2; j++)
+        st->speed[j] = cohesion[j]*(float)c->rule1_weight + dispersion[j]*(float)c->rule2_weight;
+    st->speed[1] *= -1;
+    st->speed[0] += (c->migr[0] - st->my_position[0])*(float)c->migration_weight;
+    st->speed[1] -= (c->migr[1] - st->my_position[1])*(float)c->migration_weight;
+
+    float h = st->my_position[2];
+    float x = st->speed[0]*cosf(h) + st->speed[1]*sinf(h);
+    float z = -st->speed[0]*sinf(h) + st->speed[1]*cosf(h);
+    float range = sqrtf(x*x + z*z);
+    float bearing = -atan2(x, z);
+    float u = 0.2*range*cosf(bearing);
+    float w = 0.5*bearing;
+    st->msl = to_speed((u - KSIM_AXLE_LENGTH*w/2.0)*(1000.0/KSIM_WHEEL_RADIUS));
+    st->msr = to_speed((u + KSIM_AXLE_LENGTH*w/2.0)*(1000.0/KSIM_WHEEL_RADIUS));
+}
+
+/* One control step of a robot, copied from simulation_webot() of the pso_simplified robot controllers */
+static void control(ksim_world_t *w, const ksim_controller_t *c, controller_state_t *st, int me,
+                    const double sent[][3]) {
+    const ksim_robot_t *r = &w->robots[me];
+    const int *ds = r->ds;
+    int bmsl = 0, bmsr = 0, max_sens = 0;
+    double priority = 2;
+    int i, k;
+
+    // Braitenberg
+    for (i = 0; i < KSIM_NB_SENSORS; i++) {
+        max_sens = max_sens > ds[i] ? max_sens : ds[i];
+        bmsr += c->braitenberg_right[i]*ds[i];
+        bmsl += c->braitenberg_left[i]*ds[i];
+    }
+    bmsl /= MIN_SENS; bmsr /= MIN_SENS;
+    bmsl += 66; bmsr += 72;
+
+    // Odometry (exact) in the frame of the robot
+    for (i = 0; i < 3; i++)
+        st->prev_my_position[i] = st->my_position[i];
+    st->my_position[0] = r->x;
+    st->my_position[1] = r->y - st->origin_y;
+    st->my_position[2] = fmod(fmod(r->heading, 2*M_PI) + 2*M_PI, 2*M_PI);
+
+    // Pings of the previous step, same computation as process_received_ping_messages()
+    for (k = 0; k < w->n_robots; k++) {
+        if (k == me)
+            continue;
+        double range = sqrt(pow(sent[k][0] - r->x, 2) + pow(sent[k][1] - r->y, 2));
+        double theta = M_PI/2 + atan2(sent[k][1] - r->y, sent[k][0] - r->x) - r->heading + st->my_position[2];
+        st->relative_pos[k][0] = range*cos(theta);
+        st->relative_pos[k][1] = -1.0*range*sin(theta);
+    }
+
+    if (c->reynolds)
+        reynolds(c, st, me, w->n_robots);
+    else {
+        st->msl = 200;
+        st->msr = 200;
+    }
+
+    // Avoidance state machine
+    if ((ds[0] > AVOIDANCE_THRESHOLD || ds[7] > AVOIDANCE_THRESHOLD) && !st->avoidance) {
+        st->avoidance = 1;
+        st->side = !(ds[7] < ds[0]);
+    }
+    else if ((ds[6] > AVOIDANCE_THRESHOLD || ds[1] > AVOIDANCE_THRESHOLD) && !st->avoidance) {
+        st->avoidance = 1;
+        st->side = !(ds[6] < ds[1]);
+    }
+    else if ((ds[5] > AVOIDANCE_THRESHOLD || ds[2] > AVOIDANCE_THRESHOLD) && !st->avoidance) {
+        st->avoidance = 1;
+        st->side = !(ds[5] < ds[2]);
+    }
+    if (!st->avoidance) {
+        st->msl -= st->msl*max_sens/(priority*MAX_SENS);
+        st->msr -= st->msr*max_sens/(priority*MAX_SENS);
+    }
+    else if (st->side) {
+        st->msl = ds[7] > FOLLOW_THRESHOLD ? 140 : 100;
+        st->msr = 150;
+    }
+    else {
+        st->msl = 150;
+        st->msr = ds[0] > FOLLOW_THRESHOLD ? 140 : 100;
+    }
+    if (st->avoidance && max_sens < 70)
+        st->avoidance = 0;
+
+    st->msl += bmsl;
+    st->msr += bmsr;
+    limit(&st->msl, KSIM_MAX_SPEED);
+    limit(&st->msr, KSIM_MAX_SPEED);
+
+    w->robots[me].left = st->msl*KSIM_MAX_SPEED_WEB/(KSIM_MAX_SPEED+1);
+    w->robots[me].right = st->msr*KSIM_MAX_SPEED_WEB/(KSIM_MAX_SPEED+1);
+
+    // Fitness of the robot controllers (with their integer division of the sensor values)
+    st->fit_speed += (abs(st->msl) + abs(st->msr))/(2.0*KSIM_MAX_SPEED);
+    st->fit_diff += abs(st->msl - st->msr)/(double)MAX_DIFF;
+    for (i = 0; i < KSIM_NB_SENSORS; i++)
+        st->sens_val[i] += ds[i]/MAX_SENS;
+}
+
+/**
+ * @brief      Run an episode: every robot runs its controller during `steps` steps of KSIM_TIME_STEP
+ *
+ * @param      w      The world with the robots at their start pose (their odometry starts there)
+ * @param[in]  ctrl   The controller of each robot
+ * @param[in]  steps  Number of steps (SIM_STEPS of the robot controllers)
+ * @param[out] res    The obstacle avoidance fitness of each robot and the flocking metric of the group
+ *
+ * @return     1 if the world has no robot
+ */
+int ksim_episode(ksim_world_t *w, const ksim_controller_t *ctrl, int steps, ksim_result_t *res) {
+    controller_state_t st[KSIM_MAX_ROBOTS];
+    double sent[KSIM_MAX_ROBOTS][3];  // Poses at the previous step (emission of the pings)
+    double dmax = KSIM_TIME_STEP*KSIM_MAX_SPEED_WEB*KSIM_WHEEL_RADIUS;  // Distance max reach in one time step
+    double pre_ctr_x = 0, pre_ctr_z = 0, ctr_x, ctr_z;
+    double o, dfl1, dfl2, delta;
+    int n = w->n_robots;
+    int i, j, k, t;
+
+    memset(res, 0, sizeof(*res));
+    if (n == 0 || steps <= 0)
+        return 1;
+
+    memset(st, 0, sizeof(st));
+    for (i = 0; i < n; i++) {
+        st[i].origin_y = w->robots[i].y;
+        sent[i][0] = w->robots[i].x;
+        sent[i][1] = w->robots[i].y;
+        sent[i][2] = w->robots[i].heading;
+        pre_ctr_x += w->robots[i].x/n;
+        pre_ctr_z += -w->robots[i].y/n;
+    }
+    ksim_sense(w);
+
+    for (t = 0; t < steps; t++) {
+        for (i = 0; i < n; i++)
+            control(w, &ctrl[i], &st[i], i, (const double (*)[3])sent);
+        for (i = 0; i < n; i++) {
+            sent[i][0] = w->robots[i].x;
+            sent[i][1] = w->robots[i].y;
+            sent[i][2] = w->robots[i].heading;
+        }
+        ksim_step(w, KSIM_TIME_STEP);
+        ksim_sense(w);
+
+        // Flocking metric of pso_simplified_sup_flock (Webots x, z)
+        if (n < 2)
+            continue;
+        o = 0;
+        for (i = 0; i < n; i++)
+            for (k = i+1; k < n; k++)
+                o += fabs(remainder(w->robots[i].heading - w->robots[k].heading, 2*M_PI))/M_PI;
+        o = 1 - o/(n*(n-1)/2.0);
+
+        ctr_x = ctr_z = 0;
+        for (i = 0; i < n; i++) {
+            ctr_x += w->robots[i].x/n;
+            ctr_z += -w->robots[i].y/n;
+        }
+        dfl1 = 0;
+        for (i = 0; i < n; i++)
+            dfl1 += sqrt(pow(w->robots[i].x - ctr_x, 2) + pow(-w->robots[i].y - ctr_z, 2));
+        dfl1 = 1/(dfl1/n + 1);
+        dfl2 = 0;
+        for (i = 0; i < n; i++) {
+            for (j = i+1; j < n; j++) {
+                delta = sqrt(pow(w->robots[i].x - w->robots[j].x, 2) + pow(w->robots[i].y - w->robots[j].y, 2));
+                dfl2 += fmin(delta/TARGET_FLOCKING_DISTANCE, 1/pow(1 - TARGET_FLOCKING_DISTANCE + delta, 2));
+            }
+        }
+        dfl2 /= n*(n-1)/2.0;
+
+        res->dfl += dfl1*dfl2;
+        res->o += o;
+        res->v += sqrt(pow(pre_ctr_x - ctr_x, 2) + pow(pre_ctr_z - ctr_z, 2))/dmax;
+        pre_ctr_x = ctr_x;
+        pre_ctr_z = ctr_z;
+    }
+
+    res->dfl /= steps;
+    res->o /= steps;
+    res->v /= steps;
+    res->flocking = res->dfl*res->o*res->v;
+
+    for (i = 0; i < n; i++) {
+        double fit_sens = 0;
+        for (k = 0; k < KSIM_NB_SENSORS; k++)
+            if (st[i].sens_val[k] > fit_sens)
+                fit_sens = st[i].sens_val[k];
+        double fit_speed = st[i].fit_speed/steps;
+        double fit_diff = st[i].fit_diff/steps;
+        fit_sens /= steps;
+        res->obstacle[i] = fit_speed*(1.0 - sqrt(fit_diff))*(1.0 - fit_sens);
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+#ifndef KINEMATIC_SIM_H
+#define KINEMATIC_SIM_H
+
+#include <stdint.h>
+
+#define KSIM_MAX_ROBOTS    16
+#define KSIM_MAX_BOXES     64
+#define KSIM_NB_SENSORS    8
+#define KSIM_TIME_STEP     0.064    // [s] Control step of the robots (TIME_STEP)
+
+/* E-puck model (robots of the pso worlds) */
+#define KSIM_ROBOT_RADIUS  0.037    // [m] Radius of the body
+#define KSIM_WHEEL_RADIUS  0.0205   // [m]
+#define KSIM_AXLE_LENGTH   0.052    // [m] Distance between the wheels
+#define KSIM_MAX_SPEED     800      // Maximum wheel speed of the controllers
+#define KSIM_MAX_SPEED_WEB 6.28     // [rad/s] Wheel speed of KSIM_MAX_SPEED
+
+/// Oriented box (wall or obstacle), in the plane (x, y = -z of Webots)
+typedef struct
+{
+  double x, y;
+  double half_x, half_y;
+  double cos_a, sin_a;        // Orientation of the box (counterclockwise)
+} ksim_box_t;
+
+typedef struct
+{
+  double x, y, heading;       // Pose in the plane (x, y = -z of Webots), heading counterclockwise from x
+  double left, right;         // Wheel speeds [rad/s]
+  int ds[KSIM_NB_SENSORS];    // Infrared sensor values of the last step
+} ksim_robot_t;
+
+typedef struct
+{
+  int n_boxes;
+  ksim_box_t boxes[KSIM_MAX_BOXES];
+  int n_robots;
+  ksim_robot_t robots[KSIM_MAX_ROBOTS];
+  double time;                // [s]
+  int noise;                  // Gaussian noise on the sensors (as in Webots)
+  uint32_t rng;               // State of the random generator of the noise
+} ksim_world_t;
+
+/// Controller of a robot: copy of simulation_webot() of the pso_simplified robot controllers
+typedef struct
+{
+  double braitenberg_right[KSIM_NB_SENSORS];  // Weights of the sensors for the right wheel (bmsr)
+  double braitenberg_left[KSIM_NB_SENSORS];   // Weights of the sensors for the left wheel (bmsl)
+  int reynolds;               // 0: constant forward speed (avoidance), 1: Reynolds' rules (flocking)
+  double rule1_threshold, rule1_weight, rule2_threshold, rule2_weight, migration_weight;
+  double migr[2];             // Migration goal in the frame of the robot's odometry
+} ksim_controller_t;
+
+typedef struct
+{
+  double obstacle[KSIM_MAX_ROBOTS];  // Obstacle avoidance fitness of each robot (robot controllers)
+  double flocking;            // Flocking metric dfl*o*v (pso_simplified_sup_flock)
+  double dfl, o, v;
+} ksim_result_t;
+
+/// Documentation in c file
+void ksim_init(ksim_world_t *w, uint32_t seed, int noise);
+int ksim_add_box(ksim_world_t *w, double x, double z, double size_x, double size_z, double angle);
+int ksim_add_robot(ksim_world_t *w, double x, double z, double heading);
+void ksim_sense(ksim_world_t *w);
+void ksim_range_bearing(const ksim_world_t *w, int i, int k, double *range, double *bearing);
+void ksim_step(ksim_world_t *w, double dt);
+int ksim_episode(ksim_world_t *w, const ksim_controller_t *ctrl, int steps, ksim_result_t *res);
+
+#endif
@@ -0,0 +1,148 @@
+/*****************************************************************************/
+/* File:         log_policy.c                                                */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Decimated, on-change and event-driven (burst) logging       */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "log_policy.h"
+
+/**
+ * @brief      Initialize a log stream
+ *
+ * @param      s         The stream
+ * @param[in]  policy    When rows are written (see log_policy.h)
+ * @param[in]  n_values  Number of values per row
+ * @param[in]  sink      Function writing a row
+ * @param      ctx       Argument given to the sink (e.g. the FILE*)
+ *
+ * @return     1 if it fails
+ */
+int log_stream_init(log_stream_t *s, const log_policy_t *policy, int n_values, log_sink_t sink, void *ctx) {
+    memset(s, 0, sizeof(*s));
+    s->policy = *policy;
+    if (s->policy.decimation < 1)
+        s->policy.decimation = 1;
+    if (s->policy.burst_pre < 0)
+        s->policy.burst_pre = 0;
+    s->sink = sink;
+    s->ctx = ctx;
+    s->n_values = n_values;
+    s->last = calloc(n_values, sizeof(double));
+    s->ring = calloc((size_t)n_values*(s->policy.burst_pre + 1), sizeof(double));
+    s->ring_written = calloc(s->policy.burst_pre + 1, 1);
+    return s->last == NULL || s->ring == NULL || s->ring_written == NULL;
+}
+
+/**
+ * @brief      Signal an event (FSM transition, collision, GPS update...).
+ *             The burst_pre rows before it, the next pushed row and the burst_post rows after it are written.
+ */
+void log_stream_event(log_stream_t *s) {
+    s->event = 1;
+}
+
+static void write_row(log_stream_t *s, const double *row) {
+    s->sink(s->ctx, row, s->n_values);
+    memcpy(s->last, row, s->n_values*sizeof(double));
+    s->has_last = 1;
+}
+
+/**
+ * @brief      Check if a row is far enough from the last written one (LOG_ON_CHANGE)
+ */
+static int has_changed(const log_stream_t *s, const double *row) {
+    int i;
+
+    if (!s->has_last)
+        return 1;
+    for (i = s->policy.skip_cols; i < s->n_values; i++) {
+        if (fabs(row[i] - s->last[i]) > s->policy.threshold)
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief      Give the row of the current step to the stream, it is written or not depending on the policy.
+ *             The ring keeps the last burst_pre rows across the writes, so that an event soon after a
+ *             written row still gets all its burst_pre rows: the ones not written yet follow the last
+ *             written row in the log (the time column orders them), none is written twice.
+ */
+void log_stream_push(log_stream_t *s, const double *row) {
+    int keep;
+    int i;
+
+    if (s->sink == NULL)
+        return;
+
+    switch (s->policy.mode) {
+        case LOG_DECIMATE:
+            keep = (s->step % s->policy.decimation) == 0;
+            break;
+        case LOG_ON_CHANGE:
+            keep = has_changed(s, row);
+            break;
+        default:
+            keep = 1;
+            break;
+    }
+    s->step++;
+
+    if (s->event) {
+        // Write the rows before the event not written yet, oldest first
+        for (i = 0; i < s->ring_count; i++) {
+            int idx = (s->ring_head - s->ring_count + i + s->policy.burst_pre) % s->policy.burst_pre;
+            if (!s->ring_written[idx])
+                write_row(s, &s->ring[(size_t)idx*s->n_values]);
+            s->ring_written[idx] = 1;
+        }
+        s->post_left = s->policy.burst_post;
+        s->event = 0;
+        keep = 1;
+    }
+    else if (s->post_left > 0) {
+        s->post_left--;
+        keep = 1;
+    }
+
+    if (keep)
+        write_row(s, row);
+    if (s->policy.burst_pre > 0) {
+        memcpy(&s->ring[(size_t)s->ring_head*s->n_values], row, s->n_values*sizeof(double));
+        s->ring_written[s->ring_head] = (char)keep;
+        s->ring_head = (s->ring_head + 1) % s->policy.burst_pre;
+        if (s->ring_count < s->policy.burst_pre)
+            s->ring_count++;
+    }
+}
+
+void log_stream_free(log_stream_t *s) {
+    free(s->last);
+    free(s->ring);
+    free(s->ring_written);
+    s->last = NULL;
+    s->ring = NULL;
+    s->ring_written = NULL;
+    s->sink = NULL;
+}
+
+/**
+ * @brief      Sink writing the row as a line of a csv file ("v0; v1; ...")
+ *
+ * @param      fp        The FILE* of the csv file
+ */
+void log_csv_sink(void *fp, const double *row, int n_values) {
+    int i;
+
+    if (fp == NULL)
+        return;
+    for (i = 0; i < n_values; i++)
+        fprintf((FILE *)fp, i == n_values-1 ? "%g\n" : "%g; ", row[i]);
+}
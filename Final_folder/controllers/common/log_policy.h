@@ -0,0 +1,47 @@
+#ifndef LOG_POLICY_H
+#define LOG_POLICY_H
+
+/* Logging modes */
+#define LOG_ALWAYS     0    // Write every step
+#define LOG_DECIMATE   1    // Write one step out of `decimation`
+#define LOG_ON_CHANGE  2    // Write when a value moved more than `threshold` since the last written row
+
+typedef struct
+{
+  int mode;             // LOG_ALWAYS, LOG_DECIMATE or LOG_ON_CHANGE
+  int decimation;       // LOG_DECIMATE: keep one row out of decimation
+  double threshold;     // LOG_ON_CHANGE: minimal change of a value to write a row
+  int skip_cols;        // LOG_ON_CHANGE: leading columns ignored by the change test (e.g. time)
+  int burst_pre;        // Rows kept in memory and written when an event occurs
+  int burst_post;       // Rows always written after an event
+} log_policy_t;
+
+/// Function writing one row in the log (csv file, compressed log...)
+typedef void (*log_sink_t)(void *ctx, const double *row, int n_values);
+
+typedef struct
+{
+  log_policy_t policy;
+  log_sink_t sink;
+  void *ctx;
+  int n_values;
+  long step;            // Number of rows pushed
+  int post_left;        // Rows still to write after the last event
+  int event;            // An event was signaled for the next pushed row
+  double *last;         // Last written row
+  int has_last;
+  double *ring;         // Last burst_pre rows pushed, written or not
+  char *ring_written;   // The row of the ring is already in the log
+  int ring_head;
+  int ring_count;
+} log_stream_t;
+
+/// Documentation in c file
+int log_stream_init(log_stream_t *s, const log_policy_t *policy, int n_values, log_sink_t sink, void *ctx);
+void log_stream_event(log_stream_t *s);
+void log_stream_push(log_stream_t *s, const double *row);
+void log_stream_free(log_stream_t *s);
+
+void log_csv_sink(void *fp, const double *row, int n_values);
+
+#endif
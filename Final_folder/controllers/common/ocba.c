@@ -0,0 +1,152 @@
+/*****************************************************************************/
+/* File:         ocba.c                                                      */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Optimal computing budget allocation (OCBA) of the noisy     */
+/*               re-evaluations of the PSO personal bests                    */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "ocba.h"
+
+/* OCBA (Chen et al.) gives the samples to the bests that could still be the best: for a best i
+   other than the current best b, N_i is proportional to (s_i/(m_b-m_i))^2, and
+   N_b = s_b*sqrt(sum N_i^2/s_i^2). Bests that are clearly worse or have a small variance get
+   few samples, the ones whose confidence interval overlaps the one of b get most of them.
+   The variance of a best is shrunk towards the pooled variance of all bests, so that a best
+   with two lucky close samples is not taken as certain. */
+
+/**
+ * @brief      Add a sample to the statistics of a best (Welford)
+ *
+ * @param      mean   The mean of the samples
+ * @param      n      The number of samples
+ * @param      m2     The sum of the squared deviations to the mean
+ * @param[in]  value  The new sample
+ */
+void ocba_add(double *mean, double *n, double *m2, double value) {
+    double delta = value - *mean;
+    *n += 1;
+    *mean += delta / *n;
+    *m2 += delta * (value - *mean);
+}
+
+static double variance(double n, double m2) {
+    return n > 1 ? m2 / (n - 1) : 0;
+}
+
+/* Variance of a best with one pseudo-sample of the pooled variance */
+static double shrunk_variance(double n, double m2, double pooled) {
+    return (m2 + pooled) / fmax(n, 1);
+}
+
+/**
+ * @brief      Allocate new evaluations to k bests, the one with the highest mean is the best
+ *
+ * @param[in]  mean    The mean of each best
+ * @param[in]  n       The number of samples of each best
+ * @param[in]  m2      The sum of the squared deviations of each best
+ * @param[in]  k       The number of bests
+ * @param[in]  budget  The number of evaluations to allocate
+ * @param[out] alloc   The number of evaluations of each best (sum = budget)
+ *
+ * @return     1 if there is no best, or no memory (the budget is then shared equally)
+ */
+int ocba_allocate(const double *mean, const double *n, const double *m2, int k, int budget, int *alloc) {
+    double *ratio, *want;
+    double sum_ratio = 0, sum_b = 0, total = 0, delta, var;
+    double sum_m2 = 0, sum_dof = 0, pooled;
+    int i, b = 0;
+
+    if (k <= 0)
+        return 1;
+    memset(alloc, 0, k * sizeof(int));
+
+    // Every best needs a few samples for its variance: one at a time to the best with the fewest
+    // samples, the highest mean first, so that a short budget is shared instead of going by index
+    while (budget > 0) {
+        int j = -1;
+        for (i = 0; i < k; i++) {
+            if (n[i] + alloc[i] >= OCBA_MIN_SAMPLES)
+                continue;
+            if (j < 0 || n[i] + alloc[i] < n[j] + alloc[j] ||
+                (n[i] + alloc[i] == n[j] + alloc[j] && mean[i] > mean[j]))
+                j = i;
+        }
+        if (j < 0)
+            break;
+        alloc[j]++;
+        budget--;
+    }
+    if (budget == 0)
+        return 0;
+
+    ratio = malloc(2 * k * sizeof(double));
+    if (ratio == NULL) {
+        for (i = 0; budget > 0; i = (i + 1) % k, budget--)
+            alloc[i]++;
+        return 1;
+    }
+    want = ratio + k;
+    for (i = 0; i < k; i++) {
+        if (mean[i] > mean[b])
+            b = i;
+        total += n[i] + alloc[i];
+        if (n[i] > 1) {
+            sum_m2 += m2[i];
+            sum_dof += n[i] - 1;
+        }
+    }
+    total += budget;
+    pooled = sum_dof > 0 ? sum_m2 / sum_dof : 0;
+
+    for (i = 0; i < k; i++) {
+        if (i == b)
+            continue;
+        delta = fmax(mean[b] - mean[i], OCBA_MIN_DELTA);
+        var = shrunk_variance(n[i], m2[i], pooled);
+        ratio[i] = var / (delta * delta);
+        sum_b += var / pow(delta, 4);
+    }
+    ratio[b] = sqrt(shrunk_variance(n[b], m2[b], pooled) * sum_b);
+    for (i = 0; i < k; i++)
+        sum_ratio += ratio[i];
+
+    // Evaluations missing to reach the OCBA share of the total budget
+    for (i = 0; i < k; i++) {
+        if (sum_ratio > 0)
+            want[i] = total * ratio[i] / sum_ratio - (n[i] + alloc[i]);
+        else
+            want[i] = 0;  // No variance at all: share the budget equally
+    }
+
+    // One evaluation at a time to the best with the largest deficit
+    while (budget > 0) {
+        int j = 0;
+        for (i = 1; i < k; i++) {
+            if (want[i] > want[j] || (want[i] == want[j] && n[i] + alloc[i] < n[j] + alloc[j]))
+                j = i;
+        }
+        alloc[j]++;
+        want[j] -= 1;
+        budget--;
+    }
+    free(ratio);
+    return 0;
+}
+
+/**
+ * @brief      Print the number of samples, the mean and the standard deviation of every best
+ */
+void ocba_print(const double *mean, const double *n, const double *m2, int k) {
+    int i;
+
+    printf("Particle  samples  mean        std\n");
+    for (i = 0; i < k; i++)
+        printf("%8d  %7.0f  %10.6f  %10.6f\n", i, n[i], mean[i], sqrt(variance(n[i], m2[i])));
+}
@@ -0,0 +1,15 @@
+#ifndef OCBA_H
+#define OCBA_H
+
+#define OCBA_MIN_SAMPLES  2        // A best is re-evaluated until it has this many samples (variance)
+#define OCBA_MIN_DELTA    1e-6     // Smallest difference of means between two bests
+
+/* The statistics of a best are its mean, its number of samples and the sum of the squared
+   deviations (Welford), in the arrays lbestperf, lbestage and lbestm2 of pso() */
+
+/// Documentation in c file
+void ocba_add(double *mean, double *n, double *m2, double value);
+int ocba_allocate(const double *mean, const double *n, const double *m2, int k, int budget, int *alloc);
+void ocba_print(const double *mean, const double *n, const double *m2, int k);
+
+#endif
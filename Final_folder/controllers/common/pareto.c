@@ -0,0 +1,222 @@
+/*****************************************************************************/
+/* File:         pareto.c                                                    */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Archive of the non-dominated trade-offs found by a          */
+/*               multi-objective PSO, with crowding distances                */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "pareto.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
+
+/* Every objective is maximized. A point dominates another if it is at least as good in every
+   objective and better in one; the archive only keeps points that no other point dominates.
+   Once it holds capacity points, the point of smallest crowding distance (the sum over the
+   objectives of the normalized gap between its two neighbors on the front) is dropped, so
+   that the front stays spread; the extreme points of each objective are never dropped. The
+   leaders of the swarm are drawn by binary tournaments on the crowding distance, which favors
+   the sparse parts of the front. */
+
+/**
+ * @brief      Initialize an empty archive
+ *
+ * @param      a           The archive
+ * @param[in]  dim         The dimension of the particles (at most PARETO_MAX_DIM)
+ * @param[in]  objectives  The number of objectives (at most PARETO_MAX_OBJECTIVES)
+ * @param[in]  capacity    The maximum number of points (at most PARETO_MAX_POINTS)
+ * @param[in]  names       The names of the objectives (NULL: f0, f1, ...)
+ */
+void pareto_init(pareto_t *a, int dim, int objectives, int capacity, const char *const *names) {
+    memset(a, 0, sizeof(*a));
+    a->dim = dim < PARETO_MAX_DIM ? dim : PARETO_MAX_DIM;
+    a->objectives = objectives < PARETO_MAX_OBJECTIVES ? objectives : PARETO_MAX_OBJECTIVES;
+    a->capacity = capacity > 0 && capacity < PARETO_MAX_POINTS ? capacity : PARETO_MAX_POINTS;
+    a->names = names;
+}
+
+/**
+ * @brief      Whether the objectives f dominate the objectives g (maximization)
+ */
+int pareto_dominates(const double *f, const double *g, int objectives) {
+    int k, better = 0;
+
+    for (k = 0; k < objectives; k++) {
+        if (f[k] < g[k])
+            return 0;
+        if (f[k] > g[k])
+            better = 1;
+    }
+    return better;
+}
+
+static void remove_point(pareto_t *a, int i) {
+    a->n--;
+    if (i == a->n)
+        return;
+    memcpy(a->x[i], a->x[a->n], sizeof(a->x[i]));
+    memcpy(a->f[i], a->f[a->n], sizeof(a->f[i]));
+    a->crowding[i] = a->crowding[a->n];
+}
+
+/**
+ * @brief      Offer a particle to the archive
+ *
+ * @param      a     The archive
+ * @param[in]  x     The particle (dim values)
+ * @param[in]  f     Its objectives
+ *
+ * @return     1 if it is kept (no point of the archive dominates or equals it)
+ */
+int pareto_add(pareto_t *a, const double *x, const double *f) {
+    int i, w;
+
+    for (i = 0; i < a->n; i++)
+        if (pareto_dominates(a->f[i], f, a->objectives) || memcmp(a->f[i], f, a->objectives * sizeof(double)) == 0)
+            return 0;
+    for (i = a->n - 1; i >= 0; i--)
+        if (pareto_dominates(f, a->f[i], a->objectives))
+            remove_point(a, i);
+
+    memcpy(a->x[a->n], x, a->dim * sizeof(double));
+    memcpy(a->f[a->n], f, a->objectives * sizeof(double));
+    a->n++;
+    if (a->n <= a->capacity)
+        return 1;
+
+    // Full: drop the most crowded point, possibly the new one
+    pareto_crowding(a);
+    for (i = 1, w = 0; i < a->n; i++)
+        if (a->crowding[i] < a->crowding[w])
+            w = i;
+    remove_point(a, w);
+    return w != a->n;
+}
+
+/**
+ * @brief      Compute the crowding distance of every point (infinite for the extreme points)
+ */
+void pareto_crowding(pareto_t *a) {
+    int order[PARETO_MAX_POINTS + 1];
+    int i, j, k, t;
+    double range;
+
+    for (i = 0; i < a->n; i++)
+        a->crowding[i] = 0.0;
+    if (a->n < 3) {
+        for (i = 0; i < a->n; i++)
+            a->crowding[i] = INFINITY;
+        return;
+    }
+    for (k = 0; k < a->objectives; k++) {
+        // Insertion sort on the objective k (the archive is small)
+        for (i = 0; i < a->n; i++) {
+            for (j = i, t = i; j > 0 && a->f[order[j - 1]][k] > a->f[t][k]; j--)
+                order[j] = order[j - 1];
+            order[j] = t;
+        }
+        a->crowding[order[0]] = a->crowding[order[a->n - 1]] = INFINITY;
+        range = a->f[order[a->n - 1]][k] - a->f[order[0]][k];
+        if (range <= 0.0)
+            continue;
+        for (i = 1; i < a->n - 1; i++)
+            a->crowding[order[i]] += (a->f[order[i + 1]][k] - a->f[order[i - 1]][k]) / range;
+    }
+}
+
+/**
+ * @brief      Draw a leader by a binary tournament on the crowding distance (pareto_crowding() first)
+ *
+ * @param[in]  a     The archive (not empty)
+ * @param      rng   The stream of the draw
+ *
+ * @return     The index of the leader
+ */
+int pareto_select(const pareto_t *a, rng_t *rng) {
+    int i = (int)(rng_uniform(rng) * a->n);
+    int j = (int)(rng_uniform(rng) * a->n);
+
+    if (i >= a->n)
+        i = a->n - 1;
+    if (j >= a->n)
+        j = a->n - 1;
+    return a->crowding[j] > a->crowding[i] ? j : i;
+}
+
+/**
+ * @brief      Point of the largest product of the objectives, the scalar fitness of the supervisors
+ *
+ * @return     Its index (-1 if the archive is empty)
+ */
+int pareto_pick(const pareto_t *a) {
+    int i, k, b = -1;
+    double prod, best = -INFINITY;
+
+    for (i = 0; i < a->n; i++) {
+        for (k = 0, prod = 1.0; k < a->objectives; k++)
+            prod *= a->f[i][k];
+        if (prod > best || b < 0) {
+            best = prod;
+            b = i;
+        }
+    }
+    return b;
+}
+
+/**
+ * @brief      Save the front as CSV (atomically, through <path>.<pid>.tmp): one line per point, its
+ *             objectives then its particle
+ *
+ * @param[in]  a     The archive
+ * @param[in]  path  The file
+ *
+ * @return     1 on failure (the previous file is kept)
+ */
+int pareto_save(const pareto_t *a, const char *path) {
+    char tmp[512];
+    FILE *fp;
+    int i, k, ok;
+
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid());
+    fp = fopen(tmp, "w");
+    if (fp == NULL)
+        return 1;
+    for (k = 0; k < a->objectives; k++) {
+        if (a->names != NULL)
+            fprintf(fp, "%s,", a->names[k]);
+        else
+            fprintf(fp, "f%d,", k);
+    }
+    for (k = 0; k < a->dim; k++)
+        fprintf(fp, k < a->dim - 1 ? "w%d," : "w%d\n", k);
+    for (i = 0; i < a->n; i++) {
+        for (k = 0; k < a->objectives; k++)
+            fprintf(fp, "%g,", a->f[i][k]);
+        for (k = 0; k < a->dim; k++)
+            fprintf(fp, k < a->dim - 1 ? "%.6f," : "%.6f\n", a->x[i][k]);
+    }
+    ok = !ferror(fp);
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok) {
+        remove(tmp);
+        return 1;
+    }
+#ifdef _WIN32
+    remove(path);  // rename() does not replace a file on Windows
+#endif
+    if (rename(tmp, path) != 0) {
+        remove(tmp);
+        return 1;
+    }
+    return 0;
+}
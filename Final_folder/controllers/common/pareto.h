@@ -0,0 +1,32 @@
+#ifndef PARETO_H
+#define PARETO_H
+
+#include "rng.h"
+
+#define PARETO_MAX_POINTS      200      // Maximum size of the archive
+#define PARETO_MAX_DIM         32       // Maximum dimension of a particle (DATASIZE)
+#define PARETO_MAX_OBJECTIVES  4
+
+/// Archive of the non-dominated particles of a multi-objective PSO (objectives to maximize)
+typedef struct
+{
+  int dim;
+  int objectives;
+  int capacity;               // Points kept (at most PARETO_MAX_POINTS), the most crowded ones are dropped beyond
+  int n;                      // Number of points
+  const char *const *names;   // Names of the objectives, header of the saved front (NULL: f0, f1, ...)
+  double x[PARETO_MAX_POINTS + 1][PARETO_MAX_DIM];
+  double f[PARETO_MAX_POINTS + 1][PARETO_MAX_OBJECTIVES];
+  double crowding[PARETO_MAX_POINTS + 1];  // Crowding distance of each point (pareto_crowding())
+} pareto_t;
+
+/// Documentation in c file
+void pareto_init(pareto_t *a, int dim, int objectives, int capacity, const char *const *names);
+int pareto_dominates(const double *f, const double *g, int objectives);
+int pareto_add(pareto_t *a, const double *x, const double *f);
+void pareto_crowding(pareto_t *a);
+int pareto_select(const pareto_t *a, rng_t *rng);
+int pareto_pick(const pareto_t *a);
+int pareto_save(const pareto_t *a, const char *path);
+
+#endif
@@ -0,0 +1,1302 @@
+/*****************************************************************************/
+/* File:         pso.c                                                       */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Noise-resistant local best PSO shared by the pso            */
+/*               supervisors, which only provide the fitness function        */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "pso.h"
+#include "ocba.h"
+#include "checkpoint.h"
+#include "rng.h"
+#include "cmaes.h"
+#include "island.h"
+#include "pareto.h"
+#include "warm_start.h"
+
+/* The swarm is stored as arrays of n*dim doubles (particle i at [i*dim]), all in one block
+   that is also the checkpoint. The velocity update runs over the whole swarm as one flat
+   loop on the arrays, with the random numbers drawn beforehand, so that the compiler
+   vectorizes it. The neighborhood is a ring of n_neighbours particles on each side,
+   without a n*n neighbor matrix, so swarms of thousands of particles are cheap: the cost
+   of an iteration is the evaluations.
+
+   The random numbers come from streams derived from one master seed (common/rng.h): one per
+   particle, checkpointed with the swarm, and one seed per evaluation, the last double of its
+   job, from which the fitness function draws the spawn positions and noise of the episode.
+   The generational PSO is then reproducible, the same on the workers of a pool as in one
+   simulation; the asynchronous one is not, its order of evaluation depends on the workers.
+
+   With common random numbers (cfg.crn), all the new particles and all the personal bests of an
+   iteration are evaluated on the same cfg.crn scenarios (seeds), so that the luck of the spawn
+   positions cancels in the comparisons: a best is replaced when the paired difference with its
+   new particle is positive, and the neighborhood bests compare performances on the same
+   scenarios. This replaces the noisy re-evaluations (NOISY, OCBA); the fitness cache, whose
+   means mix other scenarios, and the racing goals are not used.
+
+   The asynchronous variant (cfg.async) is steady-state: a particle is moved, and its personal
+   and neighborhood bests updated, as soon as its own evaluation returns, and each worker of
+   the pool gets its next job as soon as it returns one, so that no worker waits for the
+   slowest episode of an iteration. An iteration is then n evaluations of new particles; the
+   re-evaluations of the personal bests are queued at its end and go before the next new
+   particles.
+
+   CMA-ES (cfg.cmaes) replaces the swarm over the same evaluations, cfg.iterations*n: its
+   populations are evaluated as one batch like the swarm, and the personal bests become an
+   archive of the n best candidates evaluated, from which the final selection picks the best.
+
+   An island (cfg.island) is one swarm of an island model, with a seed and files (checkpoint,
+   fitness cache, archive, Pareto front) of its own: every cfg.migration_interval iterations it sends its best personal best to the other
+   islands and the migrants it received replace its worst personal bests they beat, as in an
+   iteration. Migrations never wait, so the islands run at their own pace.
+
+   With a curriculum (cfg.curriculum), the jobs also carry the length of their episode, a fraction
+   of the full episode: the first iterations only have to weed out the broken particles, so their
+   episodes are short (cfg.curriculum_min), and the length grows with the convergence of the
+   personal bests (their spread in the initialization domain) and with the progress of the run,
+   without ever shrinking. The fitness functions are means per step, comparable across lengths;
+   the short episodes do not go to the fitness cache nor to the surrogate, and the final
+   selection always runs full episodes, OCBA from new statistics of the bests.
+
+   The multi-objective PSO (cfg.objectives) has no single best: the fitness function returns
+   cfg.objectives values per particle, all maximized, and every new particle is offered to an
+   archive of the non-dominated ones (common/pareto.h), saved at each iteration. A personal best
+   is replaced by a new position that dominates it, or that it does not dominate with probability
+   1/2, and the neighborhood best of a particle is a leader drawn from the archive, favoring its
+   sparse parts. A particle is evaluated once, in batches on the pool as the scalar PSO; the
+   checkpoint, the re-evaluations, the fitness cache, the surrogate, the common random numbers,
+   the asynchronous variant, CMA-ES, the migrations and the curriculum are for one fitness and
+   not used.
+
+   With an archive of the bests of the previous runs (cfg.archive, common/warm_start.h), a share
+   cfg.archive_share of the new swarm is seeded from its entries in the order of their rank, the
+   best one exactly and the others perturbed by cfg.archive_spread of the initialization domain,
+   and the other particles stay random so that the swarm can still leave the previous optimum;
+   CMA-ES starts from the best entry. At the end of the run, the personal bests go to the archive
+   with the statistics of their final selection and the archive is saved (cfg.archive_file), so
+   that the next run starts where this one stopped. A multi-objective run is seeded the same way
+   but adds nothing to the archive, its particles have no single fitness. */
+
+/// Header of the checkpoint, followed by the arrays of the swarm and the streams of the particles
+typedef struct
+{
+  uint64_t seed;              // Master seed of the run
+  uint64_t evaluations;       // Evaluations so far (id of the next one)
+  int32_t iteration;          // Next iteration
+  int32_t reserved;
+} state_header_t;
+
+static void label(const pso_t *p, int id, const char *text) {
+    if (p->cfg.label != NULL)
+        p->cfg.label(id, text);
+}
+
+/* FNV-1a of n values, continuing hash */
+static uint32_t hash_values(uint32_t hash, const double *x, int n) {
+    const unsigned char *b = (const unsigned char *)x;
+    size_t i;
+    for (i = 0; x != NULL && i < n * sizeof(double); i++) {
+        hash ^= b[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* Tag of the checkpoint: the layout of the state and the parameters of the run, so that a
+   checkpoint of a run with other parameters is not resumed */
+static uint32_t state_tag(const pso_t *p) {
+    const pso_config_t *c = &p->cfg;
+    double v[] = {p->n, p->dim, p->size, c->n_neighbours, c->lweight, c->nbweight, c->damping, c->vmax,
+                  c->iterations, (double)c->seed, c->async, c->cmaes, c->noisy, c->ocba, c->ocba_budget,
+                  c->ocba_select_budget, c->racing, c->crn, c->curriculum, c->curriculum_min,
+                  c->migration_interval, c->objectives, c->batch};
+    uint32_t hash = hash_values(2166136261u, v, sizeof(v) / sizeof(v[0]));
+
+    hash = hash_values(hash, c->init_min, p->dim);
+    hash = hash_values(hash, c->init_max, p->dim);
+    hash = hash_values(hash, c->limit_min, p->dim);
+    return hash_values(hash, c->limit_max, p->dim);
+}
+
+/**
+ * @brief      Generic default configuration, the pso supervisors replace the weights, the
+ *             iterations and the options by their own (common/pso_options.h)
+ *
+ * @param[out] cfg          The configuration
+ * @param[in]  n_particles  The number of particles
+ * @param[in]  dim          The number of elements of a particle
+ */
+void pso_config_default(pso_config_t *cfg, int n_particles, int dim) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->n_particles = n_particles;
+    cfg->dim = dim;
+    cfg->n_neighbours = 2;
+    cfg->lweight = 2.0;
+    cfg->nbweight = 4.0;
+    cfg->damping = 0.6;
+    cfg->vmax = 30.0;
+    cfg->iterations = 20;
+    cfg->noisy = 1;
+    cfg->ocba_budget = n_particles / 2;
+    cfg->ocba_select_budget = 5 * n_particles / 2;
+    cfg->cache_samples = 3;
+    cfg->curriculum_min = 0.25;
+    cfg->archive_share = 0.5;
+    cfg->archive_spread = 0.1;
+    cfg->surrogate_kappa = 2.0;
+    cfg->surrogate_nudges = 2;
+    cfg->surrogate_min_points = 2 * dim;
+    cfg->batch = 1;
+}
+
+/**
+ * @brief      Allocate a swarm
+ *
+ * @param[out] p     The swarm
+ * @param[in]  cfg   The configuration (fitness is required)
+ *
+ * @return     1 on failure
+ */
+int pso_init(pso_t *p, const pso_config_t *cfg) {
+    double *a;
+    int n = cfg->n_particles, dim = cfg->dim;
+
+    memset(p, 0, sizeof(*p));
+    if (n < 1 || dim < 1 || cfg->fitness == NULL || cfg->batch < 1)
+        return 1;
+    p->cfg = *cfg;
+    if (cfg->async)
+        p->cfg.crn = 0;  // The scenarios are per iteration
+    p->n = n;
+    p->dim = dim;
+    p->size = dim + (cfg->racing ? 1 : 0) + (cfg->curriculum ? 1 : 0) + 1;
+    p->length = 1.0;
+    if (cfg->objectives > 0 && (cfg->pareto == NULL || cfg->pareto->dim != dim ||
+                                cfg->pareto->objectives != cfg->objectives ||
+                                (cfg->pool != NULL && cfg->pool->objectives != cfg->objectives))) {
+        printf("PSO: %d objectives, not those of the archive or of the pool\n", cfg->objectives);
+        return 1;
+    }
+    if (cfg->archive != NULL && cfg->archive->dim != dim) {
+        printf("PSO: archive of particles of %d elements instead of %d\n", cfg->archive->dim, dim);
+        return 1;
+    }
+    p->max_jobs = PSO_SELECT_EVALS * n > cfg->batch ? PSO_SELECT_EVALS * n : cfg->batch;
+    if (p->max_jobs < 2 * n * cfg->crn)
+        p->max_jobs = 2 * n * cfg->crn;
+
+    p->state_size = sizeof(state_header_t) + (4 * n * dim + 4 * n) * sizeof(double) + n * sizeof(rng_t);
+    p->state = calloc(1, p->state_size);
+    p->perf = calloc(n, sizeof(double));
+    p->skip = calloc(n, sizeof(int));
+    p->rand1 = calloc(2 * n * dim, sizeof(double));
+    p->jobs = calloc(p->max_jobs * p->size, sizeof(double));
+    p->fit = calloc(p->max_jobs, sizeof(double));
+    p->who = calloc(p->max_jobs, sizeof(int));
+    p->owner = calloc(p->max_jobs, sizeof(int));
+    p->misses = calloc(p->max_jobs * p->size, sizeof(double));
+    p->fit_misses = calloc(p->max_jobs, sizeof(double));
+    p->alloc = calloc(n, sizeof(int));
+    p->busy = calloc(n, sizeof(int));
+    p->version = calloc(n, sizeof(int));
+    p->queue = calloc(p->max_jobs, sizeof(int));
+    p->items = calloc(PSO_ASYNC_JOBS * cfg->batch, sizeof(pso_item_t));
+    p->job_count = calloc(PSO_ASYNC_JOBS, sizeof(int));
+    p->job_data = calloc(PSO_ASYNC_JOBS * cfg->batch * p->size, sizeof(double));
+    p->migrant = calloc(dim, sizeof(double));
+    p->obj = calloc(2 * n * (cfg->objectives > 0 ? cfg->objectives : 1), sizeof(double));
+    if (p->state == NULL || p->perf == NULL || p->skip == NULL || p->rand1 == NULL || p->jobs == NULL ||
+        p->fit == NULL || p->who == NULL || p->owner == NULL || p->misses == NULL || p->fit_misses == NULL ||
+        p->alloc == NULL || p->busy == NULL || p->version == NULL || p->queue == NULL ||
+        p->items == NULL || p->job_count == NULL || p->job_data == NULL || p->migrant == NULL || p->obj == NULL) {
+        pso_free(p);
+        return 1;
+    }
+    p->rand2 = p->rand1 + n * dim;
+    p->lbestobj = p->obj + n * (cfg->objectives > 0 ? cfg->objectives : 1);
+    if (island_active(cfg->island)) {  // The islands of a world share its directory
+        p->cfg.checkpoint = island_file(cfg->island, cfg->checkpoint, p->checkpoint, sizeof(p->checkpoint));
+        p->cfg.cache_file = island_file(cfg->island, cfg->cache_file, p->cache_file, sizeof(p->cache_file));
+        p->cfg.archive_file = island_file(cfg->island, cfg->archive_file, p->archive_file, sizeof(p->archive_file));
+        p->cfg.pareto_file = island_file(cfg->island, cfg->pareto_file, p->pareto_file, sizeof(p->pareto_file));
+    }
+
+    a = (double *)((state_header_t *)p->state + 1);
+    p->x = a;
+    p->v = a + n * dim;
+    p->lbest = a + 2 * n * dim;
+    p->nbbest = a + 3 * n * dim;
+    p->lbestperf = a + 4 * n * dim;
+    p->lbestage = p->lbestperf + n;
+    p->lbestm2 = p->lbestage + n;
+    p->nbbestperf = p->lbestm2 + n;
+    p->rng = (rng_t *)(p->nbbestperf + n);
+    return 0;
+}
+
+/**
+ * @brief      Free a swarm
+ */
+void pso_free(pso_t *p) {
+    free(p->state);
+    free(p->perf);
+    free(p->skip);
+    free(p->rand1);
+    free(p->jobs);
+    free(p->fit);
+    free(p->who);
+    free(p->owner);
+    free(p->misses);
+    free(p->fit_misses);
+    free(p->alloc);
+    free(p->busy);
+    free(p->version);
+    free(p->queue);
+    free(p->items);
+    free(p->job_count);
+    free(p->job_data);
+    free(p->migrant);
+    free(p->obj);
+    memset(p, 0, sizeof(*p));
+}
+
+/* Job of size doubles: particle x, the fitness to beat (racing), the length of the episode (curriculum)
+   and the seed of the episode */
+static void make_job(pso_t *p, double *job, const double *x, double goal) {
+    state_header_t *header = p->state;
+
+    memcpy(job, x, p->dim * sizeof(double));
+    if (p->cfg.racing)
+        job[p->dim] = goal;
+    if (p->cfg.curriculum)
+        job[p->dim + (p->cfg.racing ? 1 : 0)] = p->length;
+    job[p->size - 1] = (double)rng_derive(header->seed, RNG_STREAM(RNG_EVALUATION, header->evaluations++));
+}
+
+/* Job j of the next evaluation */
+static void set_job(pso_t *p, int j, const double *x, double goal) {
+    make_job(p, &p->jobs[j * p->size], x, goal);
+}
+
+/* Job j on the common scenario s of the iteration k (cfg.crn) */
+static void set_scenario_job(pso_t *p, int j, const double *x, int k, int s) {
+    state_header_t *header = p->state;
+
+    set_job(p, j, x, -INFINITY);
+    p->jobs[j * p->size + p->size - 1] =
+        (double)rng_derive(header->seed, RNG_STREAM(RNG_SCENARIO, ((uint64_t)k << 16) | (uint64_t)s));
+}
+
+/* Add an evaluation of job x to the fitness cache and to the surrogate, unless it was aborted or short.
+   A raced episode that runs to its end is a full evaluation, only the aborted ones (-INFINITY) are partial. */
+static void record(pso_t *p, const double *x, fcache_entry_t *entry, double f) {
+    const pso_config_t *c = &p->cfg;
+
+    if (f == -INFINITY)
+        return;
+    if (c->curriculum && x[p->dim + (c->racing ? 1 : 0)] < 1.0)
+        return;
+    if (entry != NULL)
+        fcache_add(entry, f);
+    if (c->surrogate != NULL)
+        surrogate_add(c->surrogate, x, f);
+}
+
+/* Evaluate the n first jobs in p->fit. With cached, the jobs whose cell has cache_samples samples
+   in the fitness cache take its mean, the others are evaluated by the pool or by batches. The
+   re-evaluations of the bests are new samples of their performance and never take the mean. */
+static void evaluate(pso_t *p, int n, int cached) {
+    const pso_config_t *c = &p->cfg;
+    fcache_entry_t *entry;
+    int i, m = 0, size = p->size;
+
+    for (i = 0; i < n; i++) {
+        entry = (cached && c->cache != NULL && !c->crn) ? fcache_find(c->cache, &p->jobs[i * size], 0) : NULL;
+        if (entry != NULL && entry->n >= c->cache_samples)
+            p->fit[i] = entry->mean;
+        else {
+            memcpy(&p->misses[m * size], &p->jobs[i * size], size * sizeof(double));
+            p->who[m++] = i;
+        }
+    }
+
+    if (c->pool != NULL && c->pool->role == PSO_POOL_COORDINATOR)
+        pso_pool_evaluate(c->pool, p->misses, m, size, c->batch, p->fit_misses, c->fitness);
+    else {
+        for (i = 0; i < m; i += c->batch)
+            c->fitness(&p->misses[i * size], m - i < c->batch ? m - i : c->batch, &p->fit_misses[i]);
+    }
+    for (i = 0; i < m; i++) {
+        p->fit[p->who[i]] = p->fit_misses[i];
+        entry = (c->cache != NULL && !c->crn) ? fcache_find(c->cache, &p->misses[i * size], 1) : NULL;
+        record(p, &p->misses[i * size], entry, p->fit_misses[i]);
+    }
+}
+
+/* Move the new particle i halfway to its neighborhood best while the surrogate predicts it far
+   below it, and return 1 to skip it if it is still unpromising after surrogate_nudges moves */
+static int prescreen_particle(pso_t *p, int i) {
+    const pso_config_t *c = &p->cfg;
+    double mean, sd;
+    double *x = &p->x[i * p->dim];
+    double *v = &p->v[i * p->dim];
+    const double *nbbest = &p->nbbest[i * p->dim];
+    int k, t;
+
+    if (c->surrogate == NULL || c->surrogate->n < c->surrogate_min_points)
+        return 0;
+    for (t = 0; t <= c->surrogate_nudges; t++) {
+        if (surrogate_predict(c->surrogate, x, &mean, &sd) || mean + c->surrogate_kappa * sd >= p->nbbestperf[i])
+            return 0;
+        if (t == c->surrogate_nudges)
+            return 1;
+        for (k = 0; k < p->dim; k++) {
+            x[k] = (x[k] + nbbest[k]) / 2.0;
+            v[k] /= 2.0;
+        }
+    }
+    return 0;
+}
+
+/* Pre-screen the new particles with the surrogate (p->skip) */
+static void prescreen(pso_t *p) {
+    int i, n_skip = 0;
+
+    for (i = 0; i < p->n; i++) {
+        p->skip[i] = prescreen_particle(p, i);
+        n_skip += p->skip[i];
+    }
+    if (n_skip > 0)
+        printf("Surrogate: %d particles skipped\n", n_skip);
+}
+
+/* Performance of the particles (EVOLVE). The new particles (screen) are screened by the
+   surrogate and raced against their neighborhood best; an aborted one returns -INFINITY. */
+static void evaluate_particles(pso_t *p, int screen) {
+    char text[64];
+    int i, n = 0;
+
+    if (screen)
+        prescreen(p);
+    for (i = 0; i < p->n; i++) {
+        if (screen && p->skip[i])
+            continue;
+        set_job(p, n++, &p->x[i * p->dim], screen ? p->nbbestperf[i] : -INFINITY);
+    }
+    snprintf(text, sizeof(text), "Particles: 0-%d\n", p->n - 1);
+    label(p, 1, text);
+    evaluate(p, n, 1);
+    n = 0;
+    for (i = 0; i < p->n; i++) {
+        p->perf[i] = (screen && p->skip[i]) ? -INFINITY : p->fit[n++];  // A skipped particle never becomes a best
+        p->skip[i] = 0;
+    }
+}
+
+/* Average a new evaluation of each personal best into its performance (EVOLVE_AVG) */
+static void reevaluate_all(pso_t *p) {
+    char text[64];
+    int i;
+
+    for (i = 0; i < p->n; i++)
+        set_job(p, i, &p->lbest[i * p->dim], -INFINITY);
+    snprintf(text, sizeof(text), "Bests: 0-%d\n", p->n - 1);
+    label(p, 1, text);
+    evaluate(p, p->n, 0);
+    for (i = 0; i < p->n; i++) {
+        p->lbestperf[i] = ((p->lbestage[i] - 1.0) * p->lbestperf[i] + p->fit[i]) / p->lbestage[i];
+        p->lbestage[i]++;
+    }
+}
+
+/* Re-evaluate the personal bests with budget evaluations allocated by OCBA (see common/ocba.h) */
+static void reevaluate(pso_t *p, int budget) {
+    char text[64];
+    int i, k, n = 0;
+
+    if (budget > p->max_jobs)
+        budget = p->max_jobs;
+    ocba_allocate(p->lbestperf, p->lbestage, p->lbestm2, p->n, budget, p->alloc);
+    for (i = 0; i < p->n; i++) {
+        for (k = 0; k < p->alloc[i]; k++) {
+            set_job(p, n, &p->lbest[i * p->dim], -INFINITY);
+            p->owner[n++] = i;
+        }
+    }
+    snprintf(text, sizeof(text), "Re-evaluations: %d\n", n);
+    label(p, 1, text);
+    evaluate(p, n, 0);
+    for (k = 0; k < n; k++)
+        ocba_add(&p->lbestperf[p->owner[k]], &p->lbestage[p->owner[k]], &p->lbestm2[p->owner[k]], p->fit[k]);
+}
+
+/* New particles and personal bests on the common scenarios of the iteration k (cfg.crn): the
+   performances are the means over the scenarios, a best is replaced by update_local() when the
+   paired difference is positive */
+static void evaluate_crn(pso_t *p, int k) {
+    char text[64];
+    int i, s, j, m = 0;
+
+    prescreen(p);
+    for (s = 0; s < p->cfg.crn; s++) {
+        for (i = 0; i < p->n; i++) {
+            set_scenario_job(p, m, &p->lbest[i * p->dim], k, s);
+            p->owner[m++] = i;
+            if (p->skip[i])
+                continue;
+            set_scenario_job(p, m, &p->x[i * p->dim], k, s);
+            p->owner[m++] = p->n + i;
+        }
+    }
+    snprintf(text, sizeof(text), "Scenarios: %d, evaluations: %d\n", p->cfg.crn, m);
+    label(p, 1, text);
+    evaluate(p, m, 0);
+    for (i = 0; i < p->n; i++)
+        p->perf[i] = p->lbestperf[i] = 0.0;
+    for (j = 0; j < m; j++) {
+        if (p->owner[j] < p->n)
+            p->lbestperf[p->owner[j]] += p->fit[j] / p->cfg.crn;
+        else
+            p->perf[p->owner[j] - p->n] += p->fit[j] / p->cfg.crn;
+    }
+    for (i = 0; i < p->n; i++) {
+        if (p->skip[i])
+            p->perf[i] = -INFINITY;
+        p->skip[i] = 0;
+    }
+}
+
+/* Performance of the personal bests for the final selection, over PSO_SELECT_EVALS evaluations (SELECT),
+   on common scenarios with cfg.crn */
+static void select_bests(pso_t *p) {
+    char text[64];
+    int i, k;
+
+    for (k = 0; k < PSO_SELECT_EVALS; k++) {
+        for (i = 0; i < p->n; i++) {
+            if (p->cfg.crn)
+                set_scenario_job(p, k * p->n + i, &p->lbest[i * p->dim], p->cfg.iterations, k);
+            else
+                set_job(p, k * p->n + i, &p->lbest[i * p->dim], -INFINITY);
+        }
+    }
+    snprintf(text, sizeof(text), "Bests: 0-%d\n", p->n - 1);
+    label(p, 1, text);
+    evaluate(p, PSO_SELECT_EVALS * p->n, 0);
+    for (i = 0; i < p->n; i++) {
+        p->lbestperf[i] = 0.0;
+        for (k = 0; k < PSO_SELECT_EVALS; k++)
+            p->lbestperf[i] += p->fit[k * p->n + i];
+        p->lbestperf[i] /= PSO_SELECT_EVALS;
+        p->lbestage[i] = PSO_SELECT_EVALS;  // Statistics of the selection, kept by the archive
+        p->lbestm2[i] = 0.0;
+        for (k = 0; k < PSO_SELECT_EVALS; k++)
+            p->lbestm2[i] += (p->fit[k * p->n + i] - p->lbestperf[i]) * (p->fit[k * p->n + i] - p->lbestperf[i]);
+    }
+}
+
+/* Length of the episodes at the given progress of the run (fraction of its evaluations, curriculum):
+   from cfg.curriculum_min, it grows with the progress and with the convergence of the personal
+   bests, 0 while they are spread as uniformly over the initialization domain (or not all found
+   yet, CMA-ES) and 1 once they meet, and never shrinks */
+static void update_length(pso_t *p, double progress) {
+    const pso_config_t *c = &p->cfg;
+    double mean, var, range, spread = 0.0, converged, length;
+    int i, k;
+
+    if (!c->curriculum || p->length >= 1.0)
+        return;
+    for (i = 0; i < p->n; i++)
+        if (p->lbestperf[i] == -INFINITY)
+            spread = 1.0;
+    for (k = 0; k < p->dim && spread < 1.0; k++) {
+        mean = var = 0.0;
+        for (i = 0; i < p->n; i++)
+            mean += p->lbest[i * p->dim + k] / p->n;
+        for (i = 0; i < p->n; i++)
+            var += (p->lbest[i * p->dim + k] - mean) * (p->lbest[i * p->dim + k] - mean) / p->n;
+        range = c->init_max[k] - c->init_min[k];
+        if (range > 0.0)
+            spread += 12.0 * var / (range * range) / p->dim;  // The variance of a uniform is range^2/12
+    }
+    converged = fmax(0.0, 1.0 - sqrt(spread));
+    length = c->curriculum_min + (1.0 - c->curriculum_min) * fmin(fmax(converged, progress), 1.0);
+    if (length <= p->length)
+        return;
+    p->length = length;
+    printf("Curriculum: episodes of %.0f%% of the full length\n", 100.0 * length);
+}
+
+/* Random numbers of the velocity update, drawn from the stream of each particle */
+static void draw_random(pso_t *p) {
+    const int m = p->n * p->dim;
+    int i;
+
+    for (i = 0; i < m; i++) {
+        p->rand1[i] = rng_uniform(&p->rng[i / p->dim]);
+        p->rand2[i] = rng_uniform(&p->rng[i / p->dim]);
+    }
+}
+
+/* Flat velocity and position update of m elements, with the random numbers drawn beforehand
+   (the arrays do not overlap, so that the compiler vectorizes the loop) */
+static void update_velocity(const pso_config_t *c, int m, double *restrict x, double *restrict v,
+                            const double *restrict lbest, const double *restrict nbbest,
+                            const double *restrict r1, const double *restrict r2) {
+    int i;
+
+    for (i = 0; i < m; i++) {
+        v[i] = c->damping * v[i] + c->lweight * r1[i] * (lbest[i] - x[i]) + c->nbweight * r2[i] * (nbbest[i] - x[i]);
+        x[i] += v[i];
+    }
+}
+
+/* Velocity and position update of the whole swarm */
+static void move(pso_t *p) {
+    const pso_config_t *c = &p->cfg;
+    const int m = p->n * p->dim;
+    double *x = p->x;
+    int i, k;
+
+    draw_random(p);
+    update_velocity(c, m, p->x, p->v, p->lbest, p->nbbest, p->rand1, p->rand2);
+    if (c->limit_min != NULL && c->limit_max != NULL) {
+        for (i = 0; i < m; i += p->dim)
+            for (k = 0; k < p->dim; k++)
+                x[i + k] = fmax(fmin(x[i + k], c->limit_max[k]), c->limit_min[k]);
+    }
+}
+
+/* Velocity and position update of particle i (asynchronous PSO) */
+static void move_particle(pso_t *p, int i) {
+    const pso_config_t *c = &p->cfg;
+    double *x = &p->x[i * p->dim];
+    double *v = &p->v[i * p->dim];
+    const double *lbest = &p->lbest[i * p->dim];
+    const double *nbbest = &p->nbbest[i * p->dim];
+    double r1, r2;
+    int k;
+
+    for (k = 0; k < p->dim; k++) {
+        r1 = rng_uniform(&p->rng[i]);
+        r2 = rng_uniform(&p->rng[i]);
+        v[k] = c->damping * v[k] + c->lweight * r1 * (lbest[k] - x[k]) + c->nbweight * r2 * (nbbest[k] - x[k]);
+        x[k] += v[k];
+        if (c->limit_min != NULL && c->limit_max != NULL)
+            x[k] = fmax(fmin(x[k], c->limit_max[k]), c->limit_min[k]);
+    }
+}
+
+/* Update the personal best of particle i with its new position */
+static void update_particle(pso_t *p, int i) {
+    if (p->perf[i] > p->lbestperf[i]) {
+        memcpy(&p->lbest[i * p->dim], &p->x[i * p->dim], p->dim * sizeof(double));
+        p->lbestperf[i] = p->perf[i];
+        p->lbestage[i] = 1.0;
+        p->lbestm2[i] = 0.0;  // A replaced best has a single sample
+        p->version[i]++;
+    }
+}
+
+/* Update the personal bests with the new particles */
+static void update_local(pso_t *p) {
+    int i;
+    for (i = 0; i < p->n; i++)
+        update_particle(p, i);
+}
+
+/* Particle i of the ring */
+static int ring(const pso_t *p, int i) {
+    return (i % p->n + p->n) % p->n;
+}
+
+/* Update the neighborhood best of particle i (ring of n_neighbours particles on each side) */
+static void neighborhood_best(pso_t *p, int i) {
+    int j, d, k = p->cfg.n_neighbours;
+
+    p->nbbestperf[i] = p->lbestperf[i];
+    for (d = -k; d <= k; d++) {
+        j = ring(p, i + d);
+        if (p->lbestperf[j] > p->nbbestperf[i]) {
+            memcpy(&p->nbbest[i * p->dim], &p->lbest[j * p->dim], p->dim * sizeof(double));
+            p->nbbestperf[i] = p->lbestperf[j];
+        }
+    }
+}
+
+/* Update the neighborhood bests */
+static void update_neighborhood(pso_t *p) {
+    int i;
+    for (i = 0; i < p->n; i++)
+        neighborhood_best(p, i);
+}
+
+/* Index of the best personal best */
+static int best_index(const pso_t *p) {
+    int i, b = 0;
+    for (i = 1; i < p->n; i++)
+        if (p->lbestperf[i] > p->lbestperf[b])
+            b = i;
+    return b;
+}
+
+/* Migration before the iteration k (island): send the best personal best to the other islands,
+   then let each migrant received replace the worst personal best if it beats it */
+static void migrate(pso_t *p, int k) {
+    int i, w, n_in = 0;
+    double perf;
+
+    if (!island_active(p->cfg.island) || p->cfg.migration_interval < 1 || k % p->cfg.migration_interval != 0)
+        return;
+    i = best_index(p);
+    island_send(p->cfg.island, &p->lbest[i * p->dim], p->dim, p->lbestperf[i]);
+    while (island_receive(p->cfg.island, p->migrant, p->dim, &perf)) {
+        for (i = 0, w = 0; i < p->n; i++) {
+            if (memcmp(&p->lbest[i * p->dim], p->migrant, p->dim * sizeof(double)) == 0)
+                break;  // Already here (the best of an island can be sent again)
+            if (p->lbestperf[i] < p->lbestperf[w])
+                w = i;
+        }
+        if (i < p->n || perf <= p->lbestperf[w])
+            continue;
+        memcpy(&p->lbest[w * p->dim], p->migrant, p->dim * sizeof(double));
+        p->lbestperf[w] = perf;
+        p->lbestage[w] = 1.0;
+        p->lbestm2[w] = 0.0;
+        p->version[w]++;
+        n_in++;
+    }
+    if (n_in > 0) {
+        update_neighborhood(p);
+        printf("Island %d: %d migrants taken\n", p->cfg.island->id, n_in);
+    }
+}
+
+static void save_cache(const pso_t *p) {
+    if (p->cfg.cache != NULL && p->cfg.cache_file != NULL && fcache_save(p->cfg.cache, p->cfg.cache_file))
+        printf("Could not save the fitness cache %s\n", p->cfg.cache_file);
+}
+
+/* Add the personal bests and the statistics of their final selection to the archive of the runs and save it */
+static void save_archive(pso_t *p) {
+    const warm_start_t *a = p->cfg.archive;
+    int i;
+
+    if (a == NULL)
+        return;
+    for (i = 0; i < p->n; i++)
+        warm_start_add(p->cfg.archive, &p->lbest[i * p->dim], p->lbestage[i], p->lbestperf[i], p->lbestm2[i]);
+    printf("Archive of the runs: %d bests, best %lf over %g evaluations\n", a->count, a->entries[0].mean,
+           a->entries[0].n);
+    if (p->cfg.archive_file != NULL && warm_start_save(p->cfg.archive, p->cfg.archive_file))
+        printf("Could not save the archive %s\n", p->cfg.archive_file);
+}
+
+/* Save the swarm before the iteration k (with its streams, so that a resumed run continues identically) */
+static void save_state(pso_t *p, int k) {
+    state_header_t *header = p->state;
+
+    header->iteration = k;
+    if (p->cfg.checkpoint != NULL &&
+        checkpoint_save(p->cfg.checkpoint, p->state, p->state_size, state_tag(p)))
+        printf("Could not save the checkpoint %s\n", p->cfg.checkpoint);
+    else if (p->cfg.checkpoint != NULL)
+        p->checkpointed = 1;
+    save_cache(p);
+}
+
+/* Load the swarm from the checkpoint and return the iteration to resume (-1: new run) */
+static int load_state(pso_t *p) {
+    state_header_t *header = p->state;
+
+    if (!p->cfg.resume || p->cfg.checkpoint == NULL ||
+        checkpoint_load(p->cfg.checkpoint, p->state, p->state_size, state_tag(p)))
+        return -1;
+    p->checkpointed = 1;
+    printf("Resuming the PSO at iteration %d from %s (seed %llu), delete it to start a new run\n",
+           header->iteration + 1, p->cfg.checkpoint, (unsigned long long)header->seed);
+    return header->iteration;
+}
+
+/* Streams of the seed, particles seeded from the archive or random and velocities, which are their personal bests */
+static void random_swarm(pso_t *p, uint64_t seed) {
+    const pso_config_t *c = &p->cfg;
+    state_header_t *header = p->state;
+    int seeds = c->archive != NULL && c->archive->count > 0 ? (int)(c->archive_share * p->n + 0.5) : 0;
+    int i, k, seeded;
+
+    header->seed = seed;
+    header->evaluations = 0;
+    printf("Seed of the swarm: %llu\n", (unsigned long long)seed);
+    if (seeds > 0)
+        printf("%d particles seeded from the archive of %d bests\n", seeds < p->n ? seeds : p->n, c->archive->count);
+    for (i = 0; i < p->n; i++) {
+        rng_init(&p->rng[i], seed, RNG_STREAM(RNG_PARTICLE, i));
+        seeded = i < seeds && !warm_start_particle(c->archive, i, c->archive_spread, c->init_min, c->init_max,
+                                                   &p->rng[i], &p->x[i * p->dim]);
+        for (k = 0; k < p->dim; k++) {
+            if (!seeded)
+                p->x[i * p->dim + k] = (c->init_max[k] - c->init_min[k]) * rng_uniform(&p->rng[i]) + c->init_min[k];
+            else if (c->limit_min != NULL && c->limit_max != NULL)
+                p->x[i * p->dim + k] = fmax(fmin(p->x[i * p->dim + k], c->limit_max[k]), c->limit_min[k]);
+            p->v[i * p->dim + k] = 2.0 * c->vmax * rng_uniform(&p->rng[i]) - c->vmax;  // Random initial velocity
+        }
+    }
+    // Best configurations and performances are initially the current ones
+    memcpy(p->lbest, p->x, p->n * p->dim * sizeof(double));
+    memcpy(p->nbbest, p->x, p->n * p->dim * sizeof(double));
+}
+
+/* Seeded or random particles and velocities, evaluated once */
+static void init_swarm(pso_t *p, uint64_t seed) {
+    int i;
+
+    random_swarm(p, seed);
+    if (p->cfg.curriculum)
+        p->length = p->cfg.curriculum_min;
+    evaluate_particles(p, 0);
+    for (i = 0; i < p->n; i++) {
+        p->lbestperf[i] = p->perf[i];
+        p->lbestage[i] = 1.0;  // One performance so far
+        p->lbestm2[i] = 0.0;
+        p->nbbestperf[i] = p->perf[i];
+    }
+    update_neighborhood(p);
+}
+
+static void print_best(const pso_t *p, const char *title) {
+    const double *best = &p->lbest[best_index(p) * p->dim];
+    int k;
+
+    printf("\n...................................................................................................................\n");
+    printf("%s : %lf\nBest Weights:", title, p->lbestperf[best_index(p)]);
+    for (k = 0; k < p->dim; k++)
+        printf(k % 8 ? "%.2lf\t" : "\n%.2lf\t", best[k]);
+    printf("\n...................................................................................................................\n");
+}
+
+/* Queue the re-evaluations of the personal bests of an iteration (asynchronous PSO) */
+static void queue_reevaluations(pso_t *p) {
+    const pso_config_t *c = &p->cfg;
+    int i, k;
+
+    if (!c->noisy)
+        return;
+    if (c->ocba)
+        ocba_allocate(p->lbestperf, p->lbestage, p->lbestm2, p->n,
+                      c->ocba_budget < p->max_jobs ? c->ocba_budget : p->max_jobs, p->alloc);
+    for (i = 0; i < p->n; i++)
+        for (k = 0; k < (c->ocba ? p->alloc[i] : 1) && p->queue_len < p->max_jobs; k++)
+            p->queue[(p->queue_head + p->queue_len++) % p->max_jobs] = i;
+}
+
+/* End of the iteration k-1 of the asynchronous PSO: n new particles evaluated */
+static void end_iteration(pso_t *p, int k) {
+    char text[64];
+
+    migrate(p, k);
+    print_best(p, "Best performance of the iteration");
+    save_state(p, k);
+    update_length(p, (double)k / p->cfg.iterations);
+    if (k < p->cfg.iterations) {
+        snprintf(text, sizeof(text), "Iteration: %d", k + 1);
+        label(p, 0, text);
+        queue_reevaluations(p);
+    }
+}
+
+/* Result f of an evaluation: update the bests of its particle and of the neighbors right away */
+static void complete(pso_t *p, const pso_item_t *it, double f, int k0) {
+    int d, i = it->particle;
+
+    if (it->kind == PSO_ITEM_NEW) {
+        p->perf[i] = f;
+        p->busy[i] = 0;
+        update_particle(p, i);
+    }
+    else if (it->version != p->version[i])
+        return;  // The best was replaced during its re-evaluation
+    else if (p->cfg.ocba)
+        ocba_add(&p->lbestperf[i], &p->lbestage[i], &p->lbestm2[i], f);
+    else {
+        p->lbestperf[i] = ((p->lbestage[i] - 1.0) * p->lbestperf[i] + f) / p->lbestage[i];
+        p->lbestage[i]++;
+    }
+    for (d = -p->cfg.n_neighbours; d <= p->cfg.n_neighbours; d++)
+        neighborhood_best(p, ring(p, i + d));
+    if (it->kind == PSO_ITEM_NEW && ++p->done % p->n == 0)
+        end_iteration(p, k0 + p->done / p->n);
+}
+
+/* Fill job s with at most batch evaluations: the queued re-evaluations, then the next idle
+   particles, moved. The new particles skipped by the surrogate or settled in the fitness cache
+   are completed at once. Return the number of evaluations. */
+static int fill_job(pso_t *p, int s, int k0) {
+    const pso_config_t *c = &p->cfg;
+    pso_item_t *items = &p->items[s * c->batch];
+    double *data = &p->job_data[s * c->batch * p->size];
+    int total = (c->iterations - k0) * p->n;
+    fcache_entry_t *entry;
+    const double *x;
+    pso_item_t it;
+    int i, m, count = 0;
+
+    while (count < c->batch) {
+        if (p->queue_len > 0) {
+            it.kind = PSO_ITEM_BEST;
+            it.particle = p->queue[p->queue_head];
+            p->queue_head = (p->queue_head + 1) % p->max_jobs;
+            p->queue_len--;
+            x = &p->lbest[it.particle * p->dim];
+        }
+        else {
+            for (m = 0; m < p->n && p->busy[(p->next + m) % p->n]; m++)
+                ;
+            if (p->started >= total || m == p->n)
+                break;
+            i = (p->next + m) % p->n;
+            p->next = (i + 1) % p->n;
+            p->started++;
+            p->busy[i] = 1;
+            move_particle(p, i);
+            it.kind = PSO_ITEM_NEW;
+            it.particle = i;
+            x = &p->x[i * p->dim];
+        }
+        it.version = p->version[it.particle];
+        if (it.kind == PSO_ITEM_NEW && prescreen_particle(p, it.particle)) {
+            complete(p, &it, -INFINITY, k0);  // A skipped particle never becomes a best
+            continue;
+        }
+        entry = (c->cache != NULL && it.kind == PSO_ITEM_NEW) ? fcache_find(c->cache, x, 0) : NULL;
+        if (entry != NULL && entry->n >= c->cache_samples) {
+            complete(p, &it, entry->mean, k0);
+            continue;
+        }
+        make_job(p, &data[count * p->size], x, it.kind == PSO_ITEM_NEW ? p->nbbestperf[it.particle] : -INFINITY);
+        items[count++] = it;
+    }
+    return count;
+}
+
+/* Next job to evaluate: a job of a lost worker or a new one (-1: nothing to evaluate now) */
+static int next_job(pso_t *p, int k0) {
+    int s;
+
+    for (s = 0; s < PSO_ASYNC_JOBS; s++)
+        if (p->job_count[s] < 0)
+            return s;
+    for (s = 0; s < PSO_ASYNC_JOBS; s++)
+        if (p->job_count[s] == 0)
+            return (p->job_count[s] = fill_job(p, s, k0)) > 0 ? s : -1;
+    return -1;
+}
+
+/* Results of job s */
+static void finish(pso_t *p, int s, const double *fit, int k0) {
+    const pso_config_t *c = &p->cfg;
+    const double *x;
+    int m, count = abs(p->job_count[s]);
+
+    p->job_count[s] = 0;
+    for (m = 0; m < count; m++) {
+        x = &p->job_data[(s * c->batch + m) * p->size];
+        record(p, x, c->cache != NULL ? fcache_find(c->cache, x, 1) : NULL, fit[m]);
+        complete(p, &p->items[s * c->batch + m], fit[m], k0);
+    }
+}
+
+static int in_flight(const pso_t *p) {
+    int s;
+    for (s = 0; s < PSO_ASYNC_JOBS; s++)
+        if (p->job_count[s] > 0)
+            return 1;
+    return 0;
+}
+
+/* Steady-state PSO from the iteration k0: every idle worker gets a job as soon as it returns
+   one, without a worker the jobs are evaluated here one after the other */
+static void run_async(pso_t *p, int k0) {
+    const pso_config_t *c = &p->cfg;
+    pso_pool_t *pool = (c->pool != NULL && c->pool->role == PSO_POOL_COORDINATOR) ? c->pool : NULL;
+    int s, n, total = (c->iterations - k0) * p->n;
+    char text[64];
+
+    p->started = p->done = 0;
+    p->queue_head = p->queue_len = 0;
+    memset(p->busy, 0, p->n * sizeof(int));
+    memset(p->job_count, 0, PSO_ASYNC_JOBS * sizeof(int));
+    snprintf(text, sizeof(text), "Iteration: %d", k0 + 1);
+    label(p, 0, text);
+    label(p, 1, "Particles: asynchronous\n");
+    queue_reevaluations(p);
+
+    while (p->done < total) {
+        // Give a job to every idle worker
+        while (pool != NULL && pso_pool_idle(pool) > 0 && (s = next_job(p, k0)) >= 0) {
+            n = abs(p->job_count[s]);
+            if (pso_pool_submit(pool, s, &p->job_data[s * c->batch * p->size], n, p->size)) {
+                p->job_count[s] = -n;
+                break;
+            }
+            p->job_count[s] = n;
+        }
+
+        // No worker: evaluate the next job here
+        if (pool == NULL || pool->n_workers == 0) {
+            if ((s = next_job(p, k0)) < 0)
+                break;
+            c->fitness(&p->job_data[s * c->batch * p->size], abs(p->job_count[s]), p->fit);
+            finish(p, s, p->fit, k0);
+            continue;
+        }
+
+        // Wait for a result, the job of a lost worker is submitted again
+        n = pso_pool_collect(pool, 1000, c->batch, &s, p->fit);
+        if (n < 0 || (n > 0 && n != p->job_count[s]))
+            p->job_count[s] = -abs(p->job_count[s]);
+        else if (n > 0)
+            finish(p, s, p->fit, k0);
+    }
+
+    // Collect the re-evaluations still running, the workers must be idle for the final selection
+    while (pool != NULL && pool->n_workers > 0 && in_flight(p)) {
+        n = pso_pool_collect(pool, 1000, c->batch, &s, p->fit);
+        if (n > 0 && n == p->job_count[s])
+            finish(p, s, p->fit, k0);
+        else if (n != 0)
+            p->job_count[s] = 0;
+    }
+    p->queue_len = 0;
+}
+
+/* PSO, resumed from its checkpoint if there is one */
+static void run_pso(pso_t *p, uint64_t seed) {
+    const pso_config_t *c = &p->cfg;
+    char text[64];
+    int k, k0;
+
+    // Resume the checkpoint of an interrupted run or initialize the swarm with the streams of the seed
+    k0 = load_state(p);
+    if (k0 < 0) {
+        init_swarm(p, seed);
+        save_state(p, 0);
+        k0 = 0;
+    }
+    else if (c->curriculum)
+        p->length = c->curriculum_min;  // Grown again from the resumed swarm
+    printf("****** Swarm initialized\n");
+
+    // Run optimization
+    if (c->async) {
+        update_length(p, (double)k0 / c->iterations);  // Of the resumed swarm, then at the end of each iteration
+        run_async(p, k0);
+    }
+    else {
+        for (k = k0; k < c->iterations; k++) {
+            snprintf(text, sizeof(text), "Iteration: %d", k + 1);
+            label(p, 0, text);
+            update_length(p, (double)k / c->iterations);
+            move(p);
+
+            // Re-evaluate the performances of the previous bests
+            if (c->crn)
+                evaluate_crn(p, k);  // With the new particles, on the same scenarios
+            else if (c->noisy) {
+                if (c->ocba)
+                    reevaluate(p, c->ocba_budget);
+                else
+                    reevaluate_all(p);
+            }
+
+            // Find the new performances, update the bests
+            if (!c->crn)
+                evaluate_particles(p, 1);
+            update_local(p);
+            update_neighborhood(p);
+            migrate(p, k + 1);
+            print_best(p, "Best performance of the iteration");
+            save_state(p, k + 1);
+        }
+    }
+}
+
+/* Fitness of the CMA-ES candidates by chunks of max_jobs evaluations, with cfg.crn on the common
+   scenarios of the generation g */
+static void evaluate_candidates(pso_t *p, const cmaes_t *es, int g, double *fit) {
+    int runs = p->cfg.crn > 0 ? p->cfg.crn : 1;
+    int total = es->lambda * runs;
+    int i, j, m;
+
+    for (i = 0; i < es->lambda; i++)
+        fit[i] = 0.0;
+    for (j = 0; j < total; j += m) {
+        m = total - j < p->max_jobs ? total - j : p->max_jobs;
+        for (i = 0; i < m; i++) {
+            if (p->cfg.crn > 0)
+                set_scenario_job(p, i, es->x[(j + i) / runs], g, (j + i) % runs);
+            else
+                set_job(p, i, es->x[(j + i) / runs], -INFINITY);
+        }
+        evaluate(p, m, 1);
+        for (i = 0; i < m; i++)
+            fit[(j + i) / runs] += p->fit[i] / runs;
+    }
+}
+
+/* Keep the candidate x in the archive of the personal bests if it beats the worst one */
+static void archive(pso_t *p, const double *x, double f) {
+    int i, w = 0;
+
+    for (i = 1; i < p->n; i++)
+        if (p->lbestperf[i] < p->lbestperf[w])
+            w = i;
+    if (f <= p->lbestperf[w])
+        return;
+    memcpy(&p->lbest[w * p->dim], x, p->dim * sizeof(double));
+    p->lbestperf[w] = f;
+    p->lbestage[w] = 1.0;
+    p->lbestm2[w] = 0.0;
+}
+
+/* CMA-ES with IPOP or BIPOP restarts (cfg.cmaes) over cfg.iterations*n evaluations. The initial
+   distribution covers the initialization domain, the candidates are clamped to the domain of
+   the particles before their evaluation. Return 1 if CMA-ES cannot run (too many elements). */
+static int run_cmaes(pso_t *p, uint64_t seed) {
+    const pso_config_t *c = &p->cfg;
+    state_header_t *header = p->state;
+    cmaes_t *es;
+    rng_t rng;
+    double mean[CMAES_MAX_DIM], scale[CMAES_MAX_DIM], fit[CMAES_MAX_LAMBDA];
+    double sigma0 = 0.0, sigma, u;
+    int budget = c->iterations * p->n, runs = c->crn > 0 ? c->crn : 1;
+    int used = 0, used_large = 0, used_small = 0, start, small;
+    int lambda0 = cmaes_default_lambda(p->dim), large = lambda0, lambda;
+    int restart, g = 0, i, k, stop;
+    char text[64];
+
+    if (p->dim > CMAES_MAX_DIM || (es = malloc(sizeof(cmaes_t))) == NULL) {
+        printf("CMA-ES: at most %d elements, running the PSO\n", CMAES_MAX_DIM);
+        return 1;
+    }
+    header->seed = seed;
+    header->evaluations = 0;
+    rng_init(&rng, seed, RNG_STREAM(RNG_RUN, 0));
+    printf("Seed of CMA-ES: %llu\n", (unsigned long long)seed);
+
+    // Step of each element in proportion to its initialization domain
+    for (k = 0; k < p->dim; k++)
+        sigma0 += (c->init_max[k] - c->init_min[k]) / p->dim;
+    for (k = 0; k < p->dim; k++)
+        scale[k] = (c->init_max[k] - c->init_min[k]) / sigma0;
+    sigma0 *= 0.3;
+    for (i = 0; i < p->n; i++) {
+        p->lbestperf[i] = -INFINITY;
+        p->lbestage[i] = 1.0;
+        p->lbestm2[i] = 0.0;
+    }
+    if (c->curriculum)
+        p->length = c->curriculum_min;
+
+    for (restart = 0; budget - used >= 4 * runs; restart++) {
+        // Population and step of the restart: IPOP doubles the population, BIPOP alternates
+        // with small populations and steps while they have used fewer evaluations
+        lambda = lambda0;
+        sigma = sigma0;
+        small = 0;
+        if (restart > 0 && c->cmaes == CMAES_BIPOP && used_small < used_large) {
+            u = rng_uniform(&rng);
+            lambda = (int)(lambda0 * pow(0.5 * large / lambda0, u * u));
+            sigma = sigma0 * pow(10.0, -2.0 * rng_uniform(&rng));
+            small = 1;
+        }
+        else if (restart > 0)
+            lambda = large = 2 * large;
+        if (lambda > CMAES_MAX_LAMBDA)
+            lambda = CMAES_MAX_LAMBDA;
+        if (lambda * runs > budget - used)
+            lambda = (budget - used) / runs;
+
+        // Mean: the best of the archive for the first run, else random in the initialization domain
+        for (k = 0; k < p->dim; k++) {
+            if (restart == 0 && c->archive != NULL && c->archive->count > 0)
+                mean[k] = c->archive->entries[0].x[k];
+            else
+                mean[k] = (c->init_max[k] - c->init_min[k]) * rng_uniform(&rng) + c->init_min[k];
+        }
+        cmaes_init(es, p->dim, lambda, mean, sigma, scale, rng_derive(seed, RNG_STREAM(RNG_RUN, restart + 1)));
+
+        start = used;
+        stop = 0;
+        while (used + es->lambda * runs <= budget && !(stop = cmaes_stop(es))) {
+            snprintf(text, sizeof(text), "Restart: %d, generation: %d", restart + 1, es->generation + 1);
+            label(p, 0, text);
+            snprintf(text, sizeof(text), "Population: %d\n", es->lambda);
+            label(p, 1, text);
+            update_length(p, (double)used / budget);
+            cmaes_ask(es);
+            if (c->limit_min != NULL && c->limit_max != NULL) {
+                for (i = 0; i < es->lambda; i++)
+                    for (k = 0; k < p->dim; k++)
+                        es->x[i][k] = fmax(fmin(es->x[i][k], c->limit_max[k]), c->limit_min[k]);
+            }
+            evaluate_candidates(p, es, g++, fit);
+            cmaes_tell(es, fit);
+            for (i = 0; i < es->lambda; i++)
+                archive(p, es->x[i], fit[i]);
+            used += es->lambda * runs;
+        }
+        if (small)
+            used_small += used - start;
+        else
+            used_large += used - start;
+        printf("CMA-ES restart %d: population %d, %d generations, %s\n", restart + 1, es->lambda, es->generation,
+               stop == CMAES_TOLX ? "converged" : stop == CMAES_TOLFUN ? "no progress" :
+               stop == CMAES_CONDITION ? "ill-conditioned" : "budget used");
+        print_best(p, "Best performance so far");
+    }
+    free(es);
+    return 0;
+}
+
+/* Objectives of the new particles in p->obj, by the pool or by batches (multi-objective) */
+static void evaluate_objectives(pso_t *p) {
+    const pso_config_t *c = &p->cfg;
+    char text[64];
+    int i;
+
+    for (i = 0; i < p->n; i++)
+        set_job(p, i, &p->x[i * p->dim], -INFINITY);
+    snprintf(text, sizeof(text), "Particles: 0-%d\n", p->n - 1);
+    label(p, 1, text);
+    if (c->pool != NULL && c->pool->role == PSO_POOL_COORDINATOR)
+        pso_pool_evaluate(c->pool, p->jobs, p->n, p->size, c->batch, p->obj, c->fitness);
+    else {
+        for (i = 0; i < p->n; i += c->batch)
+            c->fitness(&p->jobs[i * p->size], p->n - i < c->batch ? p->n - i : c->batch, &p->obj[i * c->objectives]);
+    }
+}
+
+/* Offer the new particles to the archive and update the personal bests by dominance (multi-objective) */
+static void update_front(pso_t *p) {
+    const pso_config_t *c = &p->cfg;
+    const int m = c->objectives;
+    double *f, *best;
+    int i, added = 0;
+
+    for (i = 0; i < p->n; i++) {
+        f = &p->obj[i * m];
+        best = &p->lbestobj[i * m];
+        added += pareto_add(c->pareto, &p->x[i * p->dim], f);
+        if (pareto_dominates(best, f, m) || (!pareto_dominates(f, best, m) && rng_uniform(&p->rng[i]) >= 0.5))
+            continue;
+        memcpy(&p->lbest[i * p->dim], &p->x[i * p->dim], p->dim * sizeof(double));
+        memcpy(best, f, m * sizeof(double));
+    }
+    pareto_crowding(c->pareto);
+    printf("Pareto front: %d points, %d new\n", c->pareto->n, added);
+    if (c->pareto_file != NULL && pareto_save(c->pareto, c->pareto_file))
+        printf("Could not save the Pareto front %s\n", c->pareto_file);
+}
+
+/* Multi-objective PSO over cfg.iterations iterations. The archive is kept by the caller, so that
+   the front of several runs accumulates. Return the point of the front with the largest product
+   of the objectives. */
+static double run_mopso(pso_t *p, uint64_t seed, double *best) {
+    const pso_config_t *c = &p->cfg;
+    const int m = c->objectives;
+    pareto_t *front = c->pareto;
+    double bestperf = 1.0;
+    char text[64];
+    int i, k;
+
+    random_swarm(p, seed);
+    evaluate_objectives(p);
+    memcpy(p->lbestobj, p->obj, p->n * m * sizeof(double));
+    update_front(p);
+    printf("****** Swarm initialized\n");
+
+    for (k = 0; k < c->iterations; k++) {
+        snprintf(text, sizeof(text), "Iteration: %d", k + 1);
+        label(p, 0, text);
+        for (i = 0; i < p->n; i++)
+            memcpy(&p->nbbest[i * p->dim], front->x[pareto_select(front, &p->rng[i])], p->dim * sizeof(double));
+        move(p);
+        evaluate_objectives(p);
+        update_front(p);
+    }
+
+    i = pareto_pick(front);
+    memcpy(best, front->x[i], p->dim * sizeof(double));
+    printf("_____Pareto front of %d points", front->n);
+    for (k = 0; k < m; k++) {
+        printf(k ? ", %s" : " (%s", front->names != NULL ? front->names[k] : "f");
+        bestperf *= front->f[i][k];
+    }
+    printf(")\nLargest product of the objectives: %lf\n", bestperf);
+    label(p, 0, "Optimization process over.");
+    return bestperf;
+}
+
+/**
+ * @brief      Run the PSO (resumed from its checkpoint if there is one)
+ *
+ * @param      p     The swarm
+ * @param[out] best  The best particle found (dim values, multi-objective: the point of the front of largest product)
+ *
+ * @return     The performance of the best particle (multi-objective: the product of its objectives)
+ */
+double pso_run(pso_t *p, double *best) {
+    const pso_config_t *c = &p->cfg;
+    uint64_t seed = c->seed != 0 ? c->seed : rng_master_seed();
+    double bestperf;
+    int i, k, step, budget;
+
+    if (island_active(c->island))
+        seed = rng_derive(seed, RNG_STREAM(RNG_ISLAND, c->island->id));  // The islands explore differently
+    p->checkpointed = 0;
+    label(p, 0, "Iteration: 0");
+    if (c->objectives > 0)
+        return run_mopso(p, seed, best);
+    if (c->cmaes == CMAES_NONE || run_cmaes(p, seed))
+        run_pso(p, seed);
+
+    // Find the best result of the PSO, on full episodes
+    p->length = 1.0;
+    if (c->ocba && !c->crn) {
+        budget = c->ocba_select_budget;
+        if (c->curriculum) {
+            // The samples of the run are means over shorter episodes: start again from none, with
+            // at least one sample per best (ocba_allocate() serves the bests with the fewest first)
+            for (i = 0; i < p->n; i++)
+                p->lbestperf[i] = p->lbestage[i] = p->lbestm2[i] = 0.0;
+            if (budget < p->n)
+                budget = p->n;
+        }
+        step = c->ocba_budget > 0 ? c->ocba_budget : 1;
+        for (i = 0; i < budget; i += step)
+            reevaluate(p, budget - i < step ? budget - i : step);
+        ocba_print(p->lbestperf, p->lbestage, p->lbestm2, p->n);
+    }
+    else
+        select_bests(p);
+    k = best_index(p);
+    memcpy(best, &p->lbest[k * p->dim], p->dim * sizeof(double));
+    bestperf = p->lbestperf[k];
+    save_cache(p);
+    save_archive(p);
+    if (p->checkpointed)
+        checkpoint_remove(c->checkpoint);  // The run is over (CMA-ES writes none, keep the file of another run)
+    printf("_____Best performance found\n");
+    printf("Performance over %d iterations: %lf\n", c->iterations, bestperf);
+    label(p, 0, "Optimization process over.");
+    return bestperf;
+}
@@ -0,0 +1,142 @@
+#ifndef PSO_H
+#define PSO_H
+
+#include "pso_pool.h"
+#include "fitness_cache.h"
+#include "surrogate.h"
+#include "rng.h"
+#include "cmaes.h"
+#include "island.h"
+#include "pareto.h"
+#include "warm_start.h"
+
+#define PSO_SELECT_EVALS  5        // Evaluations of each best for the final selection (without OCBA)
+#define PSO_ASYNC_JOBS    PSO_POOL_MAX_WORKERS  // Jobs in flight (asynchronous PSO)
+
+/// Evaluate n jobs (jobs[i*size + k]) of at most batch particles, same as the local evaluation of a pool.
+/// A job is the particle, the fitness to beat (racing), the length of the episode (curriculum) and the seed
+/// of the episode (see common/rng.h). A raced job whose episode is aborted returns -INFINITY, so that its partial
+/// fitness never becomes a best.
+/// A multi-objective PSO takes cfg.objectives values per job, fit[i*objectives + o].
+typedef pso_pool_fitness_t pso_fitness_t;
+
+/// Display a progress text (id 0: iteration, 1: evaluations)
+typedef void (*pso_label_t)(int id, const char *text);
+
+typedef struct
+{
+  int n_particles;
+  int dim;                    // Number of elements of a particle
+  int n_neighbours;           // Number of neighbors on each side (ring topology)
+  double lweight;             // Weight of attraction to personal best
+  double nbweight;            // Weight of attraction to neighborhood best
+  double damping;             // Damping of the particle velocity
+  double vmax;                // Maximum initial velocity
+  int iterations;
+  uint64_t seed;              // Master seed (0: rng_master_seed())
+  int async;                  // Steady-state PSO: a particle moves as soon as its evaluation returns
+  int cmaes;                  // CMA-ES with this restart strategy instead of the PSO (CMAES_IPOP, CMAES_BIPOP, see common/cmaes.h)
+  const double *init_min, *init_max;    // Initialization domain of each element
+  const double *limit_min, *limit_max;  // Domain of the particles (NULL: not limited)
+  warm_start_t *archive;      // Bests of the previous runs, seeding the swarm, to which the final bests are added (NULL: random swarm, see common/warm_start.h)
+  const char *archive_file;   // Archive saved at the end of the run (NULL: not saved)
+  double archive_share;       // Share of the particles seeded from the archive, the others are random
+  double archive_spread;      // Perturbation of the seeded particles, fraction of the initialization domain
+
+  int noisy;                  // Re-evaluate the personal bests at each iteration
+  int ocba;                   // Allocate these re-evaluations and the final selection with OCBA (common/ocba.h)
+  int ocba_budget;            // Re-evaluations per iteration (OCBA)
+  int ocba_select_budget;     // Evaluations of the final selection (OCBA)
+  int racing;                 // The jobs have the fitness to beat after the particle (-INFINITY: none)
+  int crn;                    // Common random numbers: scenarios of each iteration (0: none, not with async)
+  int curriculum;             // The jobs have the length of their episode after the racing goal (fraction of the full episode)
+  double curriculum_min;      // Length of the first episodes (curriculum)
+
+  const char *checkpoint;     // Checkpoint saved at each iteration (NULL: none, see common/checkpoint.h)
+  int resume;                 // Resume from the checkpoint
+
+  fcache_t *cache;            // Fitness cache (NULL: none, see common/fitness_cache.h)
+  const char *cache_file;
+  int cache_samples;          // Samples after which the mean of a cell is used
+
+  surrogate_t *surrogate;     // Surrogate pre-screening (NULL: none, see common/surrogate.h)
+  double surrogate_kappa;     // A particle is unpromising if mean+kappa*sd < neighborhood best
+  int surrogate_nudges;       // Moves halfway to the neighborhood best before skipping a particle
+  int surrogate_min_points;   // Evaluations before the first prediction
+
+  island_t *island;           // Island of a distributed PSO (NULL or not open: none, see common/island.h)
+  int migration_interval;     // Iterations between two migrations of the best particles (island)
+
+  int objectives;             // Multi-objective PSO: objectives returned per particle by fitness() (0: one fitness)
+  pareto_t *pareto;           // Archive of the non-dominated particles (multi-objective, see common/pareto.h)
+  const char *pareto_file;    // Front saved at each iteration (NULL: none)
+
+  pso_pool_t *pool;           // Worker simulations (NULL or not coordinator: fitness() only)
+  int batch;                  // Particles evaluated in parallel by one call of fitness()
+  pso_fitness_t fitness;
+  pso_label_t label;          // NULL: no labels
+} pso_config_t;
+
+/// Evaluation of the asynchronous PSO
+typedef struct
+{
+  int kind;                   // PSO_ITEM_NEW or PSO_ITEM_BEST
+  int particle;
+  int version;                // Version of the personal best (PSO_ITEM_BEST)
+} pso_item_t;
+
+#define PSO_ITEM_NEW   0      // New position of a particle
+#define PSO_ITEM_BEST  1      // Re-evaluation of a personal best
+
+/// Swarm, its state is one block (checkpoint) of arrays of n*dim or n doubles
+typedef struct
+{
+  pso_config_t cfg;
+  int n, dim;
+  int size;                   // Number of doubles of a job (dim, racing goal, episode length, seed)
+  int max_jobs;
+  double length;              // Length of the episodes of the new jobs (curriculum, 1: full episode)
+
+  void *state;                // Checkpoint: header (seed, evaluations, iteration) followed by the arrays
+  unsigned int state_size;
+  int checkpointed;           // The checkpoint file is of this run (saved or resumed)
+  double *x, *v, *lbest, *nbbest;                         // n*dim
+  double *lbestperf, *lbestage, *lbestm2, *nbbestperf;    // n
+  rng_t *rng;                                             // Stream of each particle
+
+  double *perf;               // Performance of the new particles
+  int *skip;                  // New particles not simulated (surrogate)
+  double *rand1, *rand2;      // Random numbers of the velocity update
+  double *jobs, *fit;         // Evaluations of an iteration
+  int *who;                   // Job of each cache miss
+  int *owner;                 // Personal best of each job (re-evaluations)
+  double *misses, *fit_misses;
+  double *obj, *lbestobj;     // Objectives of the new particles and of the personal bests (multi-objective, n*objectives)
+  int *alloc;
+
+  /* Asynchronous PSO */
+  int *busy;                  // Particles being evaluated
+  int *version;               // Replacements of each personal best (older re-evaluations are dropped)
+  int *queue;                 // Personal bests to re-evaluate (ring of max_jobs)
+  int queue_head, queue_len;
+  pso_item_t *items;          // Items of each job in flight (batch per job)
+  int *job_count;             // Items of each job (0: free, < 0: worker lost, submit again)
+  double *job_data;           // Jobs of batch*size doubles
+  int next;                   // Next particle to move
+  int started, done;          // New particles submitted and evaluated since the start of pso_run()
+
+  /* Island */
+  double *migrant;            // Particle received from another island
+  char checkpoint[128];       // Files of the island (cfg.checkpoint.<island>, see island_file())
+  char cache_file[128];
+  char archive_file[128];
+  char pareto_file[128];
+} pso_t;
+
+/// Documentation in c file
+void pso_config_default(pso_config_t *cfg, int n_particles, int dim);
+int pso_init(pso_t *p, const pso_config_t *cfg);
+double pso_run(pso_t *p, double *best);
+void pso_free(pso_t *p);
+
+#endif
@@ -0,0 +1,126 @@
+/*****************************************************************************/
+/* File:         pso_msg.c                                                   */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Versioned messages between the pso supervisors and their    */
+/*               robots (weights, abort, fitness)                            */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "pso_msg.h"
+
+/* A message is a header (type, version, episode, robots, number of values) followed by float
+   values, enough for the weights, spawn positions and fitness. The supervisor sends the weights
+   of all its robots in one message on PSO_MSG_CHANNEL, each robot takes its own block and runs
+   the fraction of its full episode given by the header, and the robots answer on their own
+   channels. A message of another version or layout, of another
+   episode or with a block of another size is rejected with its reason instead of being read as
+   weights. */
+
+/**
+ * @brief      Start a message without values
+ *
+ * @param[out] msg       The message
+ * @param[in]  type      PSO_MSG_WEIGHTS, PSO_MSG_ABORT, PSO_MSG_FITNESS or PSO_MSG_PARTIAL
+ * @param[in]  episode   The episode
+ * @param[in]  robot     The first robot addressed (supervisor) or the sender (robot)
+ * @param[in]  n_robots  The number of robots addressed (supervisor) or 1
+ */
+void pso_msg_init(pso_msg_t *msg, int type, uint32_t episode, int robot, int n_robots) {
+    memset(&msg->h, 0, sizeof(msg->h));
+    msg->h.magic = PSO_MSG_MAGIC;
+    msg->h.version = PSO_MSG_VERSION;
+    msg->h.type = type;
+    msg->h.n_robots = n_robots;
+    msg->h.robot = robot;
+    msg->h.episode = episode;
+}
+
+/**
+ * @brief      Size of the message to send (header and values)
+ */
+int pso_msg_size(const pso_msg_t *msg) {
+    return sizeof(pso_msg_header_t) + msg->h.count * sizeof(float);
+}
+
+/**
+ * @brief      Read a received packet
+ *
+ * @param[out] msg   The message
+ * @param[in]  data  The packet
+ * @param[in]  size  Its size [bytes]
+ *
+ * @return     1 if the packet is not a message of this version (the reason is printed)
+ */
+int pso_msg_read(pso_msg_t *msg, const void *data, int size) {
+    const pso_msg_header_t *h = data;
+
+    if (size < (int)sizeof(pso_msg_header_t) || h->magic != PSO_MSG_MAGIC) {
+        printf("PSO message: packet of %d bytes without header\n", size);
+        return 1;
+    }
+    if (h->version != PSO_MSG_VERSION) {
+        printf("PSO message: version %d, expected %d (rebuild the supervisor and the robots)\n", h->version,
+               PSO_MSG_VERSION);
+        return 1;
+    }
+    if (h->count > PSO_MSG_MAX_VALUES || size != (int)(sizeof(pso_msg_header_t) + h->count * sizeof(float))) {
+        printf("PSO message: %d bytes for %d values\n", size, h->count);
+        return 1;
+    }
+    memcpy(msg, data, size);
+    return 0;
+}
+
+/**
+ * @brief      Whether a message of the supervisor is for the robot
+ */
+int pso_msg_addressed(const pso_msg_t *msg, int robot) {
+    return robot >= msg->h.robot && robot < msg->h.robot + msg->h.n_robots;
+}
+
+/**
+ * @brief      Weights of a robot in a PSO_MSG_WEIGHTS message
+ *
+ * @param[in]  msg      The message
+ * @param[in]  robot    The robot
+ * @param[in]  dim      The number of weights of the robot (DATASIZE)
+ * @param[out] weights  Its dim weights followed by its spawn z
+ *
+ * @return     1 if the message has no block of dim weights for the robot (the reason is printed)
+ */
+int pso_msg_weights(const pso_msg_t *msg, int robot, int dim, double *weights) {
+    int k, block;
+
+    if (msg->h.type != PSO_MSG_WEIGHTS || !pso_msg_addressed(msg, robot))
+        return 1;
+    block = msg->h.count / msg->h.n_robots;
+    if (block != dim + 1 || msg->h.count != block * msg->h.n_robots) {
+        printf("PSO message: %d weights for robot %d, expected %d (DATASIZE of the supervisor and of the robot)\n",
+               block - 1, robot, dim);
+        return 1;
+    }
+    for (k = 0; k <= dim; k++)
+        weights[k] = msg->values[(robot - msg->h.robot) * block + k];
+    return 0;
+}
+
+/**
+ * @brief      Steps of an episode of the given length, the same for the supervisor and the robots
+ *
+ * @param[in]  length      The fraction of the full episode (header of a PSO_MSG_WEIGHTS message, 0: full)
+ * @param[in]  full_steps  The steps of a full episode (SIM_STEPS)
+ *
+ * @return     The number of steps to run, at least 1
+ */
+int pso_msg_steps(float length, int full_steps) {
+    int steps;
+
+    if (length <= 0.0f || length >= 1.0f)
+        return full_steps;
+    steps = (int)(length * full_steps + 0.5f);
+    return steps > 0 ? steps : 1;
+}
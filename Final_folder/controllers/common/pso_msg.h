@@ -0,0 +1,45 @@
+#ifndef PSO_MSG_H
+#define PSO_MSG_H
+
+#include <stdint.h>
+
+#define PSO_MSG_MAGIC       0xD5     // First byte of every message
+#define PSO_MSG_VERSION     2        // Incremented at each change of the layout
+#define PSO_MSG_MAX_VALUES  1024     // Values of a message
+#define PSO_MSG_CHANNEL     500      // Channel of the messages of the supervisor, received by all the robots
+
+/* Message types */
+#define PSO_MSG_WEIGHTS     1    // Supervisor -> robots: for each robot, the weights and the spawn z of the episode
+#define PSO_MSG_ABORT       2    // Supervisor -> robots: stop the episode (racing)
+#define PSO_MSG_FITNESS     3    // Robot -> supervisor: fitness of the episode
+#define PSO_MSG_PARTIAL     4    // Robot -> supervisor: fitness terms of the steps so far
+
+typedef struct
+{
+  uint8_t magic;
+  uint8_t version;
+  uint8_t type;
+  uint8_t n_robots;       // Robots addressed from robot (supervisor -> robots)
+  uint16_t robot;         // First robot addressed, or sender (robot -> supervisor)
+  uint16_t count;         // Number of values
+  uint32_t episode;       // Episode of the message, set by the supervisor
+  uint32_t steps;         // Steps of the episode so far (robot -> supervisor)
+  float length;           // Fraction of the full episode to run (PSO_MSG_WEIGHTS, 0: full episode)
+} pso_msg_header_t;
+
+/// Message, sent as the header followed by its count values
+typedef struct
+{
+  pso_msg_header_t h;
+  float values[PSO_MSG_MAX_VALUES];
+} pso_msg_t;
+
+/// Documentation in c file
+void pso_msg_init(pso_msg_t *msg, int type, uint32_t episode, int robot, int n_robots);
+int pso_msg_size(const pso_msg_t *msg);
+int pso_msg_read(pso_msg_t *msg, const void *data, int size);
+int pso_msg_addressed(const pso_msg_t *msg, int robot);
+int pso_msg_weights(const pso_msg_t *msg, int robot, int dim, double *weights);
+int pso_msg_steps(float length, int full_steps);
+
+#endif
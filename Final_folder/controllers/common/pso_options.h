@@ -0,0 +1,305 @@
+/*****************************************************************************/
+/* File:         pso_options.h                                               */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Tunable parameters shared by the pso supervisors, their     */
+/*               pso_config_t and the callbacks of the PSO                   */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+/*
+ * Usage: a pso supervisor defines its domain and the parameters it changes,
+ * then includes this header and writes fitness():
+ *
+ *   #define CACHE 1                           // optional, else the default below
+ *   #define ROBOTS 1                          // particles per simulation
+ *   #define DATASIZE 5                        // also NB_PARTICLE, NB_NEIGHBOURS,
+ *   ...                                       // LWEIGHT, NBWEIGHT, DAMPING, VMAX,
+ *   #include "../common/pso_options.h"        // ITS_PSO and FONT
+ *
+ *   status = pso_options_open(prior_knowledge,NULL);  // in main(), after wb_robot_init()
+ *   pso_config_from_options(&cfg,init_min,init_max,limit_min,limit_max,seed);
+ *   ...
+ *   pso_options_close();
+ *
+ * fitness() reads episode_seed[], racing_threshold[] and episode_length for
+ * its ROBOTS particles, and writes objectives[] with MULTI_OBJECTIVE.
+ *
+ * Tunable parameters: ------------------------------------------------------
+ * NOISY : activate the noise resistance PSO with reevaluation of the best performance
+ * OCBA : Allocate the re-evaluations of the bests with OCBA (common/ocba.c) instead of re-evaluating every
+ *        best at each iteration and every best 5 times for the final selection
+ * RESUME : Resume an interrupted PSO from its checkpoint (CHECKPOINT_FILE) when the supervisor starts,
+ *        if it is of a run with the same parameters (not the same fitness: delete it after a change)
+ * CACHE : Take the fitness of a new particle whose cell (CACHE_QUANTUM) has CACHE_SAMPLES samples from the
+ *        fitness cache (common/fitness_cache.c) instead of running an episode
+ * SURROGATE : Predict the fitness of the new particles with a Gaussian process (common/surrogate.c), move
+ *        the ones far below their neighborhood best towards it and do not simulate them if they stay so
+ * ASYNC : Steady-state PSO, a particle moves as soon as its own evaluation returns and every idle worker
+ *        of the pool gets a new job at once, instead of waiting for the whole swarm at each iteration
+ * CRN : Evaluate the new particles and the personal bests of an iteration on the same CRN_SCENARIOS seeded
+ *        scenarios (spawn positions, kinematic noise) and replace a best when the paired difference is
+ *        positive, instead of the re-evaluations of NOISY
+ * CMAES : Optimize with CMA-ES (common/cmaes.c) and CMAES_RESTARTS restarts instead of the PSO, over the same
+ *        number of evaluations
+ * DOMAIN_WEIGHT : Limit the parameters of the PSO in the domain
+ * WARM_START : Seed the swarm from the ranked archive of the bests of the previous runs (ARCHIVE_FILE,
+ *        common/warm_start.c), perturbed to stay diverse, and add the final bests of each run to it, instead of
+ *        copying the hand-tuned prior_knowledge weights into every particle (the first entry without archive)
+ * RACING : Abort the episodes that can no longer beat the neighborhood best of their particle (the supervisor
+ *        streams the partial fitness of the robots)
+ * CURRICULUM : Start with episodes of CURRICULUM_MIN of the full length and lengthen them as the swarm converges
+ *        (common/pso.c), the final selection and the final runs use full episodes
+ * MULTI_OBJECTIVE : Optimize the N_OBJECTIVES terms of the fitness as separate objectives and save the front of
+ *        their trade-offs (PARETO_FILE, common/pareto.c), fitness() writes them in objectives[]
+ */
+#ifndef PSO_OPTIONS_H
+#define PSO_OPTIONS_H
+
+#include <math.h>
+#include <webots/robot.h>
+#include <webots/supervisor.h>
+
+#include "timing.h"
+#include "pso_pool.h"
+#include "pso.h"
+
+#ifndef NOISY
+#define NOISY 1
+#endif
+#ifndef OCBA
+#define OCBA 0
+#endif
+#ifndef RESUME
+#define RESUME 0
+#endif
+#ifndef CACHE
+#define CACHE 0
+#endif
+#ifndef SURROGATE
+#define SURROGATE 0
+#endif
+#ifndef ASYNC
+#define ASYNC 0
+#endif
+#ifndef CRN
+#define CRN 0
+#endif
+#ifndef CMAES
+#define CMAES 0
+#endif
+#ifndef DOMAIN_WEIGHT
+#define DOMAIN_WEIGHT 0
+#endif
+#ifndef WARM_START
+#define WARM_START 0
+#endif
+#ifndef RACING
+#define RACING 0
+#endif
+#ifndef CURRICULUM
+#define CURRICULUM 0
+#endif
+#ifndef MULTI_OBJECTIVE
+#define MULTI_OBJECTIVE 0
+#endif
+
+#if NOISY == 1
+#define ITS_COEFF 1.0     // Multiplier for number of iterations
+#else
+#define ITS_COEFF 2.0     // Multiplier for number of iterations
+#endif
+
+#define JOBSIZE (DATASIZE+RACING+CURRICULUM+1)  // Particle, racing goal, episode length and seed of the episode of a pool job
+
+#define OCBA_BUDGET (NB_PARTICLE/2)          // Re-evaluations of the bests per iteration (OCBA)
+#define OCBA_SELECT_BUDGET (5*NB_PARTICLE/2) // Evaluations of the final selection (OCBA)
+#define CHECKPOINT_FILE "pso_checkpoint.bin" // State of pso() saved at each iteration (RESUME)
+#define CACHE_FILE "pso_cache.bin"           // Fitness cache kept across the iterations and the runs (CACHE)
+#define CACHE_QUANTUM 1.0                    // Size of a cell of the fitness cache in each dimension
+#define CACHE_SAMPLES 3                      // Samples after which the mean of a cell is used
+#ifndef FITNESS_SIGNATURE
+#define FITNESS_SIGNATURE __DATE__ " " __TIME__  // Version of fitness(), with the world it keys the cache (default: the build)
+#endif
+#define SURROGATE_NOISE 0.1                  // Noise of the fitness relative to its variance (SURROGATE)
+#define SURROGATE_KAPPA 2.0                  // A particle is unpromising if mean+KAPPA*sd < neighborhood best
+#define SURROGATE_NUDGES 2                   // Moves halfway to the neighborhood best before skipping a particle
+#define SURROGATE_MIN_POINTS (2*(DATASIZE))  // Evaluations before the first prediction
+#define CRN_SCENARIOS 1                      // Scenarios of each iteration, shared by all the particles (CRN)
+#define CMAES_RESTARTS CMAES_BIPOP           // Restart strategy of CMA-ES (CMAES_IPOP or CMAES_BIPOP)
+#define MIGRATION_INTERVAL 5                 // Iterations between two migrations of the best particles (PSO_ISLAND)
+#define MIGRATION_TOPOLOGY ISLAND_RING       // Islands reached by a migration (ISLAND_RING or ISLAND_FULL)
+#define CURRICULUM_MIN 0.25                  // Length of the first episodes, fraction of the full episode (CURRICULUM)
+#define ARCHIVE_FILE "pso_archive.bin"       // Bests of the previous runs and their fitness, seeding the swarm (WARM_START)
+#define ARCHIVE_SIZE 20                      // Bests kept in the archive
+#define ARCHIVE_SHARE 0.5                    // Share of the particles seeded from the archive, the others are random
+#define ARCHIVE_SPREAD 0.1                   // Perturbation of the seeded particles, fraction of the initialization domain
+#ifndef N_OBJECTIVES
+#define N_OBJECTIVES 1                       // Objectives of MULTI_OBJECTIVE
+#endif
+#define PARETO_FILE "pso_pareto.csv"         // Front of the trade-offs, saved at each iteration (MULTI_OBJECTIVE)
+#define PARETO_SIZE 100                      // Points kept in the front (MULTI_OBJECTIVE)
+
+static pso_pool_t pool;             // Parallel evaluation on worker simulations (see common/pso_pool.h)
+static island_t island;             // Swarm of an island model with other supervisors (see common/island.h)
+static fcache_t cache;              // Fitness of the particles already evaluated (see common/fitness_cache.h)
+static warm_start_t archive;        // Bests of the previous runs (see common/warm_start.h)
+static surrogate_t surrogate;       // Model of the fitness (see common/surrogate.h)
+static pareto_t front;              // Non-dominated trade-offs of the runs (see common/pareto.h)
+static uint64_t episode_seed[ROBOTS];       // Seed of the episode of each particle, last double of its job (see common/rng.h)
+static double racing_threshold[ROBOTS];     // Fitness to beat by the particles of fitness() (-INFINITY: full episode)
+static float episode_length = 1.0f;         // Fraction of their episode run by the robots in fitness() (CURRICULUM)
+static double objectives[ROBOTS][N_OBJECTIVES];  // Objectives of the particles of fitness() (MULTI_OBJECTIVE)
+
+/// Fitness of the ROBOTS particles of weights in the world of the supervisor
+void fitness(double weights[ROBOTS][DATASIZE], double fit[ROBOTS]);
+
+// Evaluate n <= ROBOTS particles in this simulation (local evaluation of the pool), N_OBJECTIVES values
+// per particle with MULTI_OBJECTIVE
+static void evaluate_batch(const double *particles, int n, double *fit) {
+  double particles_sim[ROBOTS][DATASIZE];
+  double fit_sim[ROBOTS];
+  int j,k;                   // FOR-loop counters
+  for (j=0;j<ROBOTS;j++) {
+    for (k=0;k<DATASIZE;k++)
+      particles_sim[j][k] = particles[(j<n ? j : n-1)*JOBSIZE+k];  // unused slots repeat the last particle
+    racing_threshold[j] = RACING ? particles[(j<n ? j : n-1)*JOBSIZE+DATASIZE] : -INFINITY;
+    episode_seed[j] = particles[(j<n ? j : n-1)*JOBSIZE+JOBSIZE-1];
+  }
+  // One length for the batch, the longest (the fitness is a mean per step)
+  episode_length = 1.0f;
+  if (CURRICULUM) {
+    episode_length = 0.0f;
+    for (j=0;j<n;j++)
+      episode_length = fmax(episode_length,particles[j*JOBSIZE+DATASIZE+RACING]);
+  }
+  TIMING_SCOPE("fitness") fitness(particles_sim,fit_sim);
+  for (j=0;j<n;j++) {
+    if (MULTI_OBJECTIVE) {
+      for (k=0;k<N_OBJECTIVES;k++)
+        fit[j*N_OBJECTIVES+k] = objectives[j][k];
+    }
+    else
+      fit[j] = fit_sim[j];
+  }
+}
+
+// Display the progress of the PSO (label 0: iteration, label 1: evaluations)
+static void show_label(int id, const char *text) {
+  if (id == 0)
+    wb_supervisor_set_label(0,text,0.01,0.01,0.1,0xffffff,0,FONT);
+  else
+    wb_supervisor_set_label(1,text,0.01,0.05,0.05,0xffffff,0,FONT);
+}
+
+// Seeds of the next ROBOTS episodes outside of the PSO (final runs)
+static void next_episodes(uint64_t seed) {
+  static uint64_t episode = 0;
+  int k;
+  for (k=0;k<ROBOTS;k++) {
+    episode_seed[k] = rng_derive(seed,RNG_STREAM(RNG_FINAL,episode++));
+    racing_threshold[k] = -INFINITY;
+  }
+  episode_length = 1.0f;
+}
+
+// Configuration of the PSO from the tunable parameters, on the domain of the supervisor (see common/pso.h)
+static void pso_config_from_options(pso_config_t *cfg, const double *init_min, const double *init_max,
+                                    const double *limit_min, const double *limit_max, uint64_t seed) {
+  pso_config_default(cfg,NB_PARTICLE,DATASIZE);
+  cfg->n_neighbours = NB_NEIGHBOURS;
+  cfg->lweight = LWEIGHT;
+  cfg->nbweight = NBWEIGHT;
+  cfg->damping = DAMPING;
+  cfg->vmax = VMAX;
+  cfg->iterations = ITS_COEFF*ITS_PSO;
+  cfg->async = ASYNC;
+  cfg->cmaes = CMAES ? CMAES_RESTARTS : CMAES_NONE;
+  cfg->seed = seed;
+  cfg->init_min = init_min;
+  cfg->init_max = init_max;
+  if (DOMAIN_WEIGHT) {
+    cfg->limit_min = limit_min;
+    cfg->limit_max = limit_max;
+  }
+  if (WARM_START) {
+    cfg->archive = &archive;
+    cfg->archive_file = ARCHIVE_FILE;
+    cfg->archive_share = ARCHIVE_SHARE;
+    cfg->archive_spread = ARCHIVE_SPREAD;
+  }
+  cfg->noisy = NOISY;
+  cfg->ocba = OCBA;
+  cfg->ocba_budget = OCBA_BUDGET;
+  cfg->ocba_select_budget = OCBA_SELECT_BUDGET;
+  cfg->crn = CRN ? CRN_SCENARIOS : 0;
+  cfg->racing = RACING;  // The jobs carry the neighborhood best to beat (JOBSIZE)
+  cfg->curriculum = CURRICULUM;  // and the length of their episode
+  cfg->curriculum_min = CURRICULUM_MIN;
+  cfg->checkpoint = CHECKPOINT_FILE;
+  cfg->resume = RESUME;
+  if (CACHE) {
+    cfg->cache = &cache;
+    cfg->cache_file = CACHE_FILE;
+    cfg->cache_samples = CACHE_SAMPLES;
+  }
+  if (SURROGATE) {
+    cfg->surrogate = &surrogate;
+    cfg->surrogate_kappa = SURROGATE_KAPPA;
+    cfg->surrogate_nudges = SURROGATE_NUDGES;
+    cfg->surrogate_min_points = SURROGATE_MIN_POINTS;
+  }
+  cfg->island = &island;
+  cfg->migration_interval = MIGRATION_INTERVAL;
+  if (MULTI_OBJECTIVE) {
+    cfg->objectives = N_OBJECTIVES;
+    cfg->pareto = &front;
+    cfg->pareto_file = PARETO_FILE;
+  }
+  cfg->pool = &pool;
+  cfg->batch = ROBOTS;
+  cfg->fitness = evaluate_batch;
+  cfg->label = show_label;
+}
+
+// Open the pool and the island, and load the results of the previous runs. A worker of a pool evaluates the
+// particles of its coordinator until it is done and returns 1, -1 if the pool or the island cannot be opened
+static int pso_options_open(const double prior[DATASIZE], const char *const *objective_names) {
+  char file[128];  // File of the island (see common/island.h)
+
+  // PSO_ROLE=worker: evaluate the particles of the coordinator until it is done (see common/pso_pool.h)
+  if (pso_pool_open(&pool))
+    return -1;
+  pool.objectives = MULTI_OBJECTIVE ? N_OBJECTIVES : 1;  // Values returned per particle by evaluate_batch()
+  if (pool.role == PSO_POOL_WORKER) {
+    pso_pool_serve(&pool,JOBSIZE,ROBOTS,evaluate_batch);
+    pso_pool_close(&pool);
+    wb_robot_cleanup();
+    return 1;
+  }
+
+  // PSO_ISLAND=i/n: island i of n swarms in as many Webots instances (see common/island.h)
+  if (island_open(&island,MIGRATION_TOPOLOGY))
+    return -1;
+
+  // Fitness of the particles of the previous runs of this island (see common/fitness_cache.h)
+  fcache_init(&cache,DATASIZE,CACHE_QUANTUM,fcache_signature(FITNESS_SIGNATURE,wb_robot_get_world_path()));
+  if (CACHE)
+    fcache_load(&cache,island_file(&island,CACHE_FILE,file,sizeof(file)));
+  surrogate_init(&surrogate,DATASIZE,SURROGATE_NOISE);
+  pareto_init(&front,DATASIZE,N_OBJECTIVES,PARETO_SIZE,objective_names);
+
+  // Bests of the previous runs, else the hand-tuned weights (see common/warm_start.h)
+  warm_start_init(&archive,DATASIZE,ARCHIVE_SIZE);
+  if (WARM_START && warm_start_load(&archive,island_file(&island,ARCHIVE_FILE,file,sizeof(file))))
+    warm_start_add(&archive,prior,0,0.0,0.0);
+  return 0;
+}
+
+// Stop the workers and leave the island model
+static void pso_options_close(void) {
+  pso_pool_close(&pool);
+  island_close(&island);
+}
+
+#endif
@@ -0,0 +1,505 @@
+/*****************************************************************************/
+/* File:         pso_pool.c                                                  */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Parallel evaluation of the PSO particles: a coordinator     */
+/*               dispatches them to worker simulations over a Unix socket    */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pso_pool.h"
+
+/* The coordinator is the supervisor running pso(). Each worker is the supervisor of another
+   (headless) Webots instance of the same world: it connects to the coordinator and evaluates
+   the jobs it receives with its own fitness(). A job is a batch of at most ROBOTS particles.
+   The coordinator keeps every worker busy, evaluates a job itself while waiting, collects the
+   results in any order and gives the job of a lost worker to another one. Workers can join
+   at any time; without worker everything is evaluated by the coordinator. A worker whose job
+   runs PSO_POOL_DEADLINE times longer than the longest job so far is hung: it is dropped as a
+   lost one and its job is given to another worker or evaluated here. A particle has
+   pool->objectives fitness values (multi-objective PSO): a worker returning another number is
+   dropped, as a worker built with another DATASIZE. */
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define JOB_PENDING  0
+#define JOB_RUNNING  1
+#define JOB_DONE     2
+
+static int write_full(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t w = write(fd, p, len);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return 1;
+        p += w;
+        len -= w;
+    }
+    return 0;
+}
+
+static int read_full(int fd, void *buf, size_t len) {
+    char *p = buf;
+    while (len > 0) {
+        ssize_t r = read(fd, p, len);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return 1;
+        p += r;
+        len -= r;
+    }
+    return 0;
+}
+
+static double now_s(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1e-9*t.tv_nsec;
+}
+
+static int send_msg(int fd, int type, int job, int n, int size, const double *data, int n_data) {
+    pso_pool_msg_t msg = {type, job, n, size};
+    return write_full(fd, &msg, sizeof(msg)) || write_full(fd, data, n_data*sizeof(double));
+}
+
+/**
+ * @brief      Open the pool according to the environment: PSO_ROLE ("coordinator" or "worker", no pool
+ *             if unset) and PSO_SOCKET (path of the Unix socket, PSO_POOL_SOCKET by default)
+ *
+ * @param      pool  The pool
+ *
+ * @return     1 if the role is set but the socket cannot be opened
+ */
+int pso_pool_open(pso_pool_t *pool) {
+    const char *role = getenv("PSO_ROLE");
+    const char *path = getenv("PSO_SOCKET");
+    struct sockaddr_un addr;
+    int i;
+
+    memset(pool, 0, sizeof(*pool));
+    pool->fd = -1;
+    pool->objectives = 1;
+    if (role == NULL || role[0] == '\0')
+        return 0;
+    if (strcmp(role, "coordinator") == 0)
+        pool->role = PSO_POOL_COORDINATOR;
+    else if (strcmp(role, "worker") == 0)
+        pool->role = PSO_POOL_WORKER;
+    else {
+        printf("PSO pool: unknown PSO_ROLE %s\n", role);
+        return 1;
+    }
+
+    if (path == NULL || path[0] == '\0')
+        path = PSO_POOL_SOCKET;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        printf("PSO pool: socket path too long %s\n", path);
+        pool->role = PSO_POOL_NONE;
+        return 1;
+    }
+    strcpy(pool->path, path);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    // A worker that died must not kill the coordinator (and vice versa)
+    signal(SIGPIPE, SIG_IGN);
+
+    pool->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (pool->fd < 0) {
+        printf("PSO pool: cannot create a socket\n");
+        pool->role = PSO_POOL_NONE;
+        return 1;
+    }
+
+    if (pool->role == PSO_POOL_COORDINATOR) {
+        unlink(path);
+        if (bind(pool->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(pool->fd, PSO_POOL_MAX_WORKERS) != 0) {
+            printf("PSO pool: cannot listen on %s\n", path);
+            pso_pool_close(pool);
+            return 1;
+        }
+        fcntl(pool->fd, F_SETFL, fcntl(pool->fd, F_GETFL) | O_NONBLOCK);
+        printf("PSO pool: coordinator listening on %s\n", path);
+        return 0;
+    }
+
+    // Worker: the coordinator may not be started yet
+    for (i = 0; i < PSO_POOL_CONNECT_S*10; i++) {
+        struct timespec wait = {0, 100000000};
+        if (connect(pool->fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            printf("PSO pool: worker connected to %s\n", path);
+            return 0;
+        }
+        nanosleep(&wait, NULL);
+    }
+    printf("PSO pool: no coordinator on %s\n", path);
+    pso_pool_close(pool);
+    return 1;
+}
+
+static void accept_workers(pso_pool_t *pool) {
+    int fd;
+    while (pool->n_workers < PSO_POOL_MAX_WORKERS && (fd = accept(pool->fd, NULL, NULL)) >= 0) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+        pool->worker_fd[pool->n_workers] = fd;
+        pool->worker_job[pool->n_workers] = -1;
+        pool->n_workers++;
+        printf("PSO pool: worker %d joined\n", pool->n_workers);
+    }
+}
+
+static void drop_worker(pso_pool_t *pool, int w, char *state) {
+    if (state != NULL && pool->worker_job[w] >= 0)
+        state[pool->worker_job[w]] = JOB_PENDING;
+    close(pool->worker_fd[w]);
+    pool->n_workers--;
+    pool->worker_fd[w] = pool->worker_fd[pool->n_workers];
+    pool->worker_job[w] = pool->worker_job[pool->n_workers];
+    pool->worker_start[w] = pool->worker_start[pool->n_workers];
+    printf("PSO pool: worker lost, %d left\n", pool->n_workers);
+}
+
+/* Send job j of n particles to worker w (1: failed) */
+static int send_job(pso_pool_t *pool, int w, int j, const double *particles, int n, int size) {
+    if (send_msg(pool->worker_fd[w], PSO_POOL_JOB, j, n, size, particles, n*size))
+        return 1;
+    pool->worker_job[w] = j;
+    pool->worker_start[w] = now_s();
+    return 0;
+}
+
+/* Time of the job of worker w, returned now */
+static void job_done(pso_pool_t *pool, int w) {
+    double s = now_s() - pool->worker_start[w];
+    if (s > pool->job_s)
+        pool->job_s = s;
+    pool->worker_job[w] = -1;
+}
+
+/* Index of a worker past the deadline of its job (-1: none) */
+static int hung_worker(const pso_pool_t *pool) {
+    double now = now_s();
+    int w;
+    for (w = 0; w < pool->n_workers; w++)
+        if (pool->worker_job[w] >= 0 && pool->job_s > 0 && now - pool->worker_start[w] > PSO_POOL_DEADLINE*pool->job_s)
+            return w;
+    return -1;
+}
+
+/**
+ * @brief      Evaluate particles on the workers of the pool and in this simulation
+ *
+ * @param      pool       The pool (any role, everything is evaluated locally if it is not a coordinator)
+ * @param[in]  particles  The n particles, particles[i*size + k]
+ * @param[in]  n          Number of particles
+ * @param[in]  size       Number of doubles per particle
+ * @param[in]  batch      Number of particles evaluated by one simulation (ROBOTS)
+ * @param      fit        The n*pool->objectives fitness values
+ * @param[in]  local      Evaluation in this simulation
+ *
+ * @return     1 if it fails (out of memory)
+ */
+int pso_pool_evaluate(pso_pool_t *pool, const double *particles, int n, int size, int batch, double *fit,
+                      pso_pool_fitness_t local) {
+    int n_jobs = (n + batch - 1)/batch;
+    int n_done = 0, next = 0;
+    int obj = pool->objectives;
+    int j, w, n_ready;
+    double elapsed;
+    char *state = calloc(n_jobs, 1);
+    double *result = malloc(batch*obj*sizeof(double));
+    struct pollfd fds[PSO_POOL_MAX_WORKERS];
+    pso_pool_msg_t msg;
+
+    if (state == NULL || result == NULL) {
+        free(state);
+        free(result);
+        return 1;
+    }
+
+    while (n_done < n_jobs) {
+        if (pool->role == PSO_POOL_COORDINATOR)
+            accept_workers(pool);
+        while ((w = hung_worker(pool)) >= 0)
+            drop_worker(pool, w, state);
+
+        // Give a pending job to every idle worker
+        for (w = 0; w < pool->n_workers; w++) {
+            if (pool->worker_job[w] >= 0)
+                continue;
+            for (j = 0; j < n_jobs && state[(next + j) % n_jobs] != JOB_PENDING; j++)
+                ;
+            if (j == n_jobs)
+                break;
+            j = (next + j) % n_jobs;
+            next = (j + 1) % n_jobs;
+            int count = (j + 1)*batch <= n ? batch : n - j*batch;
+            if (send_job(pool, w, j, &particles[j*batch*size], count, size)) {
+                drop_worker(pool, w--, state);
+                continue;
+            }
+            state[j] = JOB_RUNNING;
+        }
+
+        // Collect the results of the workers: without waiting if a job is pending, so that the
+        // workers done get their next job before this simulation evaluates one
+        for (j = 0; j < n_jobs && state[j] != JOB_PENDING; j++)
+            ;
+        for (w = 0; w < pool->n_workers; w++) {
+            fds[w].fd = pool->worker_fd[w];
+            fds[w].events = POLLIN;
+            fds[w].revents = 0;
+        }
+        n_ready = pool->n_workers > 0 ? poll(fds, pool->n_workers, j < n_jobs ? 0 : 1000) : 0;
+
+        // Nothing came and still a pending job: evaluate it here while the workers run
+        if (n_ready <= 0) {
+            if (j < n_jobs) {
+                int count = (j + 1)*batch <= n ? batch : n - j*batch;
+                state[j] = JOB_RUNNING;
+                elapsed = now_s();
+                local(&particles[j*batch*size], count, &fit[j*batch*obj]);
+                elapsed = now_s() - elapsed;
+                if (elapsed > pool->job_s)
+                    pool->job_s = elapsed;
+                state[j] = JOB_DONE;
+                n_done++;
+            }
+            continue;
+        }
+        for (w = pool->n_workers - 1; w >= 0; w--) {
+            if (fds[w].revents == 0)
+                continue;
+            j = pool->worker_job[w];
+            if (read_full(fds[w].fd, &msg, sizeof(msg)) || msg.type != PSO_POOL_RESULT || msg.job != j || j < 0 ||
+                msg.n < 0 || msg.n > batch || msg.size != obj || read_full(fds[w].fd, result, msg.n*obj*sizeof(double))) {
+                drop_worker(pool, w, state);
+                continue;
+            }
+            job_done(pool, w);
+            if (state[j] != JOB_RUNNING)
+                continue;
+            memcpy(&fit[j*batch*obj], result, msg.n*obj*sizeof(double));
+            state[j] = JOB_DONE;
+            n_done++;
+        }
+    }
+
+    free(state);
+    free(result);
+    return 0;
+}
+
+/* Asynchronous evaluation: the caller submits a job to each idle worker and collects the
+   results one at a time, so that a worker gets its next job as soon as it returns one
+   (steady-state PSO, see common/pso.c). The job ids are chosen by the caller. */
+
+/**
+ * @brief      Number of idle workers (the new workers are accepted first)
+ *
+ * @param      pool  The pool (0 if it is not a coordinator)
+ *
+ * @return     The number of workers without a job
+ */
+int pso_pool_idle(pso_pool_t *pool) {
+    int w, n_idle = 0;
+
+    if (pool->role != PSO_POOL_COORDINATOR)
+        return 0;
+    accept_workers(pool);
+    for (w = 0; w < pool->n_workers; w++)
+        if (pool->worker_job[w] < 0)
+            n_idle++;
+    return n_idle;
+}
+
+/**
+ * @brief      Send a job to an idle worker
+ *
+ * @param      pool       The pool (coordinator)
+ * @param[in]  job        Id of the job (>= 0), returned by pso_pool_collect()
+ * @param[in]  particles  The n particles, particles[i*size + k]
+ * @param[in]  n          Number of particles (at most the batch of the workers)
+ * @param[in]  size       Number of doubles per particle
+ *
+ * @return     1 if no worker is idle
+ */
+int pso_pool_submit(pso_pool_t *pool, int job, const double *particles, int n, int size) {
+    int w;
+
+    for (w = 0; w < pool->n_workers; w++) {
+        if (pool->worker_job[w] >= 0)
+            continue;
+        if (send_job(pool, w, job, particles, n, size)) {
+            drop_worker(pool, w--, NULL);
+            continue;
+        }
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief      Wait for the result of a submitted job
+ *
+ * @param      pool        The pool (coordinator)
+ * @param[in]  timeout_ms  Maximum waiting time [ms]
+ * @param[in]  batch       Maximum number of particles per job
+ * @param[out] job         Id of the job
+ * @param[out] fit         Its fitness values (pool->objectives per particle)
+ *
+ * @return     The number of fitness values, 0 if no result came, -1 if the worker of the job was
+ *             lost or is hung (the job must be submitted again)
+ */
+int pso_pool_collect(pso_pool_t *pool, int timeout_ms, int batch, int *job, double *fit) {
+    struct pollfd fds[PSO_POOL_MAX_WORKERS];
+    pso_pool_msg_t msg;
+    int w;
+
+    if ((w = hung_worker(pool)) >= 0) {
+        *job = pool->worker_job[w];
+        drop_worker(pool, w, NULL);
+        return -1;
+    }
+    for (w = 0; w < pool->n_workers; w++) {
+        fds[w].fd = pool->worker_fd[w];
+        fds[w].events = POLLIN;
+        fds[w].revents = 0;
+    }
+    if (pool->n_workers == 0 || poll(fds, pool->n_workers, timeout_ms) <= 0)
+        return 0;
+    for (w = pool->n_workers - 1; w >= 0; w--) {
+        if (fds[w].revents == 0)
+            continue;
+        *job = pool->worker_job[w];
+        if (read_full(fds[w].fd, &msg, sizeof(msg)) || msg.type != PSO_POOL_RESULT || msg.job != *job || *job < 0 ||
+            msg.n < 0 || msg.n > batch || msg.size != pool->objectives ||
+            read_full(fds[w].fd, fit, msg.n*pool->objectives*sizeof(double))) {
+            drop_worker(pool, w, NULL);
+            if (*job >= 0)
+                return -1;
+            continue;
+        }
+        job_done(pool, w);
+        return msg.n;
+    }
+    return 0;
+}
+
+/**
+ * @brief      Worker loop: evaluate the jobs of the coordinator until it closes the connection
+ *
+ * @param      pool     The pool (worker)
+ * @param[in]  size     Number of doubles per particle (must be the one of the coordinator)
+ * @param[in]  batch    Maximum number of particles per job (ROBOTS)
+ * @param[in]  fitness  Evaluation in this simulation (pool->objectives values per particle)
+ *
+ * @return     1 if the connection was lost or a job is invalid, 0 when the coordinator is done
+ */
+int pso_pool_serve(pso_pool_t *pool, int size, int batch, pso_pool_fitness_t fitness) {
+    double *particles = malloc((size_t)batch*size*sizeof(double));
+    double *fit = malloc(batch*pool->objectives*sizeof(double));
+    pso_pool_msg_t msg;
+    int ret = 1;
+
+    while (particles != NULL && fit != NULL) {
+        if (read_full(pool->fd, &msg, sizeof(msg))) {
+            ret = 0;
+            printf("PSO pool: coordinator done\n");
+            break;
+        }
+        if (msg.type != PSO_POOL_JOB || msg.size != size || msg.n < 1 || msg.n > batch) {
+            printf("PSO pool: invalid job (%d particles of size %d, expected %d)\n", msg.n, msg.size, size);
+            break;
+        }
+        if (read_full(pool->fd, particles, (size_t)msg.n*size*sizeof(double)))
+            break;
+        fitness(particles, msg.n, fit);
+        if (send_msg(pool->fd, PSO_POOL_RESULT, msg.job, msg.n, pool->objectives, fit, msg.n*pool->objectives))
+            break;
+    }
+
+    free(particles);
+    free(fit);
+    return ret;
+}
+
+/**
+ * @brief      Close the connections (the workers of a coordinator stop)
+ */
+void pso_pool_close(pso_pool_t *pool) {
+    int w;
+    for (w = 0; w < pool->n_workers; w++)
+        close(pool->worker_fd[w]);
+    pool->n_workers = 0;
+    if (pool->fd >= 0)
+        close(pool->fd);
+    if (pool->role == PSO_POOL_COORDINATOR)
+        unlink(pool->path);
+    pool->fd = -1;
+    pool->role = PSO_POOL_NONE;
+}
+
+#else
+
+/* No Unix sockets: every particle is evaluated in this simulation */
+
+int pso_pool_open(pso_pool_t *pool) {
+    memset(pool, 0, sizeof(*pool));
+    pool->fd = -1;
+    pool->objectives = 1;
+    if (getenv("PSO_ROLE") != NULL)
+        printf("PSO pool: not available on Windows\n");
+    return 0;
+}
+
+int pso_pool_evaluate(pso_pool_t *pool, const double *particles, int n, int size, int batch, double *fit,
+                      pso_pool_fitness_t local) {
+    int j;
+    for (j = 0; j < n; j += batch)
+        local(&particles[j*size], j + batch <= n ? batch : n - j, &fit[j*pool->objectives]);
+    return 0;
+}
+
+int pso_pool_idle(pso_pool_t *pool) {
+    (void)pool;
+    return 0;
+}
+
+int pso_pool_submit(pso_pool_t *pool, int job, const double *particles, int n, int size) {
+    (void)pool; (void)job; (void)particles; (void)n; (void)size;
+    return 1;
+}
+
+int pso_pool_collect(pso_pool_t *pool, int timeout_ms, int batch, int *job, double *fit) {
+    (void)pool; (void)timeout_ms; (void)batch; (void)job; (void)fit;
+    return 0;
+}
+
+int pso_pool_serve(pso_pool_t *pool, int size, int batch, pso_pool_fitness_t fitness) {
+    (void)pool; (void)size; (void)batch; (void)fitness;
+    return 1;
+}
+
+void pso_pool_close(pso_pool_t *pool) {
+    (void)pool;
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef PSO_POOL_H
+#define PSO_POOL_H
+
+#include <stdint.h>
+
+#define PSO_POOL_SOCKET       "/tmp/dis_pso_pool.sock"  // Default Unix socket of the coordinator (PSO_SOCKET)
+#define PSO_POOL_MAX_WORKERS  64                        // Maximum number of workers of a coordinator
+#define PSO_POOL_CONNECT_S    60                        // A worker retries to connect during this time [s]
+#define PSO_POOL_DEADLINE     5.0                       // A worker is hung once its job runs this many times the longest job so far
+
+/* Roles, selected with the environment variable PSO_ROLE ("coordinator" or "worker") */
+#define PSO_POOL_NONE         0    // Every particle is evaluated in this simulation
+#define PSO_POOL_COORDINATOR  1    // Runs the PSO and dispatches the evaluations to the workers
+#define PSO_POOL_WORKER       2    // Evaluates the particles sent by the coordinator
+
+/* Message types */
+#define PSO_POOL_JOB          1    // Coordinator -> worker: n particles of size doubles
+#define PSO_POOL_RESULT       2    // Worker -> coordinator: n*size fitness values
+
+typedef struct
+{
+  uint32_t type;
+  int32_t job;            // Job id, copied in the result
+  int32_t n;              // Number of particles
+  int32_t size;           // Number of doubles per particle (DATASIZE, objectives of a result)
+} pso_pool_msg_t;
+
+/// Evaluate n particles (n <= batch, particles[i*size + k]) in this simulation
+typedef void (*pso_pool_fitness_t)(const double *particles, int n, double *fit);
+
+typedef struct
+{
+  int role;               // PSO_POOL_NONE, PSO_POOL_COORDINATOR or PSO_POOL_WORKER
+  char path[108];         // Path of the Unix socket
+  int fd;                 // Listening socket (coordinator) or connection (worker)
+  int objectives;         // Fitness values per particle (1, or the objectives of a multi-objective PSO)
+  int n_workers;
+  int worker_fd[PSO_POOL_MAX_WORKERS];
+  int worker_job[PSO_POOL_MAX_WORKERS];  // Job evaluated by the worker (-1 if idle)
+  double worker_start[PSO_POOL_MAX_WORKERS];  // Time the job was sent [s]
+  double job_s;           // Longest job so far [s] (0: no deadline yet)
+} pso_pool_t;
+
+/// Documentation in c file
+int pso_pool_open(pso_pool_t *pool);
+int pso_pool_evaluate(pso_pool_t *pool, const double *particles, int n, int size, int batch, double *fit,
+                      pso_pool_fitness_t local);
+int pso_pool_idle(pso_pool_t *pool);
+int pso_pool_submit(pso_pool_t *pool, int job, const double *particles, int n, int size);
+int pso_pool_collect(pso_pool_t *pool, int timeout_ms, int batch, int *job, double *fit);
+int pso_pool_serve(pso_pool_t *pool, int size, int batch, pso_pool_fitness_t fitness);
+void pso_pool_close(pso_pool_t *pool);
+
+#endif
@@ -0,0 +1,110 @@
+/*****************************************************************************/
+/* File:         rng.c                                                       */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Reproducible random streams (xoshiro256**) of the PSO and   */
+/*               of its episodes, derived from one master seed               */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rng.h"
+
+/* Every random number of a run comes from a stream of its own: each particle of the swarm,
+   each evaluation and the spawn positions and noise of each episode. A stream is seeded by
+   hashing (splitmix64) the master seed with the kind and id of the stream, so that it does
+   not depend on the order in which the streams are used: the swarm is the same whether the
+   episodes run here, on the workers of the pool or in another order. The global rand() is
+   not used. */
+
+#define GOLDEN  0x9E3779B97F4A7C15ULL
+
+/* Finalizer of splitmix64 */
+static uint64_t mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * @brief      Seed a stream
+ *
+ * @param[out] r       The stream
+ * @param[in]  seed    The master seed (or the seed of an episode)
+ * @param[in]  stream  The stream, RNG_STREAM(kind, id)
+ */
+void rng_init(rng_t *r, uint64_t seed, uint64_t stream) {
+    uint64_t z = seed ^ mix(stream + GOLDEN);
+    int k;
+
+    for (k = 0; k < 4; k++) {
+        z += GOLDEN;
+        r->s[k] = mix(z);
+    }
+    if ((r->s[0] | r->s[1] | r->s[2] | r->s[3]) == 0)
+        r->s[0] = GOLDEN;  // The only invalid state
+}
+
+/**
+ * @brief      Next 64 random bits of a stream (xoshiro256**, Blackman and Vigna)
+ */
+uint64_t rng_next(rng_t *r) {
+    uint64_t *s = r->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+/**
+ * @brief      Uniform random number in [0,1)
+ */
+double rng_uniform(rng_t *r) {
+    return (rng_next(r) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief      Seed of a sub-stream, on 53 bits so that it is exact in a double (PSO jobs)
+ *
+ * @param[in]  seed    The master seed
+ * @param[in]  stream  The stream, RNG_STREAM(kind, id)
+ *
+ * @return     The seed
+ */
+uint64_t rng_derive(uint64_t seed, uint64_t stream) {
+    rng_t r;
+    rng_init(&r, seed, stream);
+    return rng_next(&r) >> 11;
+}
+
+/**
+ * @brief      Master seed of a run: the environment variable PSO_SEED, or else the time and the
+ *             process id. It is printed so that the run can be repeated.
+ *
+ * @return     The seed
+ */
+uint64_t rng_master_seed(void) {
+    const char *env = getenv("PSO_SEED");
+    uint64_t seed;
+
+    if (env != NULL && env[0] != '\0')
+        seed = strtoull(env, NULL, 0);
+    else
+        seed = mix((uint64_t)time(NULL) ^ ((uint64_t)getpid() << 32)) >> 11;
+    printf("Master seed: %llu (PSO_SEED=%llu repeats the run)\n", (unsigned long long)seed, (unsigned long long)seed);
+    return seed;
+}
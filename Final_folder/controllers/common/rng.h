@@ -0,0 +1,29 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/* Streams, derived from one seed by their kind and id (RNG_STREAM) */
+#define RNG_PARTICLE    1         // Initialization and moves of a particle (id: particle)
+#define RNG_EVALUATION  2         // Seed of an episode (id: evaluation of the run)
+#define RNG_SPAWN       3         // Spawn positions of an episode (seed: episode)
+#define RNG_NOISE       4         // Sensor noise of a kinematic episode (seed: episode)
+#define RNG_RUN         5         // Seed of a PSO run of a supervisor (id: run)
+#define RNG_FINAL       6         // Seed of an episode of the final runs (id: episode)
+#define RNG_SCENARIO    7         // Seed of a common scenario (id: iteration << 16 | scenario)
+#define RNG_ISLAND      8         // Seed of the swarm of an island (id: island)
+#define RNG_STREAM(kind, id)  (((uint64_t)(kind) << 48) ^ (uint64_t)(id))
+
+typedef struct
+{
+  uint64_t s[4];              // State of xoshiro256**
+} rng_t;
+
+/// Documentation in c file
+void rng_init(rng_t *r, uint64_t seed, uint64_t stream);
+uint64_t rng_next(rng_t *r);
+double rng_uniform(rng_t *r);
+uint64_t rng_derive(uint64_t seed, uint64_t stream);
+uint64_t rng_master_seed(void);
+
+#endif
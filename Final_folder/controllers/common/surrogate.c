@@ -0,0 +1,191 @@
+/*****************************************************************************/
+/* File:         surrogate.c                                                 */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Gaussian process surrogate of the PSO fitness, to screen    */
+/*               the new particles before their simulation                   */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "surrogate.h"
+
+/* The particles are standardized (mean 0, standard deviation 1 in each dimension) and the
+   kernel is a squared exponential whose length scale is the median distance between the
+   points, with a variance equal to the one of the fitness values. The noise of the fitness
+   is a constant fraction of this variance. The model is refitted (O(n^3), n <= 128, a few
+   milliseconds) at the first prediction after new points. */
+
+#define MIN_POINTS  4
+
+static int compare(const void *a, const void *b) {
+    double d = *(const double *)a - *(const double *)b;
+    return (d > 0) - (d < 0);
+}
+
+static double sq_dist(const surrogate_t *s, const double *a, const double *b) {
+    double d = 0;
+    int k;
+    for (k = 0; k < s->dim; k++)
+        d += (a[k] - b[k]) * (a[k] - b[k]);
+    return d;
+}
+
+static void standardize(const surrogate_t *s, const double *x, double *z) {
+    int k;
+    for (k = 0; k < s->dim; k++)
+        z[k] = (x[k] - s->center[k]) / s->scale[k];
+}
+
+/* Solve L y = b (in place) */
+static void forward(const surrogate_t *s, double *b) {
+    int i, j;
+    for (i = 0; i < s->n; i++) {
+        for (j = 0; j < i; j++)
+            b[i] -= s->L[i][j] * b[j];
+        b[i] /= s->L[i][i];
+    }
+}
+
+/* Solve L^T y = b (in place) */
+static void backward(const surrogate_t *s, double *b) {
+    int i, j;
+    for (i = s->n - 1; i >= 0; i--) {
+        for (j = i + 1; j < s->n; j++)
+            b[i] -= s->L[j][i] * b[j];
+        b[i] /= s->L[i][i];
+    }
+}
+
+/**
+ * @brief      Initialize an empty model
+ *
+ * @param      s      The model
+ * @param[in]  dim    The dimension of the particles (at most SURROGATE_MAX_DIM)
+ * @param[in]  noise  The variance of the noise of the fitness, relative to the variance of the fitness
+ */
+void surrogate_init(surrogate_t *s, int dim, double noise) {
+    memset(s, 0, sizeof(*s));
+    s->dim = dim < SURROGATE_MAX_DIM ? dim : SURROGATE_MAX_DIM;
+    s->noise = noise;
+}
+
+/**
+ * @brief      Add an evaluation to the model (replaces the oldest one once the model is full)
+ *
+ * @param      s     The model
+ * @param[in]  x     The particle
+ * @param[in]  f     Its fitness
+ */
+void surrogate_add(surrogate_t *s, const double *x, double f) {
+    memcpy(s->x[s->next], x, s->dim * sizeof(double));
+    s->f[s->next] = f;
+    s->next = (s->next + 1) % SURROGATE_MAX_POINTS;
+    if (s->n < SURROGATE_MAX_POINTS)
+        s->n++;
+    s->fitted = 0;
+}
+
+/**
+ * @brief      Fit the model to its points
+ *
+ * @return     1 if there are too few points or the covariance is singular
+ */
+int surrogate_fit(surrogate_t *s) {
+    static double z[SURROGATE_MAX_POINTS][SURROGATE_MAX_DIM];
+    static double dist[SURROGATE_MAX_POINTS * (SURROGATE_MAX_POINTS - 1) / 2];
+    int i, j, k, m = 0;
+    double sum;
+
+    s->fitted = 0;
+    if (s->n < MIN_POINTS)
+        return 1;
+
+    // Standardization of the particles, prior of the fitness
+    for (k = 0; k < s->dim; k++) {
+        s->center[k] = 0;
+        for (i = 0; i < s->n; i++)
+            s->center[k] += s->x[i][k] / s->n;
+        s->scale[k] = 0;
+        for (i = 0; i < s->n; i++)
+            s->scale[k] += (s->x[i][k] - s->center[k]) * (s->x[i][k] - s->center[k]) / s->n;
+        s->scale[k] = s->scale[k] > 1e-12 ? sqrt(s->scale[k]) : 1;
+    }
+    s->mean = 0;
+    for (i = 0; i < s->n; i++)
+        s->mean += s->f[i] / s->n;
+    s->var = 0;
+    for (i = 0; i < s->n; i++)
+        s->var += (s->f[i] - s->mean) * (s->f[i] - s->mean) / s->n;
+    if (s->var < 1e-12)
+        s->var = 1e-12;
+
+    // Length scale: median distance between the points
+    for (i = 0; i < s->n; i++)
+        standardize(s, s->x[i], z[i]);
+    for (i = 0; i < s->n; i++)
+        for (j = 0; j < i; j++)
+            dist[m++] = sqrt(sq_dist(s, z[i], z[j]));
+    qsort(dist, m, sizeof(double), compare);
+    s->length = dist[m / 2] > 1e-6 ? dist[m / 2] : 1;
+
+    // Cholesky factorization of the covariance
+    for (i = 0; i < s->n; i++) {
+        for (j = 0; j <= i; j++) {
+            sum = s->var * exp(-sq_dist(s, z[i], z[j]) / (2 * s->length * s->length));
+            if (i == j)
+                sum += s->noise * s->var + 1e-9 * s->var;
+            for (k = 0; k < j; k++)
+                sum -= s->L[i][k] * s->L[j][k];
+            if (i == j) {
+                if (sum <= 0)
+                    return 1;
+                s->L[i][i] = sqrt(sum);
+            }
+            else
+                s->L[i][j] = sum / s->L[j][j];
+        }
+    }
+    for (i = 0; i < s->n; i++)
+        s->alpha[i] = s->f[i] - s->mean;
+    forward(s, s->alpha);
+    backward(s, s->alpha);
+    s->fitted = 1;
+    return 0;
+}
+
+/**
+ * @brief      Predict the fitness of a particle (the model is refitted if needed)
+ *
+ * @param      s     The model
+ * @param[in]  x     The particle
+ * @param[out] mean  The predicted fitness
+ * @param[out] sd    Its standard deviation (without the noise of the fitness)
+ *
+ * @return     1 if the model cannot predict (too few points)
+ */
+int surrogate_predict(surrogate_t *s, const double *x, double *mean, double *sd) {
+    double z[SURROGATE_MAX_DIM], zi[SURROGATE_MAX_DIM], kx[SURROGATE_MAX_POINTS];
+    double var;
+    int i;
+
+    if (!s->fitted && surrogate_fit(s))
+        return 1;
+    standardize(s, x, z);
+    *mean = s->mean;
+    for (i = 0; i < s->n; i++) {
+        standardize(s, s->x[i], zi);
+        kx[i] = s->var * exp(-sq_dist(s, z, zi) / (2 * s->length * s->length));
+        *mean += kx[i] * s->alpha[i];
+    }
+    forward(s, kx);
+    var = s->var;
+    for (i = 0; i < s->n; i++)
+        var -= kx[i] * kx[i];
+    *sd = var > 0 ? sqrt(var) : 0;
+    return 0;
+}
@@ -0,0 +1,32 @@
+#ifndef SURROGATE_H
+#define SURROGATE_H
+
+#define SURROGATE_MAX_POINTS  128      // Last evaluations kept in the model
+#define SURROGATE_MAX_DIM     32       // Maximum dimension of a particle (DATASIZE)
+
+/// Gaussian process over the last evaluations (particle, fitness) of a PSO
+typedef struct
+{
+  int dim;
+  double noise;               // Variance of the noise of the fitness, relative to the variance of the fitness
+  int n;                      // Number of points
+  int next;                   // Next point replaced once the model is full
+  double x[SURROGATE_MAX_POINTS][SURROGATE_MAX_DIM];
+  double f[SURROGATE_MAX_POINTS];
+
+  /* Fit of the points (surrogate_fit()) */
+  int fitted;
+  double center[SURROGATE_MAX_DIM], scale[SURROGATE_MAX_DIM];  // Standardization of the particles
+  double length;              // Length scale of the kernel (standardized particles)
+  double mean, var;           // Prior mean and variance of the fitness
+  double L[SURROGATE_MAX_POINTS][SURROGATE_MAX_POINTS];  // Cholesky factor of the covariance of the points
+  double alpha[SURROGATE_MAX_POINTS];                    // Covariance^-1 (f - mean)
+} surrogate_t;
+
+/// Documentation in c file
+void surrogate_init(surrogate_t *s, int dim, double noise);
+void surrogate_add(surrogate_t *s, const double *x, double f);
+int surrogate_fit(surrogate_t *s);
+int surrogate_predict(surrogate_t *s, const double *x, double *mean, double *sd);
+
+#endif
@@ -0,0 +1,299 @@
+/*****************************************************************************/
+/* File:         telemetry.c                                                 */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Live telemetry of the controllers in a POSIX shared memory  */
+/*               segment (one seqlock protected slot per controller)         */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "telemetry.h"
+
+/* Each controller owns one slot of the segment and is its only writer. Publishing a step is
+   a plain copy into the mapped memory surrounded by two increments of the slot sequence number,
+   so the hot path does not make any system call. A reader copies the slot and retries if the
+   sequence number was odd (write in progress) or changed during the copy. */
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define READ_RETRIES  1000    // A writer killed in the middle of a write leaves the slot odd forever
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+static int pid_alive(int32_t pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno != ESRCH);
+}
+
+/**
+ * @brief      Claim a slot of the segment: a free slot, or the slot left by a dead controller of the same name
+ *
+ * @return     The slot or NULL if the segment is full
+ */
+static telemetry_slot_t* claim_slot(telemetry_segment_t *seg, const char *name) {
+    int32_t me = getpid();
+    int pass, i;
+
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < TELEMETRY_MAX_SLOTS; i++) {
+            telemetry_slot_t *slot = &seg->slots[i];
+            int32_t owner = slot->pid;
+
+            // First pass: reuse the slot of a previous run of this controller
+            if (pass == 0 && strncmp(slot->name, name, TELEMETRY_NAME_LEN) != 0)
+                continue;
+            if (owner != 0 && pid_alive(owner))
+                continue;
+            if (__atomic_compare_exchange_n(&slot->pid, &owner, me, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+                return slot;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief      Map the telemetry segment (created if needed) and claim a slot for the controller
+ *
+ * @param      t     The telemetry of the controller
+ * @param[in]  name  Name displayed by the monitor (e.g. wb_robot_get_name())
+ *
+ * @return     1 if it fails (the telemetry is then disabled and the other functions do nothing)
+ */
+int telemetry_open(telemetry_t *t, const char *name) {
+    uint32_t zero = 0;
+    int fd;
+
+    memset(t, 0, sizeof(*t));
+    t->state.x = t->state.y = t->state.heading = NAN;
+    t->state.fsm_state = -1;
+    t->state.fitness = t->state.best_fitness = NAN;
+
+    fd = shm_open(TELEMETRY_SHM_NAME, O_RDWR | O_CREAT, 0666);
+    if (fd < 0 || ftruncate(fd, sizeof(telemetry_segment_t)) != 0) {
+        printf("Telemetry disabled: cannot create %s\n", TELEMETRY_SHM_NAME);
+        if (fd >= 0)
+            close(fd);
+        return 1;
+    }
+    t->seg = mmap(NULL, sizeof(telemetry_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (t->seg == MAP_FAILED) {
+        t->seg = NULL;
+        printf("Telemetry disabled: cannot map %s\n", TELEMETRY_SHM_NAME);
+        return 1;
+    }
+
+    // The first controller initializes the (zero filled) segment
+    if (__atomic_compare_exchange_n(&t->seg->magic, &zero, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        t->seg->version = TELEMETRY_VERSION;
+        t->seg->n_slots = TELEMETRY_MAX_SLOTS;
+        t->seg->slot_size = sizeof(telemetry_slot_t);
+        __atomic_store_n(&t->seg->magic, TELEMETRY_MAGIC, __ATOMIC_RELEASE);
+    }
+    while (__atomic_load_n(&t->seg->magic, __ATOMIC_ACQUIRE) == 1)
+        ;
+    if (t->seg->magic != TELEMETRY_MAGIC || t->seg->version != TELEMETRY_VERSION ||
+        t->seg->slot_size != sizeof(telemetry_slot_t)) {
+        printf("Telemetry disabled: %s has another layout (remove it)\n", TELEMETRY_SHM_NAME);
+        telemetry_close(t);
+        return 1;
+    }
+
+    t->slot = claim_slot(t->seg, name);
+    if (t->slot == NULL) {
+        printf("Telemetry disabled: more than %d controllers\n", TELEMETRY_MAX_SLOTS);
+        telemetry_close(t);
+        return 1;
+    }
+
+    __atomic_add_fetch(&t->slot->seq, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    strncpy(t->slot->name, name, TELEMETRY_NAME_LEN - 1);
+    t->slot->name[TELEMETRY_NAME_LEN - 1] = '\0';
+    t->slot->state = t->state;
+    __atomic_add_fetch(&t->slot->seq, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief      Update the neighbor table with a new range and bearing measurement
+ */
+void telemetry_neighbor(telemetry_t *t, int id, double range, double bearing) {
+    telemetry_state_t *s = &t->state;
+    int i;
+
+    for (i = 0; i < s->n_neighbors && s->neighbors[i].id != id; i++)
+        ;
+    if (i == s->n_neighbors) {
+        if (s->n_neighbors == TELEMETRY_MAX_NEIGHBORS)
+            return;
+        s->n_neighbors++;
+        s->neighbors[i].id = id;
+    }
+    s->neighbors[i].range = range;
+    s->neighbors[i].bearing = bearing;
+    s->neighbors[i].time = s->time;
+}
+
+/**
+ * @brief      Set the last fitness and update the best one
+ */
+void telemetry_fitness(telemetry_t *t, double fitness) {
+    t->state.fitness = fitness;
+    if (isnan(t->state.best_fitness) || fitness > t->state.best_fitness)
+        t->state.best_fitness = fitness;
+}
+
+/**
+ * @brief      Publish the state of the controller for this step (no system call)
+ */
+void telemetry_publish(telemetry_t *t) {
+    double now = now_us();
+
+    if (t->last_publish_us > 0) {
+        t->state.step_us = now - t->last_publish_us;
+        if (t->state.step_us > t->state.step_max_us)
+            t->state.step_max_us = t->state.step_us;
+    }
+    t->last_publish_us = now;
+    t->state.step++;
+
+    if (t->slot == NULL)
+        return;
+
+    __atomic_add_fetch(&t->slot->seq, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    t->slot->state = t->state;
+    __atomic_add_fetch(&t->slot->seq, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief      Release the slot of the controller and unmap the segment
+ */
+void telemetry_close(telemetry_t *t) {
+    if (t->slot != NULL)
+        __atomic_store_n(&t->slot->pid, 0, __ATOMIC_RELEASE);
+    if (t->seg != NULL)
+        munmap(t->seg, sizeof(telemetry_segment_t));
+    t->slot = NULL;
+    t->seg = NULL;
+}
+
+/**
+ * @brief      Map the telemetry segment read only (monitor side)
+ *
+ * @return     The segment or NULL if no controller created it
+ */
+const telemetry_segment_t* telemetry_attach(void) {
+    const telemetry_segment_t *seg;
+    struct stat st;
+    int fd = shm_open(TELEMETRY_SHM_NAME, O_RDONLY, 0);
+
+    if (fd < 0)
+        return NULL;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(telemetry_segment_t)) {
+        close(fd);
+        return NULL;
+    }
+    seg = mmap(NULL, sizeof(telemetry_segment_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (seg == MAP_FAILED)
+        return NULL;
+    if (seg->magic != TELEMETRY_MAGIC || seg->version != TELEMETRY_VERSION || seg->slot_size != sizeof(telemetry_slot_t)) {
+        munmap((void *)seg, sizeof(telemetry_segment_t));
+        return NULL;
+    }
+    return seg;
+}
+
+/**
+ * @brief      Copy a consistent snapshot of a slot
+ *
+ * @param[in]  seg   The segment
+ * @param[in]  i     The slot index
+ * @param      out   The snapshot
+ *
+ * @return     1 if the slot is used by a controller and was read, 0 otherwise
+ */
+int telemetry_read(const telemetry_segment_t *seg, int i, telemetry_slot_t *out) {
+    const telemetry_slot_t *slot = &seg->slots[i];
+    uint32_t seq1, seq2;
+    int k;
+
+    for (k = 0; k < READ_RETRIES; k++) {
+        seq1 = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq1 & 1)
+            continue;
+        memcpy(out, (const void *)slot, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq2 = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+        if (seq1 == seq2)
+            return out->pid != 0;
+    }
+    return 0;
+}
+
+/**
+ * @brief      Unmap a segment returned by telemetry_attach
+ */
+void telemetry_detach(const telemetry_segment_t *seg) {
+    if (seg != NULL)
+        munmap((void *)seg, sizeof(telemetry_segment_t));
+}
+
+#else
+
+/* No POSIX shared memory: the telemetry is disabled */
+
+int telemetry_open(telemetry_t *t, const char *name) {
+    memset(t, 0, sizeof(*t));
+    (void)name;
+    return 1;
+}
+
+void telemetry_neighbor(telemetry_t *t, int id, double range, double bearing) {
+    (void)t; (void)id; (void)range; (void)bearing;
+}
+
+void telemetry_fitness(telemetry_t *t, double fitness) {
+    (void)t; (void)fitness;
+}
+
+void telemetry_publish(telemetry_t *t) {
+    (void)t;
+}
+
+void telemetry_close(telemetry_t *t) {
+    (void)t;
+}
+
+const telemetry_segment_t* telemetry_attach(void) {
+    return NULL;
+}
+
+int telemetry_read(const telemetry_segment_t *seg, int i, telemetry_slot_t *out) {
+    (void)seg; (void)i; (void)out;
+    return 0;
+}
+
+void telemetry_detach(const telemetry_segment_t *seg) {
+    (void)seg;
+}
+
+#endif
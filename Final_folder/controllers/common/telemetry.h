@@ -0,0 +1,74 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+#define TELEMETRY_SHM_NAME       "/dis_telemetry"   // POSIX shared memory segment (/dev/shm/dis_telemetry on Linux)
+#define TELEMETRY_MAGIC          0x4d4c4554         // "TELM"
+#define TELEMETRY_VERSION        1                  // Version of the segment layout
+#define TELEMETRY_MAX_SLOTS      64                 // Maximum number of controllers publishing at the same time
+#define TELEMETRY_MAX_NEIGHBORS  16                 // Size of the neighbor table of a slot
+#define TELEMETRY_NAME_LEN       32
+
+typedef struct
+{
+  int32_t id;             // Robot id of the neighbor
+  float range;            // [m]
+  float bearing;          // [rad]
+  double time;            // Simulation time of the last measurement [s]
+} telemetry_neighbor_t;
+
+typedef struct
+{
+  double time;            // Simulation time [s]
+  uint64_t step;          // Number of published steps
+  double x;               // Pose estimate (NAN if the controller has none)
+  double y;
+  double heading;
+  int32_t fsm_state;      // State of the FSM of the controller (-1 if none)
+  int32_t n_neighbors;
+  telemetry_neighbor_t neighbors[TELEMETRY_MAX_NEIGHBORS];
+  double fitness;         // Last fitness (NAN if none)
+  double best_fitness;    // Best fitness so far (NAN if none)
+  double step_us;         // Wall time between the last two published steps [us]
+  double step_max_us;     // Maximum of step_us
+} telemetry_state_t;
+
+typedef struct
+{
+  volatile uint32_t seq;  // Seqlock: odd while the owner writes the state
+  volatile int32_t pid;   // Owner process (0 if the slot is free)
+  char name[TELEMETRY_NAME_LEN];
+  telemetry_state_t state;
+} telemetry_slot_t;
+
+typedef struct
+{
+  volatile uint32_t magic;
+  uint32_t version;
+  uint32_t n_slots;
+  uint32_t slot_size;
+  telemetry_slot_t slots[TELEMETRY_MAX_SLOTS];
+} telemetry_segment_t;
+
+/// Writer side, one per controller. The controller updates `state` and publishes it once per step.
+typedef struct
+{
+  telemetry_segment_t *seg;
+  telemetry_slot_t *slot;     // NULL if the telemetry is disabled
+  telemetry_state_t state;
+  double last_publish_us;
+} telemetry_t;
+
+/// Documentation in c file
+int telemetry_open(telemetry_t *t, const char *name);
+void telemetry_neighbor(telemetry_t *t, int id, double range, double bearing);
+void telemetry_fitness(telemetry_t *t, double fitness);
+void telemetry_publish(telemetry_t *t);
+void telemetry_close(telemetry_t *t);
+
+const telemetry_segment_t* telemetry_attach(void);
+int telemetry_read(const telemetry_segment_t *seg, int i, telemetry_slot_t *out);
+void telemetry_detach(const telemetry_segment_t *seg);
+
+#endif
@@ -0,0 +1,208 @@
+/*****************************************************************************/
+/* File:         timing.h                                                    */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Per-step timing of the controllers: scoped timers on a      */
+/*               monotonic clock and log2 histograms per named section       */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+/*
+ * Usage (nothing is compiled unless the controller is built with -DTIMING=1,
+ * e.g. by adding "CFLAGS += -DTIMING=1" in its Makefile):
+ *
+ *   TIMING_INIT(wb_robot_get_name());        // once, after wb_robot_init()
+ *   TIMING_SCOPE("sensors") {                 // time a block of code
+ *       ...                                   // (no return/break out of the block)
+ *   }
+ *   TIMING_ROBOT_STEP(TIME_STEP);             // replaces wb_robot_step(TIME_STEP)
+ *
+ * TIMING_ROBOT_STEP also records the section "control": the time spent by the
+ * controller between two steps, i.e. what is used of the TIME_STEP budget.
+ * The summary is printed at exit, when wb_robot_step returns -1, every
+ * TIMING_DUMP_PERIOD steps (if not 0) and when the process gets SIGUSR1
+ * (kill -USR1 <pid>).
+ */
+#ifndef TIMING_H
+#define TIMING_H
+
+#ifndef TIMING
+#define TIMING 0
+#endif
+
+#if TIMING
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+
+#define TIMING_MAX_SECTIONS  16     // Maximum number of named sections per controller
+#define TIMING_N_BUCKETS     24     // Bucket 0: < 1us, bucket i: [2^(i-1), 2^i) us, last one is open
+#ifndef TIMING_DUMP_PERIOD
+#define TIMING_DUMP_PERIOD   0      // Print the summary every TIMING_DUMP_PERIOD steps (0: never)
+#endif
+
+typedef struct
+{
+  const char *name;
+  long count;
+  double total;                     // [us]
+  double max;                       // [us]
+  long hist[TIMING_N_BUCKETS];
+} timing_section_t;
+
+typedef struct
+{
+  int id;
+  double start;
+  int running;
+} timing_scope_t;
+
+static timing_section_t timing_sections[TIMING_MAX_SECTIONS];
+static int timing_n_sections = 0;
+static char timing_owner[64] = "controller";
+static double timing_last_step = -1;
+static long timing_steps = 0;
+static long timing_dumped_steps = -1;   // Steps at the last summary (no duplicate summary at exit)
+static volatile sig_atomic_t timing_dump_requested = 0;
+
+static inline double timing_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+static inline int timing_section_id(const char *name) {
+    int i;
+    for (i = 0; i < timing_n_sections; i++)
+        if (timing_sections[i].name == name || strcmp(timing_sections[i].name, name) == 0)
+            return i;
+
+    if (timing_n_sections == TIMING_MAX_SECTIONS)
+        return -1;
+    timing_sections[timing_n_sections].name = name;
+    return timing_n_sections++;
+}
+
+static inline void timing_record(int id, double us) {
+    if (id < 0)
+        return;
+
+    timing_section_t *s = &timing_sections[id];
+    int b = 0;
+    while (b < TIMING_N_BUCKETS - 1 && us >= (double)(1L << b))
+        b++;
+    s->hist[b]++;
+    s->count++;
+    s->total += us;
+    if (us > s->max)
+        s->max = us;
+}
+
+/* Upper bound [us] of the bucket holding the given quantile of a section */
+static inline double timing_quantile(const timing_section_t *s, double q) {
+    long seen = 0;
+    int b;
+    for (b = 0; b < TIMING_N_BUCKETS; b++) {
+        seen += s->hist[b];
+        if (seen >= q * s->count)
+            break;
+    }
+    return b < TIMING_N_BUCKETS - 1 ? (double)(1L << b) : s->max;
+}
+
+static inline void timing_dump(void) {
+    int i, b;
+    timing_dumped_steps = timing_steps;
+    printf("[timing] %s, %ld steps\n", timing_owner, timing_steps);
+    printf("[timing] %-12s %8s %10s %10s %10s %10s [us]\n", "section", "count", "mean", "p50<=", "p99<=", "max");
+    for (i = 0; i < timing_n_sections; i++) {
+        const timing_section_t *s = &timing_sections[i];
+        if (s->count == 0)
+            continue;
+        printf("[timing] %-12s %8ld %10.1f %10.0f %10.0f %10.1f\n", s->name, s->count, s->total / s->count,
+               timing_quantile(s, 0.5), timing_quantile(s, 0.99), s->max);
+    }
+    for (i = 0; i < timing_n_sections; i++) {
+        const timing_section_t *s = &timing_sections[i];
+        if (s->count == 0)
+            continue;
+        printf("[timing] %-12s", s->name);
+        for (b = 0; b < TIMING_N_BUCKETS; b++)
+            if (s->hist[b])
+                printf(" <%ldus:%ld", 1L << b, s->hist[b]);
+        printf("\n");
+    }
+    fflush(stdout);
+}
+
+static void timing_dump_at_exit(void) {
+    if (timing_dumped_steps != timing_steps)
+        timing_dump();
+}
+
+static void timing_on_signal(int sig) {
+    (void)sig;
+    timing_dump_requested = 1;
+}
+
+static inline void timing_init(const char *owner) {
+    if (owner != NULL) {
+        strncpy(timing_owner, owner, sizeof(timing_owner) - 1);
+        timing_owner[sizeof(timing_owner) - 1] = '\0';
+    }
+    atexit(timing_dump_at_exit);
+#ifdef SIGUSR1
+    signal(SIGUSR1, timing_on_signal);
+#endif
+}
+
+static inline timing_scope_t timing_begin(const char *name) {
+    timing_scope_t scope = {timing_section_id(name), timing_now_us(), 1};
+    return scope;
+}
+
+static inline void timing_end(timing_scope_t *scope) {
+    timing_record(scope->id, timing_now_us() - scope->start);
+    scope->running = 0;
+}
+
+/* Called just before wb_robot_step(): the time since the previous step is the controller's work */
+static inline void timing_step_begin(void) {
+    double now = timing_now_us();
+    if (timing_last_step >= 0)
+        timing_record(timing_section_id("control"), now - timing_last_step);
+    timing_last_step = now;
+}
+
+/* Called with the return value of wb_robot_step() */
+static inline int timing_step_end(int ret) {
+    double now = timing_now_us();
+    timing_record(timing_section_id("step"), now - timing_last_step);
+    timing_last_step = now;
+    timing_steps++;
+
+    if (ret == -1 || timing_dump_requested || (TIMING_DUMP_PERIOD > 0 && timing_steps % TIMING_DUMP_PERIOD == 0)) {
+        timing_dump_requested = 0;
+        timing_dump();
+    }
+    return ret;
+}
+
+#define TIMING_INIT(OWNER)       timing_init(OWNER)
+#define TIMING_SCOPE(NAME)       for (timing_scope_t timing_scope_ = timing_begin(NAME); timing_scope_.running; timing_end(&timing_scope_))
+#define TIMING_ROBOT_STEP(T)     (timing_step_begin(), timing_step_end(wb_robot_step(T)))
+#define TIMING_DUMP()            timing_dump()
+
+#else
+
+#define TIMING_INIT(OWNER)
+#define TIMING_SCOPE(NAME)
+#define TIMING_ROBOT_STEP(T)     wb_robot_step(T)
+#define TIMING_DUMP()
+
+#endif
+
+#endif
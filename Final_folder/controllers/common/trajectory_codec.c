@@ -0,0 +1,384 @@
+/*****************************************************************************/
+/* File:         trajectory_codec.c                                          */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Compressed storage of per-step trajectory logs              */
+/*               (quantization + delta + zig-zag varints, keyframed blocks)  */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "trajectory_codec.h"
+
+/* File layout (all integers little endian):
+   header : "DTRJ" | version u8 | 0 u8 | n_cols u16 | keyframe_interval u32 | header_len u32 | header text | quantum f64 x n_cols
+   blocks : 'B' u8 | n_rows u32 | payload_len u32 | payload
+   The first row of a block is a keyframe (absolute values), the following rows are deltas to the previous row.
+   A column with quantum > 0 stores round(value/quantum), so the error is bounded by quantum/2.
+   A column with quantum = 0 is lossless: it stores the XOR of the raw IEEE-754 bits with the previous row. */
+
+#define BLOCK_TAG       'B'
+#define MAX_VARINT_LEN  10
+
+struct trj_writer {
+    FILE *fp;
+    int n_cols;
+    int keyframe_interval;
+    double *quantum;
+    int64_t *prev;          // previous quantized row (or raw bits for lossless columns)
+    int rows_in_block;
+    unsigned char *block;   // payload of the current block
+    size_t block_len;
+    size_t block_cap;
+};
+
+struct trj_reader {
+    FILE *fp;
+    int n_cols;
+    int keyframe_interval;
+    char *header;
+    double *quantum;
+    int64_t *prev;
+    long first_block;       // file offset of the first block
+    unsigned char *block;
+    size_t block_len;
+    size_t block_cap;
+    size_t pos;             // read position in the current block
+    uint32_t rows_left;     // rows not decoded yet in the current block
+    int keyframe;           // next row is the keyframe of the block
+};
+
+//-----------------------------------------------------------------------------------//
+/* Byte level helpers */
+
+static void put_u16(unsigned char *b, uint32_t v) { b[0] = v & 0xff; b[1] = (v >> 8) & 0xff; }
+static void put_u32(unsigned char *b, uint32_t v) { put_u16(b, v & 0xffff); put_u16(b + 2, v >> 16); }
+static uint32_t get_u16(const unsigned char *b) { return b[0] | ((uint32_t)b[1] << 8); }
+static uint32_t get_u32(const unsigned char *b) { return get_u16(b) | (get_u16(b + 2) << 16); }
+
+static uint64_t double_bits(double v) { uint64_t u; memcpy(&u, &v, sizeof(u)); return u; }
+static double bits_double(uint64_t u) { double v; memcpy(&v, &u, sizeof(v)); return v; }
+
+static uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+static int64_t unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+/**
+ * @brief      Append an unsigned varint (7 bits per byte, MSB = continuation) to the block
+ */
+static int block_put_varint(trj_writer_t *w, uint64_t v) {
+    if (w->block_len + MAX_VARINT_LEN > w->block_cap) {
+        size_t cap = w->block_cap ? 2*w->block_cap : 4096;
+        unsigned char *b = realloc(w->block, cap);
+        if (b == NULL)
+            return 1;
+        w->block = b;
+        w->block_cap = cap;
+    }
+    while (v >= 0x80) {
+        w->block[w->block_len++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    w->block[w->block_len++] = (unsigned char)v;
+    return 0;
+}
+
+/**
+ * @brief      Read an unsigned varint from the current block of the reader
+ *
+ * @return     1 if the block is truncated
+ */
+static int block_get_varint(trj_reader_t *r, uint64_t *v) {
+    int shift = 0;
+    *v = 0;
+    while (r->pos < r->block_len && shift < 64) {
+        unsigned char c = r->block[r->pos++];
+        *v |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80))
+            return 0;
+        shift += 7;
+    }
+    return 1;
+}
+
+//-----------------------------------------------------------------------------------//
+/* Writer */
+
+/**
+ * @brief      Write the current block to the file and start a new one
+ */
+static int flush_block(trj_writer_t *w) {
+    unsigned char head[9];
+
+    if (w->rows_in_block == 0)
+        return 0;
+    head[0] = BLOCK_TAG;
+    put_u32(head + 1, w->rows_in_block);
+    put_u32(head + 5, (uint32_t)w->block_len);
+    if (fwrite(head, 1, sizeof(head), w->fp) != sizeof(head) ||
+        fwrite(w->block, 1, w->block_len, w->fp) != w->block_len)
+        return 1;
+    fflush(w->fp); // a crash loses at most the block being written
+    w->rows_in_block = 0;
+    w->block_len = 0;
+    return 0;
+}
+
+/**
+ * @brief      Create a compressed trajectory log
+ *
+ * @param[in]  filename           The file to write
+ * @param[in]  header             Column names, written back as-is by the decompressor (e.g. the csv header line)
+ * @param[in]  n_cols             Number of values per row
+ * @param[in]  quantum            Resolution of each column, 0 for a lossless column
+ * @param[in]  keyframe_interval  Number of rows per block (random access granularity)
+ *
+ * @return     the writer, NULL if it fails
+ */
+trj_writer_t* trj_open_write(const char *filename, const char *header, int n_cols, const double *quantum, int keyframe_interval) {
+    unsigned char head[16];
+    unsigned char q[8];
+    trj_writer_t *w;
+    int i;
+
+    if (n_cols <= 0 || n_cols > 0xffff || keyframe_interval <= 0)
+        return NULL;
+
+    w = calloc(1, sizeof(*w));
+    if (w == NULL)
+        return NULL;
+    w->n_cols = n_cols;
+    w->keyframe_interval = keyframe_interval;
+    w->quantum = malloc(n_cols*sizeof(*w->quantum));
+    w->prev = calloc(n_cols, sizeof(*w->prev));
+    w->fp = fopen(filename, "wb");
+    if (w->quantum == NULL || w->prev == NULL || w->fp == NULL) {
+        trj_close_write(w);
+        return NULL;
+    }
+    memcpy(w->quantum, quantum, n_cols*sizeof(*w->quantum));
+
+    memcpy(head, TRJ_MAGIC, 4);
+    head[4] = TRJ_VERSION;
+    head[5] = 0;
+    put_u16(head + 6, n_cols);
+    put_u32(head + 8, keyframe_interval);
+    put_u32(head + 12, (uint32_t)strlen(header));
+    fwrite(head, 1, sizeof(head), w->fp);
+    fwrite(header, 1, strlen(header), w->fp);
+    for (i = 0; i < n_cols; i++) {
+        uint64_t u = double_bits(quantum[i]);
+        put_u32(q, (uint32_t)u);
+        put_u32(q + 4, (uint32_t)(u >> 32));
+        fwrite(q, 1, sizeof(q), w->fp);
+    }
+    return w;
+}
+
+/**
+ * @brief      Append one row to the log
+ *
+ * @return     1 if it fails
+ */
+int trj_write_row(trj_writer_t *w, const double *row) {
+    int i;
+
+    if (w == NULL)
+        return 1;
+
+    for (i = 0; i < w->n_cols; i++) {
+        int64_t cur;
+        uint64_t code;
+
+        if (w->quantum[i] > 0) {
+            cur = llround(row[i]/w->quantum[i]);
+            code = w->rows_in_block == 0 ? zigzag(cur) : zigzag(cur - w->prev[i]);
+        } else {
+            cur = (int64_t)double_bits(row[i]);
+            code = w->rows_in_block == 0 ? (uint64_t)cur : (uint64_t)(cur ^ w->prev[i]);
+        }
+        w->prev[i] = cur;
+        if (block_put_varint(w, code))
+            return 1;
+    }
+
+    w->rows_in_block++;
+    if (w->rows_in_block == w->keyframe_interval)
+        return flush_block(w);
+    return 0;
+}
+
+/**
+ * @brief      Flush the last block and close the log
+ *
+ * @return     1 if it fails
+ */
+int trj_close_write(trj_writer_t *w) {
+    int err = 0;
+
+    if (w == NULL)
+        return 1;
+    if (w->fp != NULL) {
+        err = flush_block(w);
+        err = fclose(w->fp) || err;
+    }
+    free(w->quantum);
+    free(w->prev);
+    free(w->block);
+    free(w);
+    return err;
+}
+
+//-----------------------------------------------------------------------------------//
+/* Reader */
+
+/**
+ * @brief      Open a compressed trajectory log
+ *
+ * @return     the reader, NULL if the file is missing or not a trajectory log
+ */
+trj_reader_t* trj_open_read(const char *filename) {
+    unsigned char head[16];
+    unsigned char q[8];
+    trj_reader_t *r;
+    uint32_t header_len;
+    int i;
+
+    r = calloc(1, sizeof(*r));
+    if (r == NULL)
+        return NULL;
+    r->fp = fopen(filename, "rb");
+    if (r->fp == NULL || fread(head, 1, sizeof(head), r->fp) != sizeof(head) ||
+        memcmp(head, TRJ_MAGIC, 4) != 0 || head[4] != TRJ_VERSION) {
+        trj_close_read(r);
+        return NULL;
+    }
+    r->n_cols = get_u16(head + 6);
+    r->keyframe_interval = get_u32(head + 8);
+    header_len = get_u32(head + 12);
+
+    r->header = malloc(header_len + 1);
+    r->quantum = malloc(r->n_cols*sizeof(*r->quantum));
+    r->prev = calloc(r->n_cols, sizeof(*r->prev));
+    if (r->header == NULL || r->quantum == NULL || r->prev == NULL ||
+        fread(r->header, 1, header_len, r->fp) != header_len) {
+        trj_close_read(r);
+        return NULL;
+    }
+    r->header[header_len] = '\0';
+    for (i = 0; i < r->n_cols; i++) {
+        if (fread(q, 1, sizeof(q), r->fp) != sizeof(q)) {
+            trj_close_read(r);
+            return NULL;
+        }
+        r->quantum[i] = bits_double(get_u32(q) | ((uint64_t)get_u32(q + 4) << 32));
+    }
+    r->first_block = ftell(r->fp);
+    return r;
+}
+
+const char* trj_header(const trj_reader_t *r) {
+    return r->header;
+}
+
+int trj_n_cols(const trj_reader_t *r) {
+    return r->n_cols;
+}
+
+/**
+ * @brief      Load the next block of the file in memory
+ *
+ * @return     1 at the end of the file or if the block is corrupted
+ */
+static int load_block(trj_reader_t *r) {
+    unsigned char head[9];
+    uint32_t len;
+
+    if (fread(head, 1, sizeof(head), r->fp) != sizeof(head) || head[0] != BLOCK_TAG)
+        return 1;
+    len = get_u32(head + 5);
+    if (len > r->block_cap) {
+        unsigned char *b = realloc(r->block, len);
+        if (b == NULL)
+            return 1;
+        r->block = b;
+        r->block_cap = len;
+    }
+    if (fread(r->block, 1, len, r->fp) != len)
+        return 1;
+    r->block_len = len;
+    r->pos = 0;
+    r->rows_left = get_u32(head + 1);
+    r->keyframe = 1;
+    return 0;
+}
+
+/**
+ * @brief      Decode the next row of the log
+ *
+ * @param      row   The decoded values (n_cols values)
+ *
+ * @return     1 if a row was read, 0 at the end of the file
+ */
+int trj_read_row(trj_reader_t *r, double *row) {
+    int i;
+
+    while (r->rows_left == 0) {
+        if (load_block(r))
+            return 0;
+    }
+
+    for (i = 0; i < r->n_cols; i++) {
+        uint64_t code;
+        int64_t cur;
+
+        if (block_get_varint(r, &code))
+            return 0;
+        if (r->quantum[i] > 0) {
+            cur = r->keyframe ? unzigzag(code) : r->prev[i] + unzigzag(code);
+            row[i] = cur*r->quantum[i];
+        } else {
+            cur = r->keyframe ? (int64_t)code : (int64_t)(code ^ (uint64_t)r->prev[i]);
+            row[i] = bits_double((uint64_t)cur);
+        }
+        r->prev[i] = cur;
+    }
+    r->keyframe = 0;
+    r->rows_left--;
+    return 1;
+}
+
+/**
+ * @brief      Jump to the keyframe of a block without decoding the blocks before it.
+ *             The next call to trj_read_row returns row block*keyframe_interval.
+ *
+ * @return     1 if the block does not exist
+ */
+int trj_seek_block(trj_reader_t *r, long block) {
+    unsigned char head[9];
+
+    if (fseek(r->fp, r->first_block, SEEK_SET))
+        return 1;
+    r->rows_left = 0;
+    for (; block > 0; block--) {
+        if (fread(head, 1, sizeof(head), r->fp) != sizeof(head) || head[0] != BLOCK_TAG ||
+            fseek(r->fp, get_u32(head + 5), SEEK_CUR))
+            return 1;
+    }
+    return load_block(r);
+}
+
+void trj_close_read(trj_reader_t *r) {
+    if (r == NULL)
+        return;
+    if (r->fp != NULL)
+        fclose(r->fp);
+    free(r->header);
+    free(r->quantum);
+    free(r->prev);
+    free(r->block);
+    free(r);
+}
@@ -0,0 +1,25 @@
+#ifndef TRAJECTORY_CODEC_H
+#define TRAJECTORY_CODEC_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define TRJ_MAGIC    "DTRJ"    // First bytes of a compressed trajectory log
+#define TRJ_VERSION  1         // Version of the file layout
+
+/// Documentation in c file
+typedef struct trj_writer trj_writer_t;
+typedef struct trj_reader trj_reader_t;
+
+trj_writer_t* trj_open_write(const char *filename, const char *header, int n_cols, const double *quantum, int keyframe_interval);
+int trj_write_row(trj_writer_t *w, const double *row);
+int trj_close_write(trj_writer_t *w);
+
+trj_reader_t* trj_open_read(const char *filename);
+const char* trj_header(const trj_reader_t *r);
+int trj_n_cols(const trj_reader_t *r);
+int trj_read_row(trj_reader_t *r, double *row);
+int trj_seek_block(trj_reader_t *r, long block);
+void trj_close_read(trj_reader_t *r);
+
+#endif
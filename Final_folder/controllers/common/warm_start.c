@@ -0,0 +1,157 @@
+/*****************************************************************************/
+/* File:         warm_start.c                                                */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Archive of the best particles of the previous PSO runs and  */
+/*               of their fitness, from which a new swarm is seeded          */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "warm_start.h"
+#include "checkpoint.h"
+
+/* The archive keeps the capacity best particles of all the runs so far, ranked by the mean of
+   their evaluations; a particle found again by a later run (the same values, e.g. a seed that
+   stayed a personal best) has the statistics of both runs merged instead of a second entry,
+   so that a lucky controller sinks as it is re-evaluated. Particles without evaluations, such
+   as a hand-tuned controller, rank after all the evaluated ones.
+
+   A new swarm takes its particles from the entries in the order of their rank: the best one
+   exactly, so that the run starts from the previous optimum, the others with a Gaussian
+   perturbation of spread times the initialization domain, larger for each further round over
+   the entries, so that the seeds stay diverse even with a small archive. The archive is one
+   block, saved and loaded with checkpoint_save(). */
+
+static double gauss(rng_t *r) {
+    return sqrt(-2.0 * log(1.0 - rng_uniform(r))) * cos(2.0 * M_PI * rng_uniform(r));
+}
+
+/* Whether the entry e ranks before the entry f */
+static int ranks_before(const warm_start_entry_t *e, const warm_start_entry_t *f) {
+    if (e->n > 0 && f->n > 0)
+        return e->mean > f->mean;
+    return e->n > 0 && f->n <= 0;
+}
+
+/**
+ * @brief      Initialize an empty archive
+ *
+ * @param      a         The archive
+ * @param[in]  dim       The dimension of the particles (at most WARM_START_MAX_DIM)
+ * @param[in]  capacity  The maximum number of entries (at most WARM_START_MAX_ENTRIES)
+ */
+void warm_start_init(warm_start_t *a, int dim, int capacity) {
+    memset(a, 0, sizeof(*a));
+    a->dim = dim < WARM_START_MAX_DIM ? dim : WARM_START_MAX_DIM;
+    a->capacity = capacity > 0 && capacity < WARM_START_MAX_ENTRIES ? capacity : WARM_START_MAX_ENTRIES;
+}
+
+/**
+ * @brief      Load the archive saved by the previous runs, with the dimension of the archive
+ *
+ * @param      a     The archive, initialized with warm_start_init() (unchanged on failure)
+ * @param[in]  path  The archive file
+ *
+ * @return     1 if there is no archive of this dimension
+ */
+int warm_start_load(warm_start_t *a, const char *path) {
+    static warm_start_t loaded;
+
+    if (checkpoint_load(path, &loaded, sizeof(loaded), (uint32_t)a->dim) || loaded.dim != a->dim)
+        return 1;
+    loaded.capacity = a->capacity;
+    if (loaded.count > loaded.capacity)
+        loaded.count = loaded.capacity;  // The worst entries go
+    memcpy(a, &loaded, sizeof(loaded));
+    if (a->count > 0)
+        printf("Loaded %d particles from the archive %s (best %lf over %g evaluations)\n", a->count, path,
+               a->entries[0].mean, a->entries[0].n);
+    return 0;
+}
+
+/**
+ * @brief      Save the archive atomically
+ *
+ * @return     1 on failure
+ */
+int warm_start_save(const warm_start_t *a, const char *path) {
+    return checkpoint_save(path, a, sizeof(*a), (uint32_t)a->dim);
+}
+
+/**
+ * @brief      Add a particle to the archive, or merge its statistics with its entry
+ *
+ * @param      a     The archive
+ * @param[in]  x     The particle (dim values)
+ * @param[in]  n     The number of evaluations of its fitness (0: none)
+ * @param[in]  mean  Their mean
+ * @param[in]  m2    The sum of their squared deviations to the mean
+ *
+ * @return     Its rank (0: best), -1 if it is not kept
+ */
+int warm_start_add(warm_start_t *a, const double *x, double n, double mean, double m2) {
+    warm_start_entry_t e;
+    double delta, total;
+    int i;
+
+    memset(&e, 0, sizeof(e));
+    memcpy(e.x, x, a->dim * sizeof(double));
+    e.n = n > 0 ? n : 0.0;
+    e.mean = mean;
+    e.m2 = m2;
+    for (i = 0; i < a->count; i++) {
+        if (memcmp(a->entries[i].x, x, a->dim * sizeof(double)) != 0)
+            continue;
+        // Same particle: merge the two samples (Chan et al.) and rank it again
+        total = a->entries[i].n + e.n;
+        if (total > 0) {
+            delta = e.mean - a->entries[i].mean;
+            e.m2 += a->entries[i].m2 + delta * delta * a->entries[i].n * e.n / total;
+            e.mean = a->entries[i].mean + delta * e.n / total;
+            e.n = total;
+        }
+        memmove(&a->entries[i], &a->entries[i + 1], (a->count - i - 1) * sizeof(e));
+        a->count--;
+        break;
+    }
+
+    // Insertion at its rank, after the entries of the same mean
+    for (i = a->count; i > 0 && ranks_before(&e, &a->entries[i - 1]); i--)
+        a->entries[i] = a->entries[i - 1];
+    a->entries[i] = e;
+    if (a->count < a->capacity)
+        a->count++;
+    return i < a->count ? i : -1;
+}
+
+/**
+ * @brief      Seed of the particle i of a new swarm
+ *
+ * @param[in]  a         The archive
+ * @param[in]  i         The particle
+ * @param[in]  spread    The standard deviation of the perturbation, fraction of the initialization domain
+ * @param[in]  init_min  The initialization domain of each element
+ * @param[in]  init_max
+ * @param      rng       The stream of the particle
+ * @param[out] x         The particle (dim values)
+ *
+ * @return     1 if the archive is empty (x is unchanged)
+ */
+int warm_start_particle(const warm_start_t *a, int i, double spread, const double *init_min,
+                        const double *init_max, rng_t *rng, double *x) {
+    const warm_start_entry_t *e;
+    double sd;
+    int k;
+
+    if (a == NULL || a->count == 0)
+        return 1;
+    e = &a->entries[i % a->count];
+    sd = i == 0 ? 0.0 : spread * (1 + i / a->count);
+    for (k = 0; k < a->dim; k++)
+        x[k] = e->x[k] + (sd > 0.0 ? sd * (init_max[k] - init_min[k]) * gauss(rng) : 0.0);
+    return 0;
+}
@@ -0,0 +1,38 @@
+#ifndef WARM_START_H
+#define WARM_START_H
+
+#include <stdint.h>
+
+#include "rng.h"
+
+#define WARM_START_MAX_ENTRIES  64       // Maximum size of the archive
+#define WARM_START_MAX_DIM      32       // Maximum dimension of a particle (DATASIZE)
+
+/// Best particle of a previous run and the statistics of its fitness
+typedef struct
+{
+  double x[WARM_START_MAX_DIM];
+  double n;                     // Number of evaluations (0: not evaluated, e.g. a hand-tuned particle)
+  double mean;
+  double m2;                    // Sum of the squared deviations to the mean
+} warm_start_entry_t;
+
+/// Archive of the bests of the previous runs, ranked by their mean fitness
+typedef struct
+{
+  int32_t dim;
+  int32_t capacity;             // Entries kept (at most WARM_START_MAX_ENTRIES), the worst ones are dropped beyond
+  int32_t count;                // Number of entries
+  int32_t reserved;
+  warm_start_entry_t entries[WARM_START_MAX_ENTRIES + 1];  // Best first, the unevaluated ones last
+} warm_start_t;
+
+/// Documentation in c file
+void warm_start_init(warm_start_t *a, int dim, int capacity);
+int warm_start_load(warm_start_t *a, const char *path);
+int warm_start_save(const warm_start_t *a, const char *path);
+int warm_start_add(warm_start_t *a, const double *x, double n, double mean, double m2);
+int warm_start_particle(const warm_start_t *a, int i, double spread, const double *init_min,
+                        const double *init_max, rng_t *rng, double *x);
+
+#endif
@@ -25,6 +25,8 @@
 #include <webots/distance_sensor.h>
 #include <webots/emitter.h>
 #include <webots/receiver.h>
+#include "../common/timing.h"
+#include "../common/telemetry.h"
 
 // ------------------------- Adapt the flock size  ---------------------------
 #define FLOCK_SIZE            5     // Size of flock (2,3,4 or 5) of one group for Mataric controller
@@ -85,6 +87,7 @@ WbDeviceTag emitter;		 //Handle for the emitter node
 
 int fsm_state;                // finite state machine's state
 int robot_id_u;	              // unique robot ID
+static telemetry_t telemetry;       // Live telemetry (see common/telemetry.h)
 char* robot_name;
 
 // for PI controller : using tustin's approx
@@ -101,6 +104,8 @@ float target_bearing_followers[MAX_FLOCK_SIZE - 1] = { M_PI/4 , 7*M_PI/4 , M_PI/
  */
 static void reset() {
 	wb_robot_init();
+	TIMING_INIT(wb_robot_get_name());
+	telemetry_open(&telemetry, wb_robot_get_name());
 	receiver = wb_robot_get_device("receiver");
 	emitter = wb_robot_get_device("emitter");
 	
@@ -317,6 +322,7 @@ void process_received_ping_messages(void) {
           }
           
           friend_robot_id = (int)(inbuffer[5]-'0');  // since the name of the sender is in the received message.
+          telemetry_neighbor(&telemetry, friend_robot_id, range, bearing);
           
           if (WORLD == CROSSING){
 		  // group1
@@ -494,7 +500,7 @@ int main(){
         max_sens = 0;
         
         // Braitenberg
-        for(i = 0; i < NB_SENSORS; i++) {
+        TIMING_SCOPE("sensors") for(i = 0; i < NB_SENSORS; i++) {
             ds_value[i] = wb_distance_sensor_get_value(ds[i]);
           	sum_sensors += ds_value[i];
           	max_sens = max_sens>ds_value[i]?max_sens:ds_value[i]; // Check if new highest sensor value
@@ -508,8 +514,8 @@ int main(){
           bmsl+=66; bmsr+=72;
     
           /* Send and get information */
-          send_ping();
-          process_received_ping_messages();
+          TIMING_SCOPE("send_ping") send_ping();
+          TIMING_SCOPE("ping") process_received_ping_messages();
     
           // Condition for entering obstacle avoidance state (threshold on one of the four front sensors)
           if ((ds_value[0] > AVOIDANCE_THRESH || ds_value[7] > AVOIDANCE_THRESH ||
@@ -518,7 +524,7 @@ int main(){
           }
            
           if (fsm_state == FORMATION){ //formation state --- do only formation
-               range_bearing_to_command(&msl, &msr); //formation command
+               TIMING_SCOPE("formation") range_bearing_to_command(&msl, &msr); //formation command
           }
           else{ //avoidance state --- do only braitenberg
                msl = bmsl;
@@ -530,16 +536,23 @@ int main(){
           msl_w = msl*MAX_SPEED_WEB/(MAX_SPEED+1);
           msr_w = msr*MAX_SPEED_WEB/(MAX_SPEED+1);
                 
-          wb_motor_set_velocity(left_motor, msl_w);
-          wb_motor_set_velocity(right_motor, msr_w);
+          TIMING_SCOPE("motors") {
+               wb_motor_set_velocity(left_motor, msl_w);
+               wb_motor_set_velocity(right_motor, msr_w);
+          }
            
           //Condition to exit avoidance state
           if((fsm_state == AVOIDANCE) && (max_sens < FORMATION_THRESH)){
                fsm_state = FORMATION;
           }
 
+          // Publish the live telemetry
+          telemetry.state.time = wb_robot_get_time();
+          telemetry.state.fsm_state = fsm_state;
+          telemetry_publish(&telemetry);
+
           // Continue one step
-          wb_robot_step(TIME_STEP);
+          TIMING_ROBOT_STEP(TIME_STEP);
 	 }
 }  
   
@@ -19,6 +19,8 @@
 #include "../localization_controller/utils.h"
 #include "../localization_controller/odometry.h"
 #include "../localization_controller/kalman.h"
+#include "../common/timing.h"
+#include "../common/telemetry.h"
 
 #include <webots/robot.h>
 #include <webots/motor.h>
@@ -99,6 +101,7 @@ WbDeviceTag receiver;	    // Handle for the receiver node
 WbDeviceTag emitter;		// Handle for the emitter node
 
 int robot_id_u;	                 // Unique robot ID
+static telemetry_t telemetry;       // Live telemetry (see common/telemetry.h)
 char* robot_name;
 float range_to_other_leader;     // measured range to the leader of the other team
 float bearing_to_other_leader;   // measured bearing to the leader of the other team
@@ -131,6 +134,8 @@ static double speed[2];           // Speed calculated for migration
  */
 static void reset() {
 	wb_robot_init();
+	TIMING_INIT(wb_robot_get_name());
+	telemetry_open(&telemetry, wb_robot_get_name());
     dev_gps = wb_robot_get_device("gps");
     wb_gps_enable(dev_gps, 1000); // Enable GPS every 1000ms <=> 1s
     time_step = wb_robot_get_basic_time_step();
@@ -313,6 +318,7 @@ void process_received_ping_messages(void) {
           }
           
           friend_robot_id = (int)(inbuffer[5]-'0');  // since the name of the sender is in the received message.
+          telemetry_neighbor(&telemetry, friend_robot_id, range, bearing);
 
           // save the measured range and bearing if the sender is the other leader
           if (friend_robot_id == LEADER2_ID){
@@ -376,14 +382,14 @@ int main(){
             time_step = wb_robot_get_basic_time_step();
 
             // Position with frame initial point stored in _pose vector
-            controller_get_pose_gps();
+            TIMING_SCOPE("gps") controller_get_pose_gps();
 
             // Get the encoder values (wheel motor values)
-            controller_get_encoder();
+            TIMING_SCOPE("encoders") controller_get_encoder();
             
             time_now_s = wb_robot_get_time();
             // Kalman with wheel encoders
-            compute_kalman_wheels(&_kal_wheel, time_step, time_now_s, _meas.left_enc - _meas.prev_left_enc,_meas.right_enc - _meas.prev_right_enc, _pose);
+            TIMING_SCOPE("kalman") compute_kalman_wheels(&_kal_wheel, time_step, time_now_s, _meas.left_enc - _meas.prev_left_enc,_meas.right_enc - _meas.prev_right_enc, _pose);
 
             bmsl = 0;
             bmsr = 0;
@@ -391,7 +397,7 @@ int main(){
             max_sens = 0;
 
               // Braitenberg
-              for(i = 0; i < NB_SENSORS; i++) {
+              TIMING_SCOPE("sensors") for(i = 0; i < NB_SENSORS; i++) {
                       ds_value[i] = wb_distance_sensor_get_value(ds[i]); //Read sensor values
                       sum_sensors += ds_value[i]; // Add up sensor values
                       max_sens = max_sens>ds_value[i]?max_sens:ds_value[i]; // Check if new highest sensor value
@@ -405,8 +411,8 @@ int main(){
               bmsl+=66;
               bmsr+=72;
               
-              send_ping();  // sending a ping to other robot, so they can measure their distance to this robot
-              process_received_ping_messages();
+              TIMING_SCOPE("send_ping") send_ping();  // sending a ping to other robot, so they can measure their distance to this robot
+              TIMING_SCOPE("ping") process_received_ping_messages();
              
               // Condition for entering obstacle avoidance state (threshold on one of the four front sensors)
               if ((ds_value[0] > AVOIDANCE_THRESH ||
@@ -474,16 +480,26 @@ int main(){
             msl_w = msl*MAX_SPEED_WEB/(MAX_SPEED+1);
             msr_w = msr*MAX_SPEED_WEB/(MAX_SPEED+1);
             
-            wb_motor_set_velocity(left_motor, msl_w);
-            wb_motor_set_velocity(right_motor, msr_w);
+            TIMING_SCOPE("motors") {
+                wb_motor_set_velocity(left_motor, msl_w);
+                wb_motor_set_velocity(right_motor, msr_w);
+            }
                
             //Condition to exit avoidance state
             if((fsm_state == AVOIDANCE) && (max_sens < MIGRATION_THRESH)){ //Exit condition of "avoidance
                 fsm_state = MIGRATION;
             }
                
+            // Publish the live telemetry
+            telemetry.state.time = wb_robot_get_time();
+            telemetry.state.x = _kal_wheel.x;
+            telemetry.state.y = _kal_wheel.y;
+            telemetry.state.heading = _kal_wheel.heading;
+            telemetry.state.fsm_state = fsm_state;
+            telemetry_publish(&telemetry);
+
             // Continue one step
-            wb_robot_step(TIME_STEP);
+            TIMING_ROBOT_STEP(TIME_STEP);
          }
  }
 
@@ -22,6 +22,9 @@
 #include "odometry.h"
 #include "kalman.h"
 #include "trajectories.h"
+#include "../common/log_policy.h"
+#include "../common/timing.h"
+#include "../common/telemetry.h"
 
 #include <webots/robot.h>
 #include <webots/motor.h>
@@ -46,12 +49,25 @@ If you would like to calibrate please:
 #define VERBOSE_PRINT_LOG true    // Print log on CSV file
 #define VERBOSE_ROBOT_POSE false        // Print the position of the robot updated each second
 
+/* LOG POLICY (see common/log_policy.h)
+- LOG_MODE: LOG_ALWAYS, LOG_DECIMATE (one step out of LOG_DECIMATION) or LOG_ON_CHANGE (a value moved more than LOG_CHANGE_THRESHOLD)
+- Around each GPS update, LOG_BURST_PRE steps before and LOG_BURST_POST steps after are always written
+*/
+#define LOG_MODE LOG_ALWAYS
+#define LOG_DECIMATION 10
+#define LOG_CHANGE_THRESHOLD 1e-3
+#define LOG_BURST_PRE 5
+#define LOG_BURST_POST 5
+#define LOG_N_VALUES 24           // Number of columns of the log file
+
 /*VARIABLES*/
 static pose_t _pose, _odo_acc, _odo_enc, _kal_wheel, _kal_acc;
 
 // Initial robot position
 static pose_t _pose_origin = {-2.9, 0.0, 0};
 static FILE *fp;
+static log_stream_t log_stream;
+static telemetry_t telemetry;       // Live telemetry (see common/telemetry.h)
 
 /*FUNCTIONS*/
 static bool controller_init_log(const char *filename);
@@ -124,6 +140,8 @@ void init_devices(int ts) {
 int main() {
 
     wb_robot_init();
+    TIMING_INIT(wb_robot_get_name());
+    telemetry_open(&telemetry, wb_robot_get_name());
 
     if (CATCH_ERR(controller_init(), "Controller fails to init \n"))
         return 1;
@@ -139,7 +157,7 @@ int main() {
     _meas.acc_mean[2] = 9.62942; // z
 
     // Forever
-    while (wb_robot_step(time_step) != -1) {
+    while (TIMING_ROBOT_STEP(time_step) != -1) {
 
         if (wb_robot_get_time() < TIME_INIT_ACC) {
         	// CALIBRATION
@@ -151,36 +169,38 @@ int main() {
                 
                 
                 // Updating the pose (thanks to GPS, every second)
-                controller_get_pose_gps();
+                TIMING_SCOPE("gps") controller_get_pose_gps();
         
         
                 // Get the acceleration from webots
-                controller_get_acc();
+                TIMING_SCOPE("accelerometer") controller_get_acc();
         
                 // Get the encoder values 
-                controller_get_encoder();
+                TIMING_SCOPE("encoders") controller_get_encoder();
                 
                 double time_now_s = wb_robot_get_time();
                 
                 
                 /// Compute position from wheel encoders
-                odo_compute_encoders(&_odo_enc, _meas.left_enc - _meas.prev_left_enc,
-                                     _meas.right_enc - _meas.prev_right_enc);
+                TIMING_SCOPE("odometry") {
+                    odo_compute_encoders(&_odo_enc, _meas.left_enc - _meas.prev_left_enc,
+                                         _meas.right_enc - _meas.prev_right_enc);
 
-                /// Compute position from accelerometer with heading from wheel encoders
-                odo_compute_acc(&_odo_acc, _meas.acc, _meas.acc_mean, _odo_enc.heading);
+                    /// Compute position from accelerometer with heading from wheel encoders
+                    odo_compute_acc(&_odo_acc, _meas.acc, _meas.acc_mean, _odo_enc.heading);
+                }
 
                 // Current time in seconds
                 time_now_s = wb_robot_get_time();
 
                 
                 // Kalman with accelerometer
-                compute_kalman_acc(&_kal_acc, time_step, time_now_s, _odo_enc.heading, _meas, _pose);
+                TIMING_SCOPE("kalman_acc") compute_kalman_acc(&_kal_acc, time_step, time_now_s, _odo_enc.heading, _meas, _pose);
                 
 
                 // Kalman with wheel encoders
-                compute_kalman_wheels(&_kal_wheel, time_step, time_now_s, _meas.left_enc - _meas.prev_left_enc,
-                                      _meas.right_enc - _meas.prev_right_enc, _pose);
+                TIMING_SCOPE("kalman_wheels") compute_kalman_wheels(&_kal_wheel, time_step, time_now_s, _meas.left_enc - _meas.prev_left_enc,
+                                                                    _meas.right_enc - _meas.prev_right_enc, _pose);
                                       
 
             }
@@ -188,7 +208,7 @@ int main() {
             /// Trajectories
 
             //trajectory_1(dev_left_motor, dev_right_motor);
-            trajectory_2(dev_left_motor, dev_right_motor);
+            TIMING_SCOPE("motors") trajectory_2(dev_left_motor, dev_right_motor);
             
             // Trajectory 3 for accelerometer CALIBRATION
             //trajectory_3(dev_left_motor, dev_right_motor);
@@ -198,10 +218,19 @@ int main() {
 
         /// Printing the log file onto a csv for matlab plotting
         if (VERBOSE_PRINT_LOG) {
-            controller_print_log(wb_robot_get_time());
+            TIMING_SCOPE("log") controller_print_log(wb_robot_get_time());
         }
+
+        // Publish the live telemetry
+        telemetry.state.time = wb_robot_get_time();
+        telemetry.state.x = _kal_wheel.x;
+        telemetry.state.y = _kal_wheel.y;
+        telemetry.state.heading = _kal_wheel.heading;
+        telemetry_publish(&telemetry);
     }
+    telemetry_close(&telemetry);
     // Close log file
+    log_stream_free(&log_stream);
     if (fp != NULL)
         fclose(fp);
     // End of the simulation
@@ -225,6 +254,7 @@ void controller_get_pose_gps() {
          controller_get_gps();
 
         last_gps_time_s = time_now_s;
+        log_stream_event(&log_stream); // log the steps around the GPS update
 
         _pose.x = _meas.gps[0] - _pose_origin.x;
 
@@ -348,6 +378,8 @@ bool controller_init_log(const char *filename) {
     bool err = CATCH_ERR(fp == NULL, "Fails to create a log file\n");
 
     if (!err) {
+        log_policy_t policy = {LOG_MODE, LOG_DECIMATION, LOG_CHANGE_THRESHOLD, 1, LOG_BURST_PRE, LOG_BURST_POST};
+        log_stream_init(&log_stream, &policy, LOG_N_VALUES, log_csv_sink, fp);
         fprintf(fp,
                 "time; pose_x; pose_y; pose_heading;  gps_x; gps_y; gps_z; acc_x; acc_y; acc_z; right_enc; left_enc; odo_acc_x; odo_acc_y; odo_acc_heading; odo_enc_x; odo_enc_y; odo_enc_heading; kal_wheel_x; kal_wheel_y; kal_wheel_heading; kal_acc_x; kal_acc_y; kal_acc_heading\n");
 
@@ -370,12 +402,15 @@ bool controller_init() {
 void controller_print_log(double time) {
 
     if (fp != NULL) {
-        fprintf(fp, "%g; %g; %g; %g; %g; %g; %g; %g; %g; %g; %g; %g; %g; %g; %g; %g; %g; %g; %g; %g; %g; %g; %g; %g\n",
+        double row[LOG_N_VALUES] = {
                 time, _pose.x, _pose.y, _pose.heading, _meas.gps[0], _meas.gps[2],
                 _meas.gps[1], _meas.acc[1] - _meas.acc_mean[1], _meas.acc[0] - _meas.acc_mean[0],
                 _meas.acc[2] - _meas.acc_mean[2], _meas.right_enc, _meas.left_enc,
                 _odo_acc.x, _odo_acc.y, _odo_acc.heading, _odo_enc.x, _odo_enc.y, _odo_enc.heading, _kal_wheel.x,
-                _kal_wheel.y, _kal_wheel.heading, _kal_acc.x, _kal_acc.y, _kal_acc.heading);
+                _kal_wheel.y, _kal_wheel.heading, _kal_acc.x, _kal_acc.y, _kal_acc.heading};
+
+        // Written or not depending on the log policy
+        log_stream_push(&log_stream, row);
     }
 
 }
@@ -18,60 +18,163 @@
 #include <webots/emitter.h>
 #include <webots/supervisor.h>
 
-//These parameters must be adapted for each flock and world
-#define FLOCK_SIZE	1 		// Total number of robots in simulation
-
-// This line must be uncommented for all simulaltions in the obstacle or localization world or for crossing with 2 teams of 5 or more robots each 
-static int robot_id[14] = {0,1,2,3,4,5,6,7,8,9,10,11,12,13}; //names of robots: epuck%d
-//Else, use:
-// - For crossing with 2 robots in each team:
-//static int robot_id[14] = {0,1,5,6}; //names of robots: epuck%d
-//- For crossing with 3 robots in each team:
-//static int robot_id[14] = {0,1,2,5,6,7}; //names of robots: epuck%d
-//- For crossing with 4 robots in each team:
-//static int robot_id[14] = {0,1,2,4,5,6,7,9}; //names of robots: epuck%d
+#include "../common/trajectory_codec.h"
+#include "../common/log_policy.h"
+#include "../common/timing.h"
 
+// The roster is discovered at startup: every top-level node whose DEF is "epuck<id>" is logged.
+// Robots are sorted by id so the columns of the log file do not depend on the order of the scene tree.
+#define ROBOT_DEF_FORMAT	"epuck%d%n"	// DEF name of the robots to log
 
 #define TIME_STEP	16		// [ms] Length of time step
 
-static WbNodeRef robs[FLOCK_SIZE];              // Robots nodes
-static WbFieldRef robs_translation[FLOCK_SIZE]; // Robots translation fields
-static WbFieldRef robs_rotation[FLOCK_SIZE];    // Robots rotation fields
+// Compressed log (decompress with tools/trj2csv to get back supervisor_log.csv)
+#define LOG_COMPRESSED		0		// 1: write supervisor_log.trj instead of supervisor_log.csv
+#define LOG_RES_TIME		1e-3		// [s] Resolution of the time column
+#define LOG_RES_POS		1e-5		// [m] Resolution of the positions (0 for lossless)
+#define LOG_RES_HEADING		1e-5		// [rad] Resolution of the headings (0 for lossless)
+#define LOG_KEYFRAME_INTERVAL	256		// Number of steps between two keyframes (random access granularity)
+
+// Log policy (see common/log_policy.h): LOG_ALWAYS, LOG_DECIMATE or LOG_ON_CHANGE
+#define LOG_MODE		LOG_ALWAYS
+#define LOG_DECIMATION		10		// LOG_DECIMATE: write one step out of LOG_DECIMATION
+#define LOG_CHANGE_THRESHOLD	1e-3		// LOG_ON_CHANGE: [m or rad] minimal change of a position to write a step
+#define LOG_BURST_PRE		30		// Steps written before a collision
+#define LOG_BURST_POST		30		// Steps written after a collision
+#define ROB_RAD			0.035		// [m] Radius of the robots (collision detection)
+
+static int flock_size = 0;		// Number of robots found in the world
+static int *robot_id = NULL;		// Names of robots: epuck%d
+static WbNodeRef *robs = NULL;		// Robots nodes
+static WbFieldRef *robs_translation = NULL;	// Robots translation fields
+static WbFieldRef *robs_rotation = NULL;	// Robots rotation fields
 
 //define variables
 float t = 0;
-float loc[FLOCK_SIZE][3];	// True location of each robot in the flock
+float (*loc)[3] = NULL;	// True location of each robot in the flock
 static FILE *fp = NULL;
+static trj_writer_t *trj = NULL;	// Compressed log (LOG_COMPRESSED)
+static double *log_row = NULL;		// Row buffer of the log
+static log_stream_t log_stream;		// Applies the log policy
+static int n_contacts = 0;		// Number of pairs of robots in contact at the last step
 static double time_step;
 
+/*
+ * Check whether a DEF name is the one of a robot and extract its id.
+ */
+static int parse_robot_def(const char *def, int *id) {
+	int len = 0;
+	if (def == NULL || sscanf(def, ROBOT_DEF_FORMAT, id, &len) != 1)
+		return 0;
+	return def[len] == '\0';	// reject DEF names such as "epuck0_plate"
+}
+
+static int compare_robot_id(const void *a, const void *b) {
+	return ((const int *)a)[0] - ((const int *)b)[0];
+}
+
+/*
+ * Enumerate the robots of the world from the children of the scene tree root.
+ */
+void discover_robots(void) {
+	WbFieldRef children = wb_supervisor_node_get_field(wb_supervisor_node_get_root(), "children");
+	int n_children = wb_supervisor_field_get_count(children);
+	int (*found)[2] = malloc(n_children*sizeof(*found));	// {id, index in children}
+	int i, id;
+
+	flock_size = 0;
+	for (i=0;i<n_children;i++) {
+		WbNodeRef node = wb_supervisor_field_get_mf_node(children, i);
+		if (parse_robot_def(wb_supervisor_node_get_def(node), &id)) {
+			found[flock_size][0] = id;
+			found[flock_size][1] = i;
+			flock_size++;
+		}
+	}
+	qsort(found, flock_size, sizeof(*found), compare_robot_id);
+
+	robot_id = malloc(flock_size*sizeof(*robot_id));
+	robs = malloc(flock_size*sizeof(*robs));
+	robs_translation = malloc(flock_size*sizeof(*robs_translation));
+	robs_rotation = malloc(flock_size*sizeof(*robs_rotation));
+	loc = calloc(flock_size, sizeof(*loc));
+
+	for (i=0;i<flock_size;i++) {
+		robot_id[i] = found[i][0];
+		robs[i] = wb_supervisor_field_get_mf_node(children, found[i][1]);
+		robs_translation[i] = wb_supervisor_node_get_field(robs[i],"translation");
+		robs_rotation[i] = wb_supervisor_node_get_field(robs[i],"rotation");
+	}
+	free(found);
+
+	printf("Supervisor found %d robots:", flock_size);
+	for (i=0;i<flock_size;i++)
+		printf(" epuck%d", robot_id[i]);
+	printf("\n");
+	if (flock_size == 0)
+		printf("Warning: no robot with a DEF name epuck<id> in the world, the log will be empty.\n");
+}
+
 /*
  * Initialize robots devices. 
  */
 void reset_robots(void) {
 	wb_robot_init();
+	TIMING_INIT(wb_robot_get_name());
 	time_step = wb_robot_get_basic_time_step()/1000; //convert to second (for use in log file)
-	char rob[7] = "epuck0";
-	int i;
-	for (i=0;i<FLOCK_SIZE;i++) {
-		sprintf(rob,"epuck%d",robot_id[i]);
-		robs[i] = wb_supervisor_node_get_from_def(rob);
-		robs_translation[i] = wb_supervisor_node_get_field(robs[i],"translation");
-		robs_rotation[i] = wb_supervisor_node_get_field(robs[i],"rotation");
-                      sscanf(rob, "epuck%d", &robot_id[i]);
-                      
-	}
+	discover_robots();
 
 	return; 
 
 }
 
+// Write one row of the log file (called by the log stream)
+void supervisor_write_row(void *ctx, const double *row, int n_values)
+{
+  if (trj != NULL)
+    trj_write_row(trj, row);
+  if (fp != NULL)
+    log_csv_sink(fp, row, n_values);
+}
+
+// Build the header line of the log file: "time;true_x_rob0; true_y_rob0; true_heading_rob0;..."
+char* supervisor_log_header(void)
+{
+  char *header = malloc(8 + flock_size*64);
+  int len = sprintf(header, "time;");
+  for(int i=0;i<flock_size;i++)
+  {
+    len += sprintf(header+len, "true_x_rob%d; true_y_rob%d; true_heading_rob%d", robot_id[i], robot_id[i], robot_id[i]);
+    if (i != flock_size-1){
+	//for all robots except the last, add ';'
+	len += sprintf(header+len, ";");
+    }
+  }
+  return header;
+}
+
 // Initialize the log file 
 void supervisor_init_log(const char* filename)
 {
-  fp = fopen(filename,"w");
+  char *header = supervisor_log_header();
+
+  if (LOG_COMPRESSED) {
+    double *quantum = malloc((1+3*flock_size)*sizeof(double));
+    quantum[0] = LOG_RES_TIME;
+    for (int i=0;i<flock_size;i++) {
+      quantum[1+3*i] = LOG_RES_POS;
+      quantum[2+3*i] = LOG_RES_POS;
+      quantum[3+3*i] = LOG_RES_HEADING;
+    }
+    trj = trj_open_write(filename, header, 1+3*flock_size, quantum, LOG_KEYFRAME_INTERVAL);
+    free(quantum);
+  }
+  else {
+    fp = fopen(filename,"w");
+  }
   
   //Check that the file was opened correctly
-  if (fp == NULL){
+  if (fp == NULL && trj == NULL){
   printf("Error opening file.\n");
   }
   else {
@@ -80,46 +183,48 @@ void supervisor_init_log(const char* filename)
  
   
   //print header values
-  fprintf(fp, "time;"); 
-  for(int i=0;i<FLOCK_SIZE;i++)
-  {
-    fprintf(fp, "true_x_rob%d; true_y_rob%d; true_heading_rob%d", robot_id[i], robot_id[i], robot_id[i]); 
-     if (i != FLOCK_SIZE-1){
-	//for all robots except the last, add ';'
-	fprintf(fp, ";");
-		  }
-  }
-  fprintf(fp, "\n"); 
+  if (fp != NULL)
+    fprintf(fp, "%s\n", header); 
+  free(header);
 
- 
+  log_policy_t policy = {LOG_MODE, LOG_DECIMATION, LOG_CHANGE_THRESHOLD, 1, LOG_BURST_PRE, LOG_BURST_POST};
+  log_row = malloc((1+3*flock_size)*sizeof(double));
+  log_stream_init(&log_stream, &policy, 1+3*flock_size, supervisor_write_row, NULL);
+}
+
+// Signal a log event when robots get in contact (the steps around it are logged at full resolution)
+void supervisor_detect_collisions()
+{
+  int contacts = 0;
+  for (int i=0;i<flock_size;i++) {
+    for (int j=i+1;j<flock_size;j++) {
+      double dx = loc[i][0]-loc[j][0];
+      double dz = loc[i][1]-loc[j][1];
+      if (dx*dx+dz*dz < 4*ROB_RAD*ROB_RAD)
+        contacts++;
+    }
+  }
+  if (contacts > n_contacts)
+    log_stream_event(&log_stream);
+  n_contacts = contacts;
 }
 
 void supervisor_print_log()
 {
 	//Write down true robot positions in a log file
-	//i corresponds to current robot
-	//Each line will contain the true position of each robot and time
-  if( fp != NULL)
-    {	
-             //Write time at the beginning of the line
-	  fprintf(fp,"%g;",t);
+	//Each line will contain the time and the true position of each robot
+  if (fp != NULL || trj != NULL)
+    {
+	  log_row[0] = t;
 	  //For each robot, write true x, y and heading
-	  for (int i=0;i<FLOCK_SIZE;i++) {
-	      fprintf(fp,"%g; %g; %g", loc[i][0], loc[i][1], loc[i][2]);
-	      
-	      if (i != FLOCK_SIZE-1){
-			  //for all robots except the last, add ','
-			  fprintf(fp, ";");
-		  }
-                  else{
-	  //Start new line if last robot
-        	  fprintf(fp, "\n");
+	  for (int i=0;i<flock_size;i++) {
+	      log_row[1+3*i] = loc[i][0];
+	      log_row[2+3*i] = loc[i][1];
+	      log_row[3+3*i] = loc[i][2];
 	  }
-	  }
-
-
-  }
-
+	  //Written or not depending on the log policy
+	  log_stream_push(&log_stream, log_row);
+    }
 }
 
 int main(int argc, char *args[]) {
@@ -129,14 +234,13 @@ int main(int argc, char *args[]) {
 	
 	//Initialize log file where true positions will be written
            char filename[64];
-           sprintf(filename, "supervisor_log.csv");
+           sprintf(filename, LOG_COMPRESSED ? "supervisor_log.trj" : "supervisor_log.csv");
 	
 	
            supervisor_init_log(filename);
 		
-	for(;;) {	//enter infinite loop
-		wb_robot_step(TIME_STEP);
-		for (int i=0;i<FLOCK_SIZE;i++) {
+	while (TIMING_ROBOT_STEP(TIME_STEP) != -1) {	//loop until the simulation ends
+		TIMING_SCOPE("positions") for (int i=0;i<flock_size;i++) {
 			// Get true position data for each robot
 			loc[i][0] = wb_supervisor_field_get_sf_vec3f(robs_translation[i])[0]; // X
 			loc[i][1] = wb_supervisor_field_get_sf_vec3f(robs_translation[i])[2]; // Z
@@ -144,11 +248,22 @@ int main(int argc, char *args[]) {
 			
 		}
 		//Write down true positions in a log file 
-		supervisor_print_log();
+		TIMING_SCOPE("collisions") supervisor_detect_collisions();
+		TIMING_SCOPE("log") supervisor_print_log();
 		t += time_step; //update time
 	}
-  fflush(fp);
-  fclose(fp);
+  if (fp != NULL) {
+    fflush(fp);
+    fclose(fp);
+  }
+  log_stream_free(&log_stream);
+  trj_close_write(trj);
+  free(log_row);
+  free(robot_id);
+  free(robs);
+  free(robs_translation);
+  free(robs_rotation);
+  free(loc);
 }
 
 
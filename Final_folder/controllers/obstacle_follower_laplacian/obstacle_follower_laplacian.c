@@ -30,6 +30,8 @@
 #include <webots/distance_sensor.h>
 #include <webots/emitter.h>
 #include <webots/receiver.h>
+#include "../common/timing.h"
+#include "../common/telemetry.h"
 
 // ------------------------- Choose the flock size and the number of edges of the graph -------------------------
 #define FLOCK_SIZE  5  // Size of flock (3,4 or 5)
@@ -75,6 +77,7 @@ WbDeviceTag emitter;		 //handler for the emitter node
 
 int fsm_state = 0;           // Finite state machine's state
 int robot_id_u;	             // Unique robot ID
+static telemetry_t telemetry;       // Live telemetry (see common/telemetry.h)
 char* robot_name;
 
 float meas_range_laplacian[MAX_FLOCK_SIZE];   // measured range for robot i to every robot j
@@ -141,6 +144,8 @@ float target_range[MAX_FLOCK_SIZE][MAX_FLOCK_SIZE] =  {{   0.0    ,   0.1414  ,
  */
 static void reset() {
 	wb_robot_init();
+	TIMING_INIT(wb_robot_get_name());
+	telemetry_open(&telemetry, wb_robot_get_name());
 	
 	receiver = wb_robot_get_device("receiver");
 	emitter = wb_robot_get_device("emitter");
@@ -270,6 +275,7 @@ void process_received_ping_messages(void) {
           }
           
           friend_robot_id = (int)(inbuffer[5]-'0');  // since the name of the sender is in the received message.
+          telemetry_neighbor(&telemetry, friend_robot_id, range, bearing);
 		
           meas_range_laplacian[friend_robot_id] = range;
           meas_bearing_laplacian[friend_robot_id] = bearing;
@@ -470,7 +476,7 @@ int main(){
             max_sens = 0;
             
             // Braitenberg
-            for(i = 0; i < NB_SENSORS; i++) {
+            TIMING_SCOPE("sensors") for(i = 0; i < NB_SENSORS; i++) {
                 ds_value[i] = wb_distance_sensor_get_value(ds[i]); //Read sensor values
                   sum_sensors += ds_value[i]; // Add up sensor values
                   max_sens = max_sens>ds_value[i]?max_sens:ds_value[i]; // Check if new highest sensor value
@@ -484,8 +490,8 @@ int main(){
               bmsl+=66; bmsr+=72;
         
               /* Send and get information */
-              send_ping();  // sending a ping to other robot, so they can measure their distance to this robot
-              process_received_ping_messages();
+              TIMING_SCOPE("send_ping") send_ping();  // sending a ping to other robot, so they can measure their distance to this robot
+              TIMING_SCOPE("ping") process_received_ping_messages();
             
              // Condition for entering obstacle avoidance state (threshold on one of the four front sensors)
              if ((ds_value[0] > AVOIDANCE_THRESH ||
@@ -495,7 +501,7 @@ int main(){
                 fsm_state = AVOIDANCE;
              }
              if (fsm_state == FORMATION){ //formation state --- do only formation
-                range_bearing_to_command(&msl, &msr);//formation command
+                TIMING_SCOPE("formation") range_bearing_to_command(&msl, &msr);//formation command
              }
              else{ //avoidance state --- do only braitenberg
                 msl = bmsl;
@@ -507,16 +513,23 @@ int main(){
             msl_w = msl*MAX_SPEED_WEB/(MAX_SPEED+1);
             msr_w = msr*MAX_SPEED_WEB/(MAX_SPEED+1);
                                     
-            wb_motor_set_velocity(left_motor, msl_w);
-            wb_motor_set_velocity(right_motor, msr_w);
+            TIMING_SCOPE("motors") {
+                wb_motor_set_velocity(left_motor, msl_w);
+                wb_motor_set_velocity(right_motor, msr_w);
+            }
                                
             //Condition to exit avoidance state
             if((fsm_state == AVOIDANCE) && (max_sens < FORMATION_THRESH)){ //Exit condition of "avoidance
                fsm_state = FORMATION;
             }
 
+            // Publish the live telemetry
+            telemetry.state.time = wb_robot_get_time();
+            telemetry.state.fsm_state = fsm_state;
+            telemetry_publish(&telemetry);
+
             // Continue one step
-            wb_robot_step(TIME_STEP);
+            TIMING_ROBOT_STEP(TIME_STEP);
     }
 }
 
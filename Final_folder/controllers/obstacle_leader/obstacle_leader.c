@@ -16,6 +16,8 @@
 #include "../localization_controller/utils.h"
 #include "../localization_controller/odometry.h"
 #include "../localization_controller/kalman.h"
+#include "../common/timing.h"
+#include "../common/telemetry.h"
 
 #include <webots/robot.h>
 #include <webots/gps.h>
@@ -74,6 +76,7 @@ WbDeviceTag receiver;       // Handle for the receiver node
 WbDeviceTag emitter;        // Handle for the emitter node
 
 int robot_id_u;                  // Unique robot ID
+static telemetry_t telemetry;       // Live telemetry (see common/telemetry.h)
 char* robot_name;
 
 int fsm_state;                   // leader's state of the FSM (avoidance or migration)
@@ -93,6 +96,8 @@ double migr[2] = {4.4, 0};
  */
 static void reset() {
 	wb_robot_init();
+	TIMING_INIT(wb_robot_get_name());
+	telemetry_open(&telemetry, wb_robot_get_name());
     dev_gps = wb_robot_get_device("gps");
     wb_gps_enable(dev_gps, 1000); // Enable GPS every 1000ms <=> 1s
     time_step = wb_robot_get_basic_time_step();
@@ -279,14 +284,14 @@ int main(){
             time_step = wb_robot_get_basic_time_step();
             
             // Position with frame initial point stored in _pose vector
-            controller_get_pose_gps();
+            TIMING_SCOPE("gps") controller_get_pose_gps();
             
             // Get the encoder values (wheel motor values)
-            controller_get_encoder();
+            TIMING_SCOPE("encoders") controller_get_encoder();
             
             time_now_s = wb_robot_get_time();
             // Kalman with wheel encoders
-            compute_kalman_wheels(&_kal_wheel, time_step, time_now_s, _meas.left_enc - _meas.prev_left_enc,_meas.right_enc - _meas.prev_right_enc, _pose);
+            TIMING_SCOPE("kalman") compute_kalman_wheels(&_kal_wheel, time_step, time_now_s, _meas.left_enc - _meas.prev_left_enc,_meas.right_enc - _meas.prev_right_enc, _pose);
             
             bmsl = 0;
             bmsr = 0;
@@ -294,7 +299,7 @@ int main(){
             max_sens = 0;
 
               // Braitenberg
-              for(i = 0; i < NB_SENSORS; i++) {
+              TIMING_SCOPE("sensors") for(i = 0; i < NB_SENSORS; i++) {
                       ds_value[i] = wb_distance_sensor_get_value(ds[i]); //Read sensor values
                       sum_sensors += ds_value[i]; // Add up sensor values
                       max_sens = max_sens>ds_value[i]?max_sens:ds_value[i]; // Check if new highest sensor value
@@ -308,7 +313,7 @@ int main(){
               bmsl+=66;
               bmsr+=72;
               
-              send_ping();  // sending a ping to other robot, so they can measure their distance to this robot
+              TIMING_SCOPE("send_ping") send_ping();  // sending a ping to other robot, so they can measure their distance to this robot
 
               // Condition for entering obstacle avoidance state (threshold on one of the four front sensors)
               if ((ds_value[0] > AVOIDANCE_THRESH ||
@@ -354,16 +359,26 @@ int main(){
             msl_w = msl*MAX_SPEED_WEB/1000;
             msr_w = msr*MAX_SPEED_WEB/1000;
 
-            wb_motor_set_velocity(left_motor, msl_w);
-            wb_motor_set_velocity(right_motor, msr_w);
+            TIMING_SCOPE("motors") {
+                wb_motor_set_velocity(left_motor, msl_w);
+                wb_motor_set_velocity(right_motor, msr_w);
+            }
                
             //Condition to exit avoidance state
             if((fsm_state == AVOIDANCE) && (max_sens < MIGRATION_THRESH)){ //Exit condition of avoidance state 
                 fsm_state = MIGRATION;
             }
 
+            // Publish the live telemetry
+            telemetry.state.time = wb_robot_get_time();
+            telemetry.state.x = _kal_wheel.x;
+            telemetry.state.y = _kal_wheel.y;
+            telemetry.state.heading = _kal_wheel.heading;
+            telemetry.state.fsm_state = fsm_state;
+            telemetry_publish(&telemetry);
+
             // Continue one step --> on change de robot!
-            wb_robot_step(TIME_STEP);
+            TIMING_ROBOT_STEP(TIME_STEP);
          }
  }
     
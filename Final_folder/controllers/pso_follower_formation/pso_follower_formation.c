@@ -28,6 +28,8 @@
 #include <webots/distance_sensor.h>
 #include <webots/emitter.h>
 #include <webots/receiver.h>
+#include "../common/timing.h"
+#include "../common/pso_msg.h"
 
 // ------------------------- Choose the flock size and the number of edges of the graph -------------------------
 #define FLOCK_SIZE  5  // Size of flock (3,4 or 5)
@@ -41,6 +43,7 @@
 #define MAX_FLOCK_SIZE      5     // Maximum size of flock
 #define MAX_NB_EDGES        10    // Maximum number of edges (fully connected)
 #define TIME_STEP           64    // Length of time step in [ms]
+#define PING_CHANNEL      1000    // Ping channel of the flock 0 (flock f uses PING_CHANNEL+f)
 
 #define AXLE_LENGTH         0.052    // Distance between wheels of robot (meters)
 #define WHEEL_RADIUS        0.0205   // Wheel radius (meters)
@@ -62,9 +65,12 @@ WbDeviceTag receiver;		// Handle for the receiver node for flocking
 WbDeviceTag emitter;		// Handle for the emitter node for flocking
 WbDeviceTag rec_pso;		// Handle for the receiver node for PSO
 WbDeviceTag emit_pso;		// Handle for the emitter node for PSO
+pso_msg_t msg;			// Message of the supervisor or to the supervisor (see common/pso_msg.h)
+uint32_t episode;		// Episode of the weights received
+int episode_steps = SIM_STEPS;	// Steps of the episode received (curriculum, see common/pso_msg.h)
 
 int fsm_state = 0;           // Finite state machine's state
-int robot_id_u;	             // Unique robot ID
+int robot_id_u, robot_id;    // Unique and normalized (between 0 and FLOCK_SIZE-1) robot ID
 char* robot_name;
 int robot_verbose=0;         // boolean to know for which robot we print
 
@@ -132,6 +138,7 @@ float target_range[MAX_FLOCK_SIZE][MAX_FLOCK_SIZE] =  {{   0.0    ,   0.1414  ,
  */
 static void reset() {
     wb_robot_init();
+    TIMING_INIT(wb_robot_get_name());
 
     receiver = wb_robot_get_device("receiver");
     emitter = wb_robot_get_device("emitter");
@@ -159,8 +166,9 @@ static void reset() {
 
     //Reading the robot's name. Pay attention to name specification when adding robots to the simulation!
     sscanf(robot_name,"epuck%d",&robot_id_u); // read robot id from the robot's name
+    robot_id = robot_id_u%FLOCK_SIZE;         // normalize between 0 and FLOCK_SIZE-1
 
-    if(robot_id_u==0){ // print robot data
+    if(robot_id==0){ // print robot data
         robot_verbose=1;
     }
 
@@ -169,6 +177,12 @@ static void reset() {
     rec_pso = wb_robot_get_device("receiver_epuck_pso");
     wb_receiver_enable(rec_pso, TIME_STEP/2);
 
+    // Broadcast channel of the supervisor, private channel of the fitness and one ping channel per flock
+    wb_receiver_set_channel(rec_pso, PSO_MSG_CHANNEL);
+    wb_emitter_set_channel(emit_pso, 2*robot_id_u+1);
+    wb_receiver_set_channel(receiver, PING_CHANNEL + robot_id_u/FLOCK_SIZE);
+    wb_emitter_set_channel(emitter, PING_CHANNEL + robot_id_u/FLOCK_SIZE);
+
 }
 
 
@@ -269,7 +283,8 @@ void process_received_ping_messages(void) {
       	       bearing = bearing + 2*M_PI;
           }
 
-          friend_robot_id = (int)(inbuffer[5]-'0');  // since the name of the sender is in the received message.
+          sscanf(inbuffer,"epuck%d",&friend_robot_id);  // since the name of the sender is in the received message.
+          friend_robot_id %= FLOCK_SIZE;                 // normalize between 0 and FLOCK_SIZE-1
 
           meas_range_laplacian[friend_robot_id] = range;
           meas_bearing_laplacian[friend_robot_id] = bearing;
@@ -389,11 +404,11 @@ void range_bearing_to_command(int *msl, int *msr, float Ku, float Kw){
 
     for (i = 0; i < FLOCK_SIZE; i++){
 
-         card_nb += Cardinality[robot_id_u][i];
+         card_nb += Cardinality[robot_id][i];
 
-         if (Cardinality[robot_id_u][i] == 1){
-             e_xi += - (meas_range_laplacian[i] - target_range[robot_id_u][i])*L[robot_id_u][i]*cosf(meas_bearing_laplacian[i]);
-             e_yi += - (meas_range_laplacian[i] - target_range[robot_id_u][i])*L[robot_id_u][i]*sinf(meas_bearing_laplacian[i]);
+         if (Cardinality[robot_id][i] == 1){
+             e_xi += - (meas_range_laplacian[i] - target_range[robot_id][i])*L[robot_id][i]*cosf(meas_bearing_laplacian[i]);
+             e_yi += - (meas_range_laplacian[i] - target_range[robot_id][i])*L[robot_id][i]*sinf(meas_bearing_laplacian[i]);
          }
     }
 
@@ -456,17 +471,17 @@ void simulation_webot(double weights[DATASIZE+1]){
     int ds_value[NB_SENSORS];       // Array for the distance sensor readings
     int max_sens;                   // Store highest sensor value
     init_laplacian_matrices();      // Initialize the matrices (C,I,W)
-    compute_laplacian();            // Compute laplacian
+    TIMING_SCOPE("laplacian") compute_laplacian();            // Compute laplacian
 
     fsm_state = FORMATION;           // initial FSM's state: formation
 
-    for(j=0;j<SIM_STEPS;j++){
+    for(j=0;j<episode_steps;j++){
         bmsl = 0; bmsr = 0;
         sum_sensors = 0;
         max_sens = 0;
 
         // Braitenberg
-        for(i = 0; i < NB_SENSORS; i++) {
+        TIMING_SCOPE("sensors") for(i = 0; i < NB_SENSORS; i++) {
             ds_value[i] = wb_distance_sensor_get_value(ds[i]); //Read sensor values
             sum_sensors += ds_value[i]; // Add up sensor values
             max_sens = max_sens>ds_value[i]?max_sens:ds_value[i]; // Check if new highest sensor value
@@ -480,8 +495,8 @@ void simulation_webot(double weights[DATASIZE+1]){
         bmsl+=66; bmsr+=72;
 
         /* Send and get information */
-        send_ping();  // sending a ping to other robot, so they can measure their distance to this robot
-        process_received_ping_messages();
+        TIMING_SCOPE("send_ping") send_ping();  // sending a ping to other robot, so they can measure their distance to this robot
+        TIMING_SCOPE("ping") process_received_ping_messages();
 
         // Condition for entering obstacle avoidance state (threshold on one of the four front sensors)
         if ((ds_value[0] > weights[NB_SENSORS] ||
@@ -491,7 +506,7 @@ void simulation_webot(double weights[DATASIZE+1]){
               fsm_state = AVOIDANCE;
         }
         if (fsm_state == FORMATION){ //formation state --- do only formation
-             range_bearing_to_command(&msl, &msr, weights[NB_SENSORS+2]/SCALING_P, weights[NB_SENSORS+3]/SCALING_P);//formation command
+             TIMING_SCOPE("formation") range_bearing_to_command(&msl, &msr, weights[NB_SENSORS+2]/SCALING_P, weights[NB_SENSORS+3]/SCALING_P);//formation command
         }
         else{ //avoidance state --- do only braitenberg
              msl = bmsl;
@@ -503,8 +518,10 @@ void simulation_webot(double weights[DATASIZE+1]){
         msl_w = msl*MAX_SPEED_WEB/(MAX_SPEED+1);
         msr_w = msr*MAX_SPEED_WEB/(MAX_SPEED+1);
 
-        wb_motor_set_velocity(left_motor, msl_w);
-        wb_motor_set_velocity(right_motor, msr_w);
+        TIMING_SCOPE("motors") {
+            wb_motor_set_velocity(left_motor, msl_w);
+            wb_motor_set_velocity(right_motor, msr_w);
+        }
 
         //Condition to exit avoidance state
         if((fsm_state == AVOIDANCE) && (max_sens < weights[NB_SENSORS+1])){ //Exit condition of "avoidance
@@ -512,7 +529,7 @@ void simulation_webot(double weights[DATASIZE+1]){
         }
 
         // Continue one step
-        wb_robot_step(TIME_STEP);
+        TIMING_ROBOT_STEP(TIME_STEP);
     }
 }
 
@@ -522,8 +539,7 @@ void simulation_webot(double weights[DATASIZE+1]){
 */
 int main() {
     // Init
-    double end_sim[255];
-    double *new_weights;
+    double new_weights[DATASIZE+1];  // weights and spawn z of this robot
     double fitness=-1;
     reset();
     wb_motor_set_velocity(left_motor, 0);  // Initialize robot velocity to zero
@@ -533,21 +549,30 @@ int main() {
     while (1) {
         // Wait for data
         while (wb_receiver_get_queue_length(rec_pso) == 0) {
-            wb_robot_step(TIME_STEP);
+            TIMING_ROBOT_STEP(TIME_STEP);
+        }
+
+        // Weights of this robot (the aborts of the racing that arrived after the end of an episode are skipped)
+        if (pso_msg_read(&msg,wb_receiver_get_data(rec_pso),wb_receiver_get_data_size(rec_pso)) ||
+            pso_msg_weights(&msg,robot_id_u,DATASIZE,new_weights)) {
+            wb_receiver_next_packet(rec_pso);
+            continue;
         }
+        episode = msg.h.episode;
+        episode_steps = pso_msg_steps(msg.h.length,SIM_STEPS);
+        wb_receiver_next_packet(rec_pso);
 
         // Print weight
         if( 1 && robot_verbose){printf("************************ Weight ***************************\n");}
-        new_weights = (double *)wb_receiver_get_data(rec_pso); // receive weight from supervisor
         printf("Robot %d : %.2lf, %.2lf, %.2lf, %.2lf, %.2lf, %.2lf, %.2lf, %.2lf\n         %.2lf, %.2lf, %.2lf, %.2lf, %.2lf, %.2lf, %.2lf, %.2lf\n %.2lf, %.2lf, %.2lf, %.4lf, %.4lf\n----------------------------\n",robot_id_u, new_weights[0], new_weights[1],new_weights[2], new_weights[3], new_weights[4], new_weights[5],new_weights[6], new_weights[7],new_weights[7]+2, new_weights[6]+2, new_weights[5]+2, new_weights[4]+2, new_weights[3]+2, new_weights[2]+2, new_weights[1]+2, new_weights[0]+2, new_weights[8], new_weights[9],new_weights[10], new_weights[11], new_weights[12]);
 
         // Run simulation
-        simulation_webot(new_weights);
-        end_sim[0]=fitness;
+        TIMING_SCOPE("episode") simulation_webot(new_weights);
+        pso_msg_init(&msg,PSO_MSG_FITNESS,episode,robot_id_u,1);
+        msg.values[msg.h.count++] = fitness;
 
         // Send signal to supervisor
-        wb_emitter_send(emit_pso, (void *)end_sim, sizeof(double));
-        wb_receiver_next_packet(rec_pso);
+        wb_emitter_send(emit_pso,(void *)&msg,pso_msg_size(&msg));
 
         if( 1 && robot_verbose){printf("********************************************************\n");}
     }
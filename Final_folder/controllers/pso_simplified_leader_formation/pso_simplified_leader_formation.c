@@ -15,6 +15,9 @@
 #include "../localization_controller/utils.h"
 #include "../localization_controller/odometry.h"
 #include "../localization_controller/kalman.h"
+#include "../common/log_policy.h"
+#include "../common/timing.h"
+#include "../common/pso_msg.h"
 
 #include <webots/robot.h>
 #include <webots/gps.h>
@@ -46,10 +49,19 @@
 #define SIM_STEPS 1200       // Number of simulation steps/iterations (Change it also in Leader)
 #define DATASIZE 4           // Number of elements in particle
 
+// LOG  -------------------- Log policy of log_file_robot<id>.csv (see common/log_policy.h) ----------------------------
+#define LOG_MODE LOG_DECIMATE           // LOG_ALWAYS, LOG_DECIMATE or LOG_ON_CHANGE
+#define LOG_DECIMATION 10               // LOG_DECIMATE: write one step out of LOG_DECIMATION
+#define LOG_CHANGE_THRESHOLD 0.01       // LOG_ON_CHANGE: minimal change of the pose to write a step
+#define LOG_BURST_PRE 10                // Steps written before an FSM transition
+#define LOG_BURST_POST 10               // Steps written after an FSM transition
+#define LOG_N_VALUES 5                  // time; kal_wheel_x; kal_wheel_y; kal_wheel_heading; fsm_state
+
 /*MACRO*/
 #define CATCH(X, Y)      X = X || Y
 #define CATCH_ERR(X, Y)  controller_error(X, Y, __LINE__, __FILE__)
 static FILE *fp;
+static log_stream_t log_stream;
 
 /*FUNCTIONS*/
 static void controller_get_pose_gps();
@@ -70,6 +82,9 @@ WbDeviceTag receiver;       // Handle for the receiver node
 WbDeviceTag emitter;        // Handle for the emitter node
 WbDeviceTag rec_pso;		// Handle for the receiver node for PSO
 WbDeviceTag emit_pso;		// Handle for the emitter node for PSO
+pso_msg_t msg;			// Message of the supervisor or to the supervisor (see common/pso_msg.h)
+uint32_t episode;		// Episode of the weights received
+int episode_steps = SIM_STEPS;	// Steps of the episode received (curriculum, see common/pso_msg.h)
 
 int robot_id_u;                  // Unique robot ID
 char* robot_name;
@@ -95,6 +110,7 @@ double migr[2] = {4.4, -0.45};
  */
 static void reset() {
     wb_robot_init();
+    TIMING_INIT(wb_robot_get_name());
     dev_gps = wb_robot_get_device("gps");
     wb_gps_enable(dev_gps, 1); // Enable GPS every 1000ms <=> 1s
     time_step = wb_robot_get_basic_time_step();
@@ -137,6 +153,7 @@ static void reset() {
     emit_pso = wb_robot_get_device("emitter_epuck_pso");
     rec_pso = wb_robot_get_device("receiver_epuck_pso");
     wb_receiver_enable(rec_pso, TIME_STEP/2);
+    wb_receiver_set_channel(rec_pso, PSO_MSG_CHANNEL);  // Weights broadcast by the supervisor to the whole flock
 }
 
 
@@ -284,20 +301,20 @@ int simulation_webot(double new_weights[DATASIZE]){
      fsm_state = MIGRATION;
 
      // Forever
-     for(j=0;j<SIM_STEPS;j++){
+     for(j=0;j<episode_steps;j++){
 
         // Get Position using Kalman
         time_step = wb_robot_get_basic_time_step();
 
         // Position with frame initial point stored in _pose vector
-        controller_get_pose_gps();
+        TIMING_SCOPE("gps") controller_get_pose_gps();
 
         // Get the encoder values (wheel motor values)
-        controller_get_encoder();
+        TIMING_SCOPE("encoders") controller_get_encoder();
 
         time_now_s = wb_robot_get_time();
         // Kalman with wheel encoders
-        compute_kalman_wheels(&_kal_wheel, time_step, time_now_s, _meas.left_enc - _meas.prev_left_enc,_meas.right_enc - _meas.prev_right_enc, _pose);
+        TIMING_SCOPE("kalman") compute_kalman_wheels(&_kal_wheel, time_step, time_now_s, _meas.left_enc - _meas.prev_left_enc,_meas.right_enc - _meas.prev_right_enc, _pose);
 
         bmsl = 0;
         bmsr = 0;
@@ -305,7 +322,7 @@ int simulation_webot(double new_weights[DATASIZE]){
         max_sens = 0;
 
         // Braitenberg
-        for(i = 0; i < NB_SENSORS; i++) {
+        TIMING_SCOPE("sensors") for(i = 0; i < NB_SENSORS; i++) {
             ds_value[i] = wb_distance_sensor_get_value(ds[i]); //Read sensor values
             sum_sensors += ds_value[i]; // Add up sensor values
             max_sens = max_sens>ds_value[i]?max_sens:ds_value[i]; // Check if new highest sensor value
@@ -320,7 +337,7 @@ int simulation_webot(double new_weights[DATASIZE]){
         bmsl+=66;
         bmsr+=72;
 
-        send_ping();  // sending a ping to other robot, so they can measure their distance to this robot
+        TIMING_SCOPE("send_ping") send_ping();  // sending a ping to other robot, so they can measure their distance to this robot
 
         // Condition for entering obstacle avoidance state (threshold on one of the four front sensors)
         if ((ds_value[0] > AVOIDANCE_THRESH ||
@@ -329,6 +346,7 @@ int simulation_webot(double new_weights[DATASIZE]){
                ds_value[1] > AVOIDANCE_THRESH) && (fsm_state == MIGRATION)){
 
             fsm_state = AVOIDANCE;
+            log_stream_event(&log_stream);
         }
 
         if (fsm_state == MIGRATION){ //migration
@@ -366,16 +384,23 @@ int simulation_webot(double new_weights[DATASIZE]){
         msl_w = msl*MAX_SPEED_WEB/1000;
         msr_w = msr*MAX_SPEED_WEB/1000;
 
-        wb_motor_set_velocity(left_motor, msl_w);
-        wb_motor_set_velocity(right_motor, msr_w);
+        TIMING_SCOPE("motors") {
+            wb_motor_set_velocity(left_motor, msl_w);
+            wb_motor_set_velocity(right_motor, msr_w);
+        }
 
         //Condition to exit avoidance state
         if((fsm_state == AVOIDANCE) && (max_sens < MIGRATION_THRESH)){ //Exit condition of avoidance state
             fsm_state = MIGRATION;
+            log_stream_event(&log_stream);
         }
 
+        // Log the step (written or not depending on the log policy)
+        double row[LOG_N_VALUES] = {wb_robot_get_time(), _kal_wheel.x, _kal_wheel.y, _kal_wheel.heading, fsm_state};
+        log_stream_push(&log_stream, row);
+
         // Continue one step --> on change de robot!
-        wb_robot_step(TIME_STEP);
+        TIMING_ROBOT_STEP(TIME_STEP);
       }
       return 0;
  }
@@ -386,8 +411,7 @@ int simulation_webot(double new_weights[DATASIZE]){
 */
 int main() {
     // Init
-    double end_sim[255];
-    double *new_weights;
+    double new_weights[DATASIZE+1];  // weights and spawn z of this robot
     double fitness=-1;
     reset();
     odo_reset(time_step);
@@ -398,12 +422,19 @@ int main() {
     while (1) {
         // Wait for data
         while (wb_receiver_get_queue_length(rec_pso) == 0) {
-            wb_robot_step(TIME_STEP);
+            TIMING_ROBOT_STEP(TIME_STEP);
         }
-
-        // Extract new weight from supervisor
-        new_weights = (double *)wb_receiver_get_data(rec_pso);
 
+        // Weights of this robot (the aborts of the racing that arrived after the end of an episode are skipped)
+        if (pso_msg_read(&msg,wb_receiver_get_data(rec_pso),wb_receiver_get_data_size(rec_pso)) ||
+            pso_msg_weights(&msg,robot_id_u,DATASIZE,new_weights)) {
+            wb_receiver_next_packet(rec_pso);
+            continue;
+        }
+        episode = msg.h.episode;
+        episode_steps = pso_msg_steps(msg.h.length,SIM_STEPS);
+        wb_receiver_next_packet(rec_pso);
+
         // Update initial position
         _pose.heading=0;
         _pose.y=0;
@@ -414,12 +445,12 @@ int main() {
         odo_reset(TIME_STEP);
 
         // Run simulation
-        fitness = simulation_webot(new_weights);
-        end_sim[0]=fitness;
+        TIMING_SCOPE("episode") fitness = simulation_webot(new_weights);
+        pso_msg_init(&msg,PSO_MSG_FITNESS,episode,robot_id_u,1);
+        msg.values[msg.h.count++] = fitness;
 
         // Send signal to supervisor
-        wb_emitter_send(emit_pso,(void *)end_sim,sizeof(double));
-        wb_receiver_next_packet(rec_pso);
+        wb_emitter_send(emit_pso,(void *)&msg,pso_msg_size(&msg));
 
     }
     return 0;
@@ -510,12 +541,18 @@ void controller_get_encoder() {
  * @return     return true if it fails
  */
 bool controller_init_log(const char *filename) {
+    // A new log is started for each simulation
+    if (fp != NULL) {
+        log_stream_free(&log_stream);
+        fclose(fp);
+    }
     fp = fopen(filename, "w");
     bool err = CATCH_ERR(fp == NULL, "Fails to create a log file\n");
 
     if (!err) {
-        fprintf(fp,
-                "time; pose_x; pose_y; pose_heading;  gps_x; gps_y; gps_z; acc_x; acc_y; acc_z; right_enc; left_enc; odo_acc_x; odo_acc_y; odo_acc_heading; odo_enc_x; odo_enc_y; odo_enc_heading; kal_wheel_x; kal_wheel_y; kal_wheel_heading; kal_acc_x; kal_acc_y; kal_acc_heading\n");
+        log_policy_t policy = {LOG_MODE, LOG_DECIMATION, LOG_CHANGE_THRESHOLD, 1, LOG_BURST_PRE, LOG_BURST_POST};
+        fprintf(fp, "time; kal_wheel_x; kal_wheel_y; kal_wheel_heading; fsm_state\n");
+        log_stream_init(&log_stream, &policy, LOG_N_VALUES, log_csv_sink, fp);
     }
 
     return err;
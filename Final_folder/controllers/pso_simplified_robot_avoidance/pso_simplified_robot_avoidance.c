@@ -26,6 +26,8 @@
 #include "../localization_controller/utils.h"
 #include "../localization_controller/odometry.h"
 #include "../localization_controller/kalman.h"
+#include "../common/timing.h"
+#include "../common/pso_msg.h"
 
 // ------------------------- Choose the flock size  -------------------------
 #define FLOCK_SIZE	       5	 // Size of flock
@@ -50,6 +52,7 @@
 #define SIM_STEPS 600               // number of simulation steps/iterations
 #define DATASIZE NB_SENSORS         // Number of elements in particle (2 Neurons with 8 proximity sensors and 5 params for flocking)
 #define SCALING_REYNOLD 1000
+#define PARTIAL_WINDOW 25           // Steps between two partial fitness messages to the supervisor
 
 WbDeviceTag left_motor; //handler for left wheel of the robot
 WbDeviceTag right_motor; //handler for the right wheel of the robot
@@ -58,6 +61,9 @@ WbDeviceTag receiver;		// Handle for the receiver node for flocking
 WbDeviceTag emitter;		// Handle for the emitter node for flocking
 WbDeviceTag rec_pso;		// Handle for the receiver node for PSO
 WbDeviceTag emit_pso;		// Handle for the emitter node for PSO
+pso_msg_t msg;			// Message of the supervisor or to the supervisor (see common/pso_msg.h)
+uint32_t episode;		// Episode of the weights received
+int episode_steps = SIM_STEPS;	// Steps of the episode received (curriculum, see common/pso_msg.h)
 WbDeviceTag left_encoder;//handler for left encoder of the robot
 WbDeviceTag right_encoder;//handler for right encoder of the robot
 WbDeviceTag dev_gps; // GPS handler
@@ -106,6 +112,7 @@ static double controller_get_heading_gps();
  */
 static void reset() {
       wb_robot_init();
+      TIMING_INIT(wb_robot_get_name());
       dev_gps = wb_robot_get_device("gps");
       wb_gps_enable(dev_gps, 1); // Enable GPS every 1000ms <=> 1s
       time_step = wb_robot_get_basic_time_step();
@@ -154,6 +161,7 @@ static void reset() {
     emit_pso = wb_robot_get_device("emitter_epuck_pso");
     rec_pso = wb_robot_get_device("receiver_epuck_pso");
     wb_receiver_enable(rec_pso, TIME_STEP/2);
+    wb_receiver_set_channel(rec_pso, PSO_MSG_CHANNEL);  // Weights broadcast by the supervisor to the whole flock
 }
 
 
@@ -254,6 +262,33 @@ void process_received_ping_messages(void) {
 }
 
 
+// Abort of the current episode received from the supervisor, the other messages are dropped
+int abort_received(void) {
+  int abort = 0;
+  while (!abort && wb_receiver_get_queue_length(rec_pso) > 0) {
+    abort = !pso_msg_read(&msg,wb_receiver_get_data(rec_pso),wb_receiver_get_data_size(rec_pso)) &&
+            msg.h.type == PSO_MSG_ABORT && msg.h.episode == episode && pso_msg_addressed(&msg,robot_id_u);
+    wb_receiver_next_packet(rec_pso);
+  }
+  return abort;
+}
+
+// Send the fitness terms of the steps so far to the supervisor: sums of the speed, of the speed difference and of
+// the most active sensor (the fitness of the episode if it ended now is computed from them as at the end)
+void send_partial(int steps, double fit_speed, double fit_diff, const double sens_val[NB_SENSORS]) {
+  double fit_sens = 0;
+  int i;
+  for (i=0;i<NB_SENSORS;i++) {
+      if (sens_val[i] > fit_sens) fit_sens = sens_val[i];
+  }
+  pso_msg_init(&msg,PSO_MSG_PARTIAL,episode,robot_id_u,1);
+  msg.h.steps = steps;
+  msg.values[msg.h.count++] = fit_speed;
+  msg.values[msg.h.count++] = fit_diff;
+  msg.values[msg.h.count++] = fit_sens;
+  wb_emitter_send(emit_pso,(void *)&msg,pso_msg_size(&msg));
+}
+
 // Find the fitness for obstacle avoidance of the passed controller
 double simulation_webot(double weights[DATASIZE+1]){
 
@@ -278,13 +313,17 @@ double simulation_webot(double weights[DATASIZE+1]){
     }
 
   // Simulation
-  for(j=0;j<SIM_STEPS;j++){
+  for(j=0;j<episode_steps;j++){
+    // Abort of the supervisor (racing) for this robot and episode
+    if (j > 0 && abort_received())
+      break;
+
     bmsl = 0; bmsr = 0;
     sum_sensors = 0;
     max_sens = 0;
 
     /* Braitenberg */
-    for(i=0;i<NB_SENSORS;i++) {
+    TIMING_SCOPE("sensors") for(i=0;i<NB_SENSORS;i++) {
         ds_value[i]=wb_distance_sensor_get_value(ds[i]); //Read sensor values
         sum_sensors += ds_value[i]; // Add up sensor values
         max_sens = max_sens>ds_value[i]?max_sens:ds_value[i]; // Check if new highest sensor value
@@ -299,14 +338,14 @@ double simulation_webot(double weights[DATASIZE+1]){
     bmsl+=66; bmsr+=72;
 
     /* Send and get information */
-    send_ping();  // sending a ping to other robot, so they can measure their distance to this robot
+    TIMING_SCOPE("send_ping") send_ping();  // sending a ping to other robot, so they can measure their distance to this robot
 
     // Compute self position
     prev_my_position[0] = my_position[0];
     prev_my_position[1] = my_position[1];
-    update_self_motion(msl,msr);
+    TIMING_SCOPE("kalman") update_self_motion(msl,msr);
 
-    process_received_ping_messages();
+    TIMING_SCOPE("ping") process_received_ping_messages();
 
     speed[robot_id][0] = (1/DELTA_T)*(my_position[0]-prev_my_position[0]);
     speed[robot_id][1] = (1/DELTA_T)*(my_position[1]-prev_my_position[1]);
@@ -389,11 +428,13 @@ double simulation_webot(double weights[DATASIZE+1]){
     msl_w = msl*MAX_SPEED_WEB/(MAX_SPEED+1);
     msr_w = msr*MAX_SPEED_WEB/(MAX_SPEED+1);
 
-    wb_motor_set_velocity(left_motor, msl_w);
-    wb_motor_set_velocity(right_motor, msr_w);
+    TIMING_SCOPE("motors") {
+        wb_motor_set_velocity(left_motor, msl_w);
+        wb_motor_set_velocity(right_motor, msr_w);
+    }
 
     // Continue one step
-    wb_robot_step(TIME_STEP);
+    TIMING_ROBOT_STEP(TIME_STEP);
 
     // Get current fitness value
     // Average speed
@@ -406,15 +447,19 @@ double simulation_webot(double weights[DATASIZE+1]){
     for (i=0;i<NB_SENSORS;i++) {
         sens_val[i] += ds_value[i]/MAX_SENS;
     }
+
+    // Stream the fitness so far to the supervisor
+    if ((j+1)%PARTIAL_WINDOW == 0 && j+1 < episode_steps)
+        send_partial(j+1,fit_speed,fit_diff,sens_val);
   }
   // Find most active sensor
   for (i=0;i<NB_SENSORS;i++) {
       if (sens_val[i] > fit_sens) fit_sens = sens_val[i];
   }
-  // Average values over all steps
-  fit_speed /= SIM_STEPS;
-  fit_diff /= SIM_STEPS;
-  fit_sens /= SIM_STEPS;
+  // Average values over the steps run (less than SIM_STEPS if aborted)
+  fit_speed /= j;
+  fit_diff /= j;
+  fit_sens /= j;
 
   // Better fitness should be higher
   fitness = fit_speed*(1.0 - sqrt(fit_diff))*(1.0 - fit_sens);
@@ -428,8 +473,7 @@ double simulation_webot(double weights[DATASIZE+1]){
 */
 int main() {
     // Init
-    double end_sim[255];
-    double *new_weights;
+    double new_weights[DATASIZE+1];  // weights and spawn z of this robot
     double fitness=-1;
     reset();
     wb_motor_set_velocity(left_motor, 0);  // Initialize robot velocity to zero
@@ -439,12 +483,21 @@ int main() {
     while (1) {
         // Wait for data
         while (wb_receiver_get_queue_length(rec_pso) == 0) {
-            wb_robot_step(TIME_STEP);
+            TIMING_ROBOT_STEP(TIME_STEP);
         }
 
+        // Weights of this robot (the aborts of the racing that arrived after the end of an episode are skipped)
+        if (pso_msg_read(&msg,wb_receiver_get_data(rec_pso),wb_receiver_get_data_size(rec_pso)) ||
+            pso_msg_weights(&msg,robot_id_u,DATASIZE,new_weights)) {
+            wb_receiver_next_packet(rec_pso);
+            continue;
+        }
+        episode = msg.h.episode;
+        episode_steps = pso_msg_steps(msg.h.length,SIM_STEPS);
+        wb_receiver_next_packet(rec_pso);
+
         // Print weight
         if( 1 && robot_verbose){printf("************************ Weight ***************************\n");}
-        new_weights = (double *)wb_receiver_get_data(rec_pso);
         if( 1 && robot_verbose){printf("Robot %d : %.2lf, %.2lf, %.2lf, %.2lf, %.2lf, %.2lf, %.2lf, %.2lf\n         %.2lf, %.2lf, %.2lf, %.2lf, %.2lf, %.2lf, %.2lf, %.2lf\n----------------------------\n",robot_id, new_weights[0], new_weights[1],new_weights[2], new_weights[3], new_weights[4], new_weights[5],new_weights[6], new_weights[7],new_weights[7]+2, new_weights[6]+2, new_weights[5]+2, new_weights[4]+2, new_weights[3]+2, new_weights[2]+2, new_weights[1]+2, new_weights[0]+2);}
 
         // Update initial position
@@ -463,11 +516,11 @@ int main() {
         kal_reset();
 
         // Run simulation
-        fitness = simulation_webot(new_weights);
+        TIMING_SCOPE("episode") fitness = simulation_webot(new_weights);
 
-        end_sim[0]=fitness;
-        wb_emitter_send(emit_pso,(void *)end_sim,sizeof(double));
-        wb_receiver_next_packet(rec_pso);
+        pso_msg_init(&msg,PSO_MSG_FITNESS,episode,robot_id_u,1);
+        msg.values[msg.h.count++] = fitness;
+        wb_emitter_send(emit_pso,(void *)&msg,pso_msg_size(&msg));
 
         if( 1 && robot_verbose){printf("********************************************************\n");}
     }
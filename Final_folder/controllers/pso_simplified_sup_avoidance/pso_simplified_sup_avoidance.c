@@ -12,27 +12,28 @@
 #include <stdlib.h>
 #include <time.h>
 #include <math.h>
+#include <string.h>
 #include <webots/emitter.h>
 #include <webots/receiver.h>
 #include <webots/supervisor.h>
 #include <webots/robot.h>
+#include "../common/timing.h"
+#include "../common/telemetry.h"
+#include "../common/kinematic_sim.h"
+#include "../common/pso_msg.h"
 
 /* Tunable parameters: ------------------------------------------------------
- NOISY : activate the noise resistance PSO with reevaluation of the best performance
- DOMAIN_WEIGHT : Limit the parameters of the PSO in the domain
+ The options of the PSO (NOISY, OCBA, CACHE, ...) are documented in common/pso_options.h, a definition
+ here replaces its default
  RND_POS : Spawn all the robot in a fixed configuration at different location on the z-axis
- PRIOR_KNOWLEDGE : Initialize the first particles weight to the hand-tune value found empiricaly */
+ RACING : Abort the episodes that can no longer beat the neighborhood best of their particle, from the partial
+          fitness streamed by the robots
+ KINEMATIC : Evaluate the particles in the kinematic simulation of common/kinematic_sim.c instead of Webots
+             (much faster, the final runs are still done in Webots) */
 
-#define NOISY 1
-#define DOMAIN_WEIGHT 0
 #define RND_POS 1
-#define PRIOR_KNOWLEDGE 0
-
-#if NOISY == 1
-#define ITS_COEFF 1.0     // Multiplier for number of iterations
-#else
-#define ITS_COEFF 2.0     // Multiplier for number of iterations
-#endif
+#define RACING 1
+#define KINEMATIC 0
 
 // Limit Domain
 #define MIN_BRAITEN -200.0              // Lower bound on initialization value for braiten
@@ -47,6 +48,7 @@
 #define MAX_SPEED  6.28                 // Maximum speed of the robots
 #define NB_SENSORS 8                    // Number of distance sensors
 #define TIME_STEP	64	                // [ms] Length of time step
+#define SIM_STEPS 600                   // Length of an evaluation of the robot controllers [steps]
 
 /* PSO definitions */
 #define NB_PARTICLE 9                   // Number of particles in swarm
@@ -64,27 +66,29 @@
 #define FINALRUNS 1
 #define N_RUNS 1
 
-/* Types of fitness evaluations */
-#define EVOLVE 0          // Find new fitness
-#define EVOLVE_AVG 1      // Average new fitness into total
-#define SELECT 2          // Find more accurate fitness for best selection
+#define RACING_BOUND 1.0                     // Speed term assumed for the remaining steps of a racing bound (1: exact)
 
 #define PI 3.1415926535897932384626433832795 // Number Pi
 
 
+#include "../common/pso_options.h"  // After the definitions of the domain
+
 static WbNodeRef epucks[FLOCK_SIZE];
 WbDeviceTag emitter[FLOCK_SIZE];
 WbDeviceTag rec[FLOCK_SIZE];
+static telemetry_t telemetry;       // Live telemetry (see common/telemetry.h)
+static uint32_t msg_episode = 0;    // Episode of the messages with the robots (see common/pso_msg.h)
+static int partial_steps[FLOCK_SIZE];       // Steps of the last partial fitness of each robot
+static double partial_sum[FLOCK_SIZE][3];   // Its sums of the speed, speed difference and most active sensor terms
+static rng_t spawn_rng;             // Spawn positions of the episode
+static ksim_world_t arena;          // Walls and obstacles of the world (see common/kinematic_sim.h)
+static int kinematic_eval = 0;      // Evaluate the particles with fitness_kinematic()
 const double *loc[FLOCK_SIZE];
 const double *rot[FLOCK_SIZE];
 double new_loc[FLOCK_SIZE][3];
 double new_rot[FLOCK_SIZE][4];
 
-// Print in webots FONT
-char label[50];
-char label2[20];
-
-// initial set of weight for pso
+// initial set of weight for pso, first entry of the archive of the runs if there is none (WARM_START)
 double prior_knowledge[DATASIZE] = {17,29,34,10,8,-60,-64,-84 // Braitenberg right
                         //-80,-66,-62,8,10,36,28,18,
                         };
@@ -98,9 +102,32 @@ const double rel_init_pos_robot[FLOCK_SIZE][2]={{-1,0},
                                              };
 
 
+// Copy the walls and obstacles of the world (Solids with a Box bounding object) for the kinematic fitness
+void load_arena(void) {
+  WbFieldRef children = wb_supervisor_node_get_field(wb_supervisor_node_get_root(),"children");
+  int i, n = wb_supervisor_field_get_count(children);
+
+  ksim_init(&arena,0,0);
+  for (i=0;i<n;i++) {
+    WbNodeRef node = wb_supervisor_field_get_mf_node(children,i);
+    if (wb_supervisor_node_get_type(node) != WB_NODE_SOLID)
+      continue;
+    WbNodeRef box = wb_supervisor_field_get_sf_node(wb_supervisor_node_get_field(node,"boundingObject"));
+    if (box == NULL || wb_supervisor_node_get_type(box) != WB_NODE_BOX)
+      continue;
+    const double *t = wb_supervisor_field_get_sf_vec3f(wb_supervisor_node_get_field(node,"translation"));
+    const double *r = wb_supervisor_field_get_sf_rotation(wb_supervisor_node_get_field(node,"rotation"));
+    const double *size = wb_supervisor_field_get_sf_vec3f(wb_supervisor_node_get_field(box,"size"));
+    if (ksim_add_box(&arena,t[0],t[2],size[0],size[2],r[1]*r[3]))
+      printf("Too many obstacles for the kinematic simulation\n");
+  }
+}
+
 /* RESET - Get device handles and starting locations */
 void reset(void) {
   wb_robot_init();
+  TIMING_INIT(wb_robot_get_name());
+  telemetry_open(&telemetry, wb_robot_get_name());
   // Device variables
   char epuck[] = "epuck0";
   char em[] = "emitter0_pso";
@@ -121,101 +148,11 @@ void reset(void) {
     em[7]++;
     receive[8]++;
   }
-  wb_robot_step(TIME_STEP*4);
-}
-
-
-// Copy one particle to another
-void copyParticle(double particle1[DATASIZE], double particle2[DATASIZE]) {
-  int i;                   // FOR-loop counters
-
-  // Copy one bit at a time
-  for (i = 0; i < DATASIZE; i++)
-    particle1[i] = particle2[i];
-}
-
-
-// Update the best performance of a single particle
-void updateLocalPerf(double particles[NB_PARTICLE][DATASIZE],
-double perf[NB_PARTICLE], double lbest[NB_PARTICLE][DATASIZE],
-double lbestperf[NB_PARTICLE], double lbestage[NB_PARTICLE]) {
-
-  int i;                   // FOR-loop counters
-
-  // If current performance of particle better than previous best, update previous best
-  for (i = 0; i < NB_PARTICLE; i++) {
-    if (perf[i] > lbestperf[i]) {
-      copyParticle(lbest[i],particles[i]);
-      lbestperf[i] = perf[i];
-      lbestage[i] = 1.0;
-    }
-  }
-}
-
-
-// Find the best result found, set best to the particle, and return the performance
-double bestResult(double lbest[NB_PARTICLE][DATASIZE], double lbestperf[NB_PARTICLE], double best[DATASIZE]) {
-  double perf;         // Current best performance
-  int i;               // FOR-loop counters
-
-  // Start with the first particle as best
-  copyParticle(best,lbest[0]);
-  perf = lbestperf[0];
-
-
-  // Iterate through the rest of the particles looking for better results
-  for (i = 1; i < NB_PARTICLE; i++) {
-    // If current performance of particle better than previous best, update previous best
-    if (lbestperf[i] > perf) {
-      copyParticle(best,lbest[i]);
-      perf = lbestperf[i];
-    }
-  }
-
-
-  return perf;
-}
-
-
-// Update the best performance of a particle neighborhood
-void updateNBPerf(double lbest[NB_PARTICLE][DATASIZE], double lbestperf[NB_PARTICLE],
-		      double nbbest[NB_PARTICLE][DATASIZE], double nbbestperf[NB_PARTICLE],
-		      int neighbors[NB_PARTICLE][NB_PARTICLE]) {
-  int i,j;                   // FOR-loop counters
-
-  // For each particle, check the best performances of its neighborhood (-NB to NB, with wraparound from swarmsize-1 to 0)
-  for (i = 0; i < NB_PARTICLE; i++) {
-
-    nbbestperf[i] = lbestperf[i];
-
-    for (j = 0; j < NB_PARTICLE; j++) {
-
-      // Make sure it's a valid particle
-      if (!neighbors[i][j]) continue;
-
-      // If current performance of particle better than previous best, update previous best
-      if (lbestperf[j] > nbbestperf[i]) {
-      	copyParticle(nbbest[i],lbest[j]);
-      	nbbestperf[i] = lbestperf[j];
-      }
-    }
-  }
-}
-
-
-// Find the modulus of an integer
-int mod(int num, int base) {
-  while (num >= base)
-    num -= base;
-  while (num < 0)      // Check for if number is negative to
-    num += base;
-  return num;
-}
-
-
-// Generate random number in [0,1]
-double rnd(void) {
-  return ((double)rand())/((double)RAND_MAX);
+  wb_emitter_set_channel(emitter[0],PSO_MSG_CHANNEL);  // Weights broadcast to the whole flock
+  load_arena();
+  for (i=0;i<ROBOTS;i++)
+    racing_threshold[i] = -INFINITY;
+  TIMING_ROBOT_STEP(TIME_STEP*4);
 }
 
 
@@ -224,7 +161,7 @@ double init_pos(int rob_id) {
   static double rnd_posz=0;  // Z-position of the first robot (origin of the group)
   double posz_rob_pso=0;     // Robot's position in the z-axis
   if(rob_id==0){
-    rnd_posz = (1.8-ROB_RAD)*rnd() - (1.8-ROB_RAD)/2.0;
+    rnd_posz = (1.8-ROB_RAD)*rng_uniform(&spawn_rng) - (1.8-ROB_RAD)/2.0;
   }
   if(!RND_POS){  // Fixed position
     //printf("Setting random position for %d\n",rob_id);
@@ -283,228 +220,219 @@ double init_pos(int rob_id) {
 }
 
 
-// Send the weights to the robots, continuously compute the metric of the simulation and return the associated fitness
-void fitness(double weights[ROBOTS][DATASIZE], double fit[ROBOTS]) {
-  double buffer[255];
-  double *rbuffer;
+// Same evaluation as fitness() in the kinematic simulation: robot i runs the particle i%ROBOTS
+void fitness_kinematic(double weights[ROBOTS][DATASIZE], double fit[ROBOTS]) {
+  ksim_world_t world = arena;
+  ksim_controller_t ctrl[FLOCK_SIZE];
+  ksim_result_t res;
+  rng_t noise;
+  int count[ROBOTS];
+  int i,j;
+
+  world.noise = 1;
+  rng_init(&spawn_rng,episode_seed[0],RNG_STREAM(RNG_SPAWN,0));
+  rng_init(&noise,episode_seed[0],RNG_STREAM(RNG_NOISE,0));
+  world.rng = (uint32_t)rng_next(&noise)|1;
+  for (i=0;i<FLOCK_SIZE;i++) {
+    init_pos(i);
+    ksim_add_robot(&world,new_loc[i][0],new_loc[i][2],PI/2+new_rot[i][1]*new_rot[i][3]);
+    for (j=0;j<NB_SENSORS;j++) {
+      ctrl[i].braitenberg_right[j] = weights[i%ROBOTS][j];
+      ctrl[i].braitenberg_left[j] = weights[i%ROBOTS][NB_SENSORS-1-j]+2;
+    }
+    ctrl[i].reynolds = 0;
+  }
+  ksim_episode(&world,ctrl,pso_msg_steps(episode_length,SIM_STEPS),&res);
+
+  for (j=0;j<ROBOTS;j++) {
+    fit[j] = 0;
+    count[j] = 0;
+  }
+  for (i=0;i<FLOCK_SIZE;i++) {
+    fit[i%ROBOTS] += res.obstacle[i];
+    count[i%ROBOTS]++;
+  }
+  for (j=0;j<ROBOTS;j++) {
+    fit[j] /= count[j];
+    telemetry_fitness(&telemetry, fit[j]);
+  }
+}
+
+// Take the fitness messages of the current episode received so far, return the number of robots received
+int receive_fitness(double fit_robot[FLOCK_SIZE], int received[FLOCK_SIZE]) {
+  static pso_msg_t msg;
+  int i, n = 0;
+  for (i=0;i<FLOCK_SIZE;i++) {
+    while (wb_receiver_get_queue_length(rec[i]) > 0) {
+      if (!pso_msg_read(&msg,wb_receiver_get_data(rec[i]),wb_receiver_get_data_size(rec[i])) &&
+          msg.h.episode == msg_episode && msg.h.robot < FLOCK_SIZE) {
+        if (msg.h.type == PSO_MSG_FITNESS && msg.h.count > 0) {
+          fit_robot[msg.h.robot] = msg.values[0];
+          received[msg.h.robot] = 1;
+        }
+        else if (msg.h.type == PSO_MSG_PARTIAL && msg.h.count >= 3 && (int)msg.h.steps > partial_steps[msg.h.robot]) {
+          partial_steps[msg.h.robot] = msg.h.steps;
+          partial_sum[msg.h.robot][0] = msg.values[0];
+          partial_sum[msg.h.robot][1] = msg.values[1];
+          partial_sum[msg.h.robot][2] = msg.values[2];
+        }
+      }
+      wb_receiver_next_packet(rec[i]);
+    }
+  }
+  for (i=0;i<FLOCK_SIZE;i++)
+    n += received[i];
+  return n;
+}
+
+// Fitness of each particle so far (mean over its robots of their final or partial fitness) and upper bound on its
+// fitness at the end of the episode: speed RACING_BOUND, no speed difference and no sensor activity for the remaining steps
+void partial_fitness(const double fit_robot[FLOCK_SIZE], const int received[FLOCK_SIZE], double estimate[ROBOTS], double bound[ROBOTS]) {
+  int count[ROBOTS];
+  int i,j,t;
+  int n = pso_msg_steps(episode_length,SIM_STEPS);  // length of the episode
+  double speed,diff,sens;
+  for (j=0;j<ROBOTS;j++) {
+    estimate[j] = 0;
+    bound[j] = 0;
+    count[j] = 0;
+  }
+  for (i=0;i<FLOCK_SIZE;i++) {
+    j = i%ROBOTS;
+    count[j]++;
+    t = partial_steps[i];
+    if (received[i]) {
+      estimate[j] += fit_robot[i];
+      bound[j] += fit_robot[i];
+    }
+    else if (t == 0) {
+      bound[j] += 1;  // no partial yet: any fitness
+    }
+    else {
+      speed = partial_sum[i][0];
+      diff = partial_sum[i][1];
+      sens = partial_sum[i][2];
+      estimate[j] += speed/t*(1.0-sqrt(diff/t))*(1.0-sens/t);
+      bound[j] += (speed+(n-t)*RACING_BOUND)/n*(1.0-sqrt(diff/n))*(1.0-sens/n);
+    }
+  }
+  for (j=0;j<ROBOTS;j++) {
+    estimate[j] /= count[j];
+    bound[j] /= count[j];
+  }
+}
+
+// Send the weights to the robots, continuously compute the metric of the simulation and return the associated fitness
+void fitness(double weights[ROBOTS][DATASIZE], double fit[ROBOTS]) {
+  static pso_msg_t msg;
+  double fit_robot[FLOCK_SIZE];     // fitness sent by each robot
+  int received[FLOCK_SIZE] = {0};   // the fitness of the robot was received
+  int count[ROBOTS];
+  double estimate[ROBOTS];          // fitness of each particle so far
+  double bound[ROBOTS];             // upper bound on the fitness of each particle
+  int aborted[ROBOTS] = {0};        // the episode of the particle was aborted by the racing
+  int steps;                        // steps of the episode streamed by the robots so far
+  int length = pso_msg_steps(episode_length,SIM_STEPS);  // steps of the episode
+  char label[128];
   double posz_rob_pso;  // save robot position in the z-axis to send it to the robot controller (for GPS)
-  int i,j;            // iterator for-loop
-  /* Send data to robots */
+  int i,j;            // iterator for-loop
+
+  if (kinematic_eval) {
+    fitness_kinematic(weights,fit);
+    return;
+  }
+  // Spawn positions drawn from the seeds of the episodes
+  rng_init(&spawn_rng,episode_seed[0],RNG_STREAM(RNG_SPAWN,0));
+  /* Send data to robots: one message with the weights (robot i runs the particle i%ROBOTS) and spawn position of every robot */
+  msg_episode++;
+  pso_msg_init(&msg,PSO_MSG_WEIGHTS,msg_episode,0,FLOCK_SIZE);
+  msg.h.length = episode_length;
   for (i=0;i<FLOCK_SIZE;i++) {
+    partial_steps[i] = 0;
     posz_rob_pso=init_pos(i);
     for (j=0;j<DATASIZE;j++) {
-      buffer[j] = weights[i][j];
+      msg.values[msg.h.count++] = weights[i%ROBOTS][j];
     }
-    buffer[DATASIZE]=posz_rob_pso;
-    wb_emitter_send(emitter[i],(void *)buffer,(DATASIZE+1)*sizeof(double));
+    msg.values[msg.h.count++] = posz_rob_pso;
   }
+  wb_emitter_send(emitter[0],(void *)&msg,pso_msg_size(&msg));
   wb_supervisor_simulation_reset_physics();
 
-  /* Wait for response */
+  /* Wait for response, aggregating the partial fitness streamed by the robots */
   printf("Superviser begins Simulation\n");
-  while (wb_receiver_get_queue_length(rec[0]) == 0){
-    wb_robot_step(TIME_STEP);
-  }
-
-   /* Get fitness values from robots */
-   for (i=0;i<FLOCK_SIZE;i++) {
-      rbuffer = (double *)wb_receiver_get_data(rec[i]);
-      fit[i] = rbuffer[0];
-      wb_receiver_next_packet(rec[i]);
-      printf("\nfit robot%d (%0.2lf) \n", i, fit[i]);
-  }
-  printf("\n -------------------------------------------------------------------\n");
-}
-
-
-// Find the current performance of the swarm.
-// Higher performance is better
-void findPerformance(double particles[NB_PARTICLE][DATASIZE], double perf[NB_PARTICLE],
-		     double age[NB_PARTICLE], char type) {
-  double particles_sim[ROBOTS][DATASIZE]; // Assign 1 particle for each robot of the flock in simulation
-  double fit[ROBOTS];
-  int i,j,k;                   // FOR-loop counters
-  for (i = 0; i < NB_PARTICLE; i+=ROBOTS) {
-    for (j=0;j<ROBOTS && i+j<NB_PARTICLE;j++) {
-      sprintf(label2,"Particle: %d\n", i+j);
-      wb_supervisor_set_label(1,label2,0.01,0.05,0.05,0xffffff,0,FONT);
-      for (k=0;k<DATASIZE;k++){
-          particles_sim[j][k] = particles[i+j][k];
-      }
-    }
-    // FITNESS FUNCTION
-    if (type == EVOLVE_AVG) {
-      fitness(particles_sim,fit);
-      for (j=0;j<ROBOTS && i+j<NB_PARTICLE;j++) {
-      	perf[i+j] = ((age[i+j]-1.0)*perf[i+j] + fit[j])/age[i+j];
-      	age[i+j]++;
+  while (receive_fitness(fit_robot,received) < FLOCK_SIZE){
+    TIMING_ROBOT_STEP(TIME_STEP);
+    partial_fitness(fit_robot,received,estimate,bound);
+
+    // Racing: abort the robots of a particle when even perfect remaining steps cannot beat its goal
+    for (j=0;j<ROBOTS;j++) {
+      if (!aborted[j] && bound[j] < racing_threshold[j]) {
+        for (i=j;i<FLOCK_SIZE;i+=ROBOTS) {
+          pso_msg_init(&msg,PSO_MSG_ABORT,msg_episode,i,1);
+          wb_emitter_send(emitter[0],(void *)&msg,pso_msg_size(&msg));
+        }
+        printf("Particle %d aborted (bound %lf < %lf)\n",j,bound[j],racing_threshold[j]);
+        aborted[j] = 1;
       }
     }
-    else if (type == EVOLVE) {
-      fitness(particles_sim,fit);
-      for (j=0;j<ROBOTS && i+j<NB_PARTICLE;j++)
-	       perf[i+j] = fit[j];
-    }
-    else if (type == SELECT) {
-      for (j=0;j<ROBOTS && i+j<NB_PARTICLE;j++)
-          perf[i+j] = 0.0;
-      for (k=0;k<5;k++) {
-	  fitness(particles_sim,fit);
-    	for (j=0;j<ROBOTS && i+j<NB_PARTICLE;j++)
-    	  perf[i+j] += fit[j];
-      }
-      for (j=0;j<ROBOTS && i+j<NB_PARTICLE;j++) {
-	       perf[i+j] /= 5.0;
-      }
+
+    // Live fitness of the episode
+    steps = length;
+    for (i=0;i<FLOCK_SIZE;i++) {
+      if (!received[i] && partial_steps[i] < steps)
+        steps = partial_steps[i];
     }
+    sprintf(label,"Episode: %d/%d steps, fitness %.3f (at most %.3f)",steps,length,estimate[0],bound[0]);
+    wb_supervisor_set_label(2,label,0.01,0.09,0.05,0xffffff,0,FONT);
+    telemetry.state.time = wb_robot_get_time();
+    telemetry.state.fitness = estimate[0];
+    telemetry_publish(&telemetry);
   }
-}
-
 
-/* Particle swarm optimization function */
-void limit_weight(double min, double max, double particles[NB_PARTICLE][DATASIZE], int i, int j){
-  if (particles[i][j] > max){
-    particles[i][j] = max;
-  }
-  if (particles[i][j] < min){
-     particles[i][j] = min;
-  }
+   /* Fitness of each particle: average over its robots */
+   for (j=0;j<ROBOTS;j++) {
+      fit[j] = 0;
+      count[j] = 0;
+   }
+   for (i=0;i<FLOCK_SIZE;i++) {
+      fit[i%ROBOTS] += fit_robot[i];
+      count[i%ROBOTS]++;
+      printf("\nfit robot%d (%0.2lf) \n", i, fit_robot[i]);
+   }
+   for (j=0;j<ROBOTS;j++) {
+      fit[j] /= count[j];
+      if (aborted[j])
+        fit[j] = -INFINITY;  // The partial fitness may overestimate the full one, it never becomes a best
+      telemetry_fitness(&telemetry, fit[j]);
+   }
+  printf("\n -------------------------------------------------------------------\n");
 }
-
-
-/* Particle swarm optimization function */
-void pso(double best_weight[DATASIZE]){
-  int i,j,k;                                // FOR-loop counters
-  double min, max;                         // Bound for random init of weights
-  double particles[NB_PARTICLE][DATASIZE];// Swarm of particles
-  double perf[NB_PARTICLE];                 // Current local performance of swarm
-  double lbest[NB_PARTICLE][DATASIZE];    // Current best local swarm
-  double lbestperf[NB_PARTICLE];            // Current best local performance
-  double lbestage[NB_PARTICLE];             // Life length of best local swarm
-  double nbbest[NB_PARTICLE][DATASIZE];   // Current best neighborhood
-  double nbbestperf[NB_PARTICLE];           // Current best neighborhood performance
-  double v[NB_PARTICLE][DATASIZE];        // Velocity of particles
-  int neighbors[NB_PARTICLE][NB_PARTICLE];  // Neighbor matrix
-  double bestperf;                          // Performance of evolved solution
-
-  // Seed the random generator
-  srand(time(NULL));
-
-  // Setup neighborhood (Topological)
-  printf("Init neighborhood\n");
-  for (i = 0; i < NB_PARTICLE; i++) {
-    for (j = 0; j < NB_PARTICLE; j++) {
-      if (mod(i-j+NB_NEIGHBOURS, NB_PARTICLE) <= 2*NB_NEIGHBOURS){
-        neighbors[i][j] = 1;
-      }
-      else{
-        neighbors[i][j] = 0;
-      }
-    }
-  }
 
-  // Display iteration number
-  sprintf(label, "Iteration: 0");
-  wb_supervisor_set_label(0,label,0.01,0.01,0.1,0xffffff,0,FONT);
-
-  // Initialize the swarm
-  for (i = 0; i < NB_PARTICLE; i++) {
-    for (j = 0; j < DATASIZE; j++) {
-
-      // Assign initial value with handtuned weights
-      if(PRIOR_KNOWLEDGE){
-          // Assign first weight with prior knowledge
-          particles[i][j]=prior_knowledge[j];
-          lbest[i][j] = particles[i][j];           // Best configurations are initially current configurations
-          nbbest[i][j] = particles[i][j];
-          v[i][j] = 2.0*VMAX*rnd()-VMAX;         // Random initial velocity
-      }
-
-      // Randomly assign initial value in [min,max]
-      else{
-          min=MIN_BRAITEN;
-          max=MAX_BRAITEN;
-          particles[i][j] = (max-min)*rnd()+min;
-          lbest[i][j] = particles[i][j];           // Best configurations are initially current configurations
-          nbbest[i][j] = particles[i][j];
-          v[i][j] = 2.0*VMAX*rnd()-VMAX;         // Random initial velocity
-      }
-    }
+/* Particle swarm optimization function (see common/pso.h) */
+void pso(double best_weight[DATASIZE], uint64_t seed){
+  pso_t swarm;
+  pso_config_t cfg;
+  double init_min[DATASIZE], init_max[DATASIZE];    // Bound for random init of weights
+  double limit_min[DATASIZE], limit_max[DATASIZE];  // Domain of the weights (DOMAIN_WEIGHT)
+  int j;
+
+  for (j=0;j<DATASIZE;j++) {
+    init_min[j] = MIN_BRAITEN;
+    init_max[j] = MAX_BRAITEN;
+    limit_min[j] = MIN_WEIGHT_BRAITEN;
+    limit_max[j] = MAX_WEIGHT_BRAITEN;
   }
-  // Best performances are initially current performances
-  findPerformance(particles, perf, NULL, EVOLVE);
-  for (i = 0; i < NB_PARTICLE; i++) {
-    lbestperf[i] = perf[i];
-    lbestage[i] = 1.0;  // One performance so far
-    nbbestperf[i] = perf[i];
-  }
-
-  // Find best neighborhood performances
-  updateNBPerf(lbest,lbestperf,nbbest,nbbestperf,neighbors);
-
-  printf("****** Swarm initialized\n");
-
-  // Run optimization
-  for (k = 0; k < ITS_COEFF*ITS_PSO; k++) {
-    sprintf(label, "Iteration: %d",k+1);
-    wb_supervisor_set_label(0,label,0.01,0.01,0.1,0xffffff,0,FONT);
-    // Update preferences and generate new particles
-    for (i = 0; i < NB_PARTICLE; i++) {
-      for (j = 0; j < DATASIZE; j++) {
-          v[i][j] *= (double) DAMPING;
-          v[i][j] += (double) (LWEIGHT*rnd()*(lbest[i][j] - particles[i][j]) + NBWEIGHT*rnd()*(nbbest[i][j] - particles[i][j]));
-          particles[i][j] += v[i][j]; // Move particles
-
-
-          // Limit of the domain
-          if(DOMAIN_WEIGHT){
-              limit_weight(MIN_WEIGHT_BRAITEN, MAX_WEIGHT_BRAITEN, particles, i, j);
-          }
-      }
-    }
-
 
+  pso_config_from_options(&cfg,init_min,init_max,limit_min,limit_max,seed);
+  if (kinematic_eval)
+    cfg.cache = NULL;  // The cache holds the fitness in Webots
 
-     // RE-EVALUATE PERFORMANCES OF PREVIOUS BESTS
-#if NOISY == 1
-    findPerformance(lbest,lbestperf,lbestage,EVOLVE_AVG);
-#endif
-
-
-    // Find new performance
-    findPerformance(particles,perf,NULL,EVOLVE);
-
-    // Update best local performance
-    updateLocalPerf(particles,perf,lbest,lbestperf,lbestage);
-
-    // Update best neighborhood performance
-    updateNBPerf(lbest,lbestperf,nbbest,nbbestperf,neighbors);
-
-    // Find and print the best result of the last PSO_iteration
-    double temp[DATASIZE];
-    bestperf = bestResult(lbest,lbestperf,temp);
-    printf("\n...................................................................................................................\nBest performance of the iteration : %lf",bestperf);
-    printf("\nBest Weights of the iteration:");
-    for (i=0; i<DATASIZE;i++){
-      if(!(i%8)){
-         printf("\n%.2lf\t", temp[i]);
-      }
-      else{
-         printf("%.2lf\t", temp[i]);
-      }
-    }
-   printf("\n ...................................................................................................................\n");
-   }
-
-   // Find and print the best result of the PSO
-   findPerformance(lbest,lbestperf,NULL,SELECT);
-   bestperf = bestResult(lbest,lbestperf,best_weight);
-   printf("_____Best performance found\n");
-   printf("Performance over %d iterations: %lf\n",ITS_PSO,bestperf);
-
-    // Display end of the PSO
-   sprintf(label, "Optimization process over.");
-   wb_supervisor_set_label(0,label,0.01,0.01,0.1,0xffffff,0,FONT);
+  if (pso_init(&swarm,&cfg)) {
+    printf("Could not allocate the swarm\n");
+    return;
+  }
+  pso_run(&swarm,best_weight);
+  pso_free(&swarm);
 }
 
 /*
@@ -512,14 +440,24 @@ void pso(double best_weight[DATASIZE]){
 */
 int main() {
   reset();
+  kinematic_eval = KINEMATIC;
+
+  // Worker of a pool, island and results of the previous runs (see common/pso_options.h)
+  int status = pso_options_open(prior_knowledge,NULL);
+  if (status)
+    return status < 0;  // 0 for a worker that is done
+
   double best_weight[DATASIZE]; // best solution of pso
   double fit, w[ROBOTS][DATASIZE], f[ROBOTS];
   int i,j,k;  // Counter variables
+  uint64_t seed = rng_master_seed();  // Seed of the runs, logged (see common/rng.h)
 
   // Get result of optimization
   // Do N_RUNS runs and send the best controller found to the robot
   for (j=0;j<N_RUNS;j++) {
-    pso(best_weight);
+    kinematic_eval = KINEMATIC;  // Every PSO run on the kinematic model (KINEMATIC)
+    TIMING_SCOPE("pso_run") pso(best_weight,rng_derive(seed,RNG_STREAM(RNG_RUN,j)));
+    kinematic_eval = 0;  // Confirm the best particle in Webots
 
     // Set robot weights to optimization results
     fit = 0.0;
@@ -531,7 +469,8 @@ int main() {
     // Run FINALRUN tests and calculate average
     printf("Running final runs\n");
     for (i=0;i<FINALRUNS;i+=ROBOTS) {
-        fitness(w,f);
+        next_episodes(seed);
+        TIMING_SCOPE("fitness") fitness(w,f);
         for (k=0;k<ROBOTS && i+k<FINALRUNS;k++) {
             //fitvals[i+k] = f[k];
             fit += f[k];
@@ -542,9 +481,13 @@ int main() {
     printf("Average Performance: %.3f\n",fit);
   }
 
+  // Stop the workers and leave the island model
+  pso_options_close();
+
   /* Wait forever */
   while (1){
-    fitness(w,f);
+    next_episodes(seed);
+    TIMING_SCOPE("fitness") fitness(w,f);
   }
 
   return 0;
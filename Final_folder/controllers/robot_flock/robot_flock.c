@@ -26,6 +26,8 @@
 #include "../localization_controller/utils.h"
 #include "../localization_controller/odometry.h"
 #include "../localization_controller/kalman.h"
+#include "../common/timing.h"
+#include "../common/telemetry.h"
 
 #define NB_SENSORS         8      // Number of distance sensors
 #define MIN_SENS          350     // Minimum sensibility value
@@ -79,6 +81,7 @@ WbDeviceTag right_encoder;//handler for right encoder of the robot
 WbDeviceTag dev_gps; // GPS handler
 
 int robot_id_u, robot_id;    // Unique and normalized (between 0 and FLOCK_SIZE-1) robot ID
+static telemetry_t telemetry;       // Live telemetry (see common/telemetry.h)
 int robot_verbose;
 
 float relative_pos[FLOCK_SIZE][3];    // relative X, Z, Theta (heading)
@@ -116,6 +119,8 @@ static double controller_get_heading_gps();
  */
 static void reset() {
     wb_robot_init();
+    TIMING_INIT(wb_robot_get_name());
+    telemetry_open(&telemetry, wb_robot_get_name());
     dev_gps = wb_robot_get_device("gps");
     wb_gps_enable(dev_gps, 1000); // Enable GPS every 1000ms <=> 1s
     time_step = wb_robot_get_basic_time_step();
@@ -338,6 +343,7 @@ void process_received_ping_messages(void) {
         // since the name of the sender is in the received message. Note: this does not work for robots having id bigger than 9!
         other_robot_id = (int) (inbuffer[5] -
                                 '0');  
+        telemetry_neighbor(&telemetry, other_robot_id, range, theta - my_position[2]);
 
         // Get position update
         prev_relative_pos[other_robot_id][0] = relative_pos[other_robot_id][0];
@@ -381,14 +387,16 @@ int main() {
         max_sens = 0;
 
         /* Braitenberg */
-        for (i = 0; i < NB_SENSORS; i++) {
-            ds_value[i] = wb_distance_sensor_get_value(ds[i]); //Read sensor values
-            sum_sensors += ds_value[i]; // Add up sensor values
-            max_sens = max_sens > ds_value[i] ? max_sens : ds_value[i]; // Check if new highest sensor value
-
-            // Weighted sum of distance sensor values for Braitenburg vehicle
-            bmsr += e_puck_matrix[i] * ds_value[i];
-            bmsl += e_puck_matrix[i + NB_SENSORS] * ds_value[i];
+        TIMING_SCOPE("sensors") {
+            for (i = 0; i < NB_SENSORS; i++) {
+                ds_value[i] = wb_distance_sensor_get_value(ds[i]); //Read sensor values
+                sum_sensors += ds_value[i]; // Add up sensor values
+                max_sens = max_sens > ds_value[i] ? max_sens : ds_value[i]; // Check if new highest sensor value
+
+                // Weighted sum of distance sensor values for Braitenburg vehicle
+                bmsr += e_puck_matrix[i] * ds_value[i];
+                bmsl += e_puck_matrix[i + NB_SENSORS] * ds_value[i];
+            }
         }
 
 
@@ -400,23 +408,23 @@ int main() {
 
         /* Send and get information */
         // sending a ping to other robot, so they can measure their distance to this robot
-        send_ping();  
+        TIMING_SCOPE("send_ping") send_ping();
 
         /// Compute self position
         prev_my_position[0] = my_position[0];
         prev_my_position[1] = my_position[1];
 
         // Update position using Kalman and odometry
-        update_self_motion(msl, msr);
+        TIMING_SCOPE("kalman") update_self_motion(msl, msr);
 
-        process_received_ping_messages();
+        TIMING_SCOPE("ping") process_received_ping_messages();
 
 
         speed[robot_id][0] = (1 / DELTA_T) * (my_position[0] - prev_my_position[0]);
         speed[robot_id][1] = (1 / DELTA_T) * (my_position[1] - prev_my_position[1]);
 
         // Reynold's rules with all previous info (updates the speed[][] table)
-        reynolds_rules();
+        TIMING_SCOPE("reynolds") reynolds_rules();
 
         // Compute wheels speed from reynold's speed
         compute_wheel_speeds(&msl, &msr);
@@ -501,11 +509,21 @@ int main() {
         msl_w = msl * MAX_SPEED_WEB / (MAX_SPEED + 1);
         msr_w = msr * MAX_SPEED_WEB / (MAX_SPEED + 1);
 
-        wb_motor_set_velocity(left_motor, msl_w);
-        wb_motor_set_velocity(right_motor, msr_w);
+        TIMING_SCOPE("motors") {
+            wb_motor_set_velocity(left_motor, msl_w);
+            wb_motor_set_velocity(right_motor, msr_w);
+        }
+
+        // Publish the live telemetry
+        telemetry.state.time = wb_robot_get_time();
+        telemetry.state.x = my_position[0];
+        telemetry.state.y = my_position[1];
+        telemetry.state.heading = my_position[2];
+        telemetry.state.fsm_state = avoidance;
+        telemetry_publish(&telemetry);
 
         // Continue one step
-        wb_robot_step(TIME_STEP);
+        TIMING_ROBOT_STEP(TIME_STEP);
     }
 
 }
@@ -0,0 +1,38 @@
+#!/bin/bash
+###############################################################################
+# File:         pso_islands.sh
+# Version:      1.0
+# Date:         19-Oct-26
+# Description:  Run a PSO world as an island model: independent swarms in
+#               separate simulations exchange their best particles
+#               (see controllers/common/island.c)
+#
+#   Usage: pso_islands.sh <world.wbt> [n_islands]
+#          n_islands defaults to the number of cores
+#
+# Author:       DIS group 7
+###############################################################################
+
+WORLD=$1
+ISLANDS=${2:-$(nproc)}
+WEBOTS=${WEBOTS:-webots}
+export PSO_ISLAND_SOCKET=${PSO_ISLAND_SOCKET:-/tmp/dis_pso_island_$$}
+
+if [ -z "$WORLD" ] || [ ! -f "$WORLD" ] || [ "$ISLANDS" -lt 1 ]; then
+    echo "Usage: $0 <world.wbt> [n_islands]"
+    exit 1
+fi
+
+# Island 0 runs in a normal Webots window, the others are headless
+PSO_ISLAND=0/$ISLANDS "$WEBOTS" --mode=fast "$WORLD" &
+FIRST=$!
+
+PIDS=()
+for ((i = 1; i < ISLANDS; i++)); do
+    PSO_ISLAND=$i/$ISLANDS "$WEBOTS" --mode=fast --no-rendering --minimize --batch --stdout --stderr "$WORLD" > "pso_island_$i.log" 2>&1 &
+    PIDS+=($!)
+done
+
+# A lost island does not stop the others: wait for all of them
+trap 'kill ${PIDS[@]} $FIRST 2> /dev/null' INT TERM
+wait $FIRST "${PIDS[@]}"
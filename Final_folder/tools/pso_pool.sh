@@ -0,0 +1,37 @@
+#!/bin/bash
+###############################################################################
+# File:         pso_pool.sh
+# Version:      1.0
+# Date:         19-Oct-26
+# Description:  Run a PSO world with a pool of headless worker simulations
+#               (see controllers/common/pso_pool.c)
+#
+#   Usage: pso_pool.sh <world.wbt> [n_workers]
+#          n_workers defaults to the number of cores minus one
+#
+# Author:       DIS group 7
+###############################################################################
+
+WORLD=$1
+WORKERS=${2:-$(($(nproc) - 1))}
+WEBOTS=${WEBOTS:-webots}
+export PSO_SOCKET=${PSO_SOCKET:-/tmp/dis_pso_pool_$$.sock}
+
+if [ -z "$WORLD" ] || [ ! -f "$WORLD" ]; then
+    echo "Usage: $0 <world.wbt> [n_workers]"
+    exit 1
+fi
+
+# The coordinator runs the PSO in a normal Webots window, the workers are headless
+PSO_ROLE=coordinator "$WEBOTS" --mode=fast "$WORLD" &
+COORDINATOR=$!
+
+PIDS=()
+for ((i = 0; i < WORKERS; i++)); do
+    PSO_ROLE=worker "$WEBOTS" --mode=fast --no-rendering --minimize --batch --stdout --stderr "$WORLD" > "pso_worker_$i.log" 2>&1 &
+    PIDS+=($!)
+done
+
+trap 'kill ${PIDS[@]} $COORDINATOR 2> /dev/null' INT TERM
+wait $COORDINATOR
+kill "${PIDS[@]}" 2> /dev/null
@@ -0,0 +1,565 @@
+/*****************************************************************************/
+/* File:         pso_tune.c                                                  */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Benchmark of the PSO parameters (LWEIGHT, NBWEIGHT,         */
+/*               DAMPING, VMAX, NB_NEIGHBOURS, NB_PARTICLE) and of CMA-ES on */
+/*               analytic functions and on the kinematic flocking fitness    */
+/*                                                                           */
+/*   Build: gcc -O2 -o pso_tune pso_tune.c ../controllers/common/pso.c ../controllers/common/pso_pool.c
+ *          ../controllers/common/ocba.c ../controllers/common/checkpoint.c ../controllers/common/fitness_cache.c
+ *          ../controllers/common/surrogate.c ../controllers/common/rng.c ../controllers/common/cmaes.c
+ *          ../controllers/common/island.c ../controllers/common/pareto.c ../controllers/common/warm_start.c
+ *          ../controllers/common/kinematic_sim.c -lm
+ *   Usage: pso_tune [-f problems] [-n list] [-k list] [-l list] [-g list] [-d list] [-v list] [-c]
+ *                   [-b evaluations] [-r runs] [-s noise] [-t target] [-w workers] [-j jobs] [-W world.wbt]
+ *          See usage() for the options                                      */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "../controllers/common/pso.h"
+#include "../controllers/common/kinematic_sim.h"
+
+/* Every configuration (one value of each list, and CMA-ES with -c) optimizes every problem in
+   runs with the seeds of the runs, the same for all the configurations. The harness follows the
+   best personal best of the swarm at each iteration: its true fitness (without noise, or the mean
+   of VALIDATION_EPISODES fixed episodes for flock) against the evaluations so far gives the
+   convergence of the run. A configuration is reported by its true fitness after a quarter, half
+   and all of the budget of evaluations, and by the evaluations and rounds to reach the target.
+   A round is one episode of every worker of a pool (-w): an iteration of e evaluations takes
+   about ceil(e/workers) rounds, the wall-clock time of the optimization in episodes. The runs
+   are shared by the processes (-j), each one writes its convergence in shared memory. */
+
+#define MAX_VALUES           8        // Values of a parameter list
+#define MAX_POINTS           1024     // Iterations followed in a run
+#define MAX_DIM              16
+#define VALIDATION_EPISODES  10       // Episodes of the true fitness of flock
+
+/* Flocking fitness of pso_simplified_sup_flock.c in the kinematic simulation (fitness_kinematic()) */
+#define FLOCK_SIZE           5
+#define FLOCK_DIM            5
+#define SCALING_REYNOLD      1000
+#define SIM_STEPS            600
+#define ROB_RAD              0.035
+
+typedef struct
+{
+  const char *name;
+  int dim;                    // 0: -D
+  double lo, hi;              // Initialization domain of every element
+  int limited;                // The particles stay in the domain
+  double (*f)(const double *x, int dim, uint64_t seed);
+  double (*truth)(const double *x, int dim);
+} problem_t;
+
+/// Optimizer configuration
+typedef struct
+{
+  int cmaes;                  // CMAES_NONE or the restart strategy
+  int n, neighbours;
+  double lweight, nbweight, damping, vmax;
+} tune_config_t;
+
+/// Convergence of a run, shared with the parent process
+typedef struct
+{
+  int n_points;
+  int evals[MAX_POINTS];      // Evaluations when the best was taken
+  int rounds[MAX_POINTS];     // Rounds of the pool so far
+  double truth[MAX_POINTS];   // True fitness of the best personal best
+} tune_run_t;
+
+static ksim_world_t arena;
+static double noise_sd = 0.0;
+static int dim_analytic = 5;
+
+/* State of the run of this process */
+static const problem_t *problem;
+static pso_t swarm;
+static tune_run_t *run;
+static int evaluations, last_evals, rounds, workers = 1;
+static double last_best[MAX_DIM], last_truth;  // Last best followed
+
+static double gauss(uint64_t seed) {
+    rng_t r;
+    rng_init(&r, seed, RNG_STREAM(RNG_NOISE, 0));
+    return sqrt(-2.0 * log(1.0 - rng_uniform(&r))) * cos(2.0 * M_PI * rng_uniform(&r));
+}
+
+static double sphere(const double *x, int dim) {
+    double s = 0;
+    int k;
+    for (k = 0; k < dim; k++)
+        s += x[k] * x[k];
+    return -s;
+}
+
+static double rosenbrock(const double *x, int dim) {
+    double s = 0;
+    int k;
+    for (k = 0; k + 1 < dim; k++)
+        s += 100.0 * (x[k + 1] - x[k] * x[k]) * (x[k + 1] - x[k] * x[k]) + (1.0 - x[k]) * (1.0 - x[k]);
+    return -s;
+}
+
+static double rastrigin(const double *x, int dim) {
+    double s = 10.0 * dim;
+    int k;
+    for (k = 0; k < dim; k++)
+        s += x[k] * x[k] - 10.0 * cos(2.0 * M_PI * x[k]);
+    return -s;
+}
+
+static double ackley(const double *x, int dim) {
+    double a = 0, b = 0;
+    int k;
+    for (k = 0; k < dim; k++) {
+        a += x[k] * x[k];
+        b += cos(2.0 * M_PI * x[k]);
+    }
+    return 20.0 * exp(-0.2 * sqrt(a / dim)) + exp(b / dim) - 20.0 - M_E;
+}
+
+/* Analytic fitness with a Gaussian noise of sd noise_sd (-s), drawn from the seed of the evaluation */
+static double noisy_sphere(const double *x, int dim, uint64_t seed) {
+    return sphere(x, dim) + noise_sd * gauss(seed);
+}
+
+static double noisy_rosenbrock(const double *x, int dim, uint64_t seed) {
+    return rosenbrock(x, dim) + noise_sd * gauss(seed);
+}
+
+static double noisy_rastrigin(const double *x, int dim, uint64_t seed) {
+    return rastrigin(x, dim) + noise_sd * gauss(seed);
+}
+
+static double noisy_ackley(const double *x, int dim, uint64_t seed) {
+    return ackley(x, dim) + noise_sd * gauss(seed);
+}
+
+/* One episode of the flock in the arena of the world, as fitness_kinematic() of pso_simplified_sup_flock.c */
+static double flock(const double *x, int dim, uint64_t seed) {
+    const int e_puck_matrix[2 * KSIM_NB_SENSORS] = {17, 29, 34, 10, 8, -60, -64, -84,
+                                                     -80, -66, -62, 8, 10, 36, 28, 18};
+    const double offset[FLOCK_SIZE] = {0, 0.1, -0.1, 0.2, -0.2};
+    ksim_world_t world = arena;
+    ksim_controller_t ctrl[FLOCK_SIZE];
+    ksim_result_t res;
+    rng_t spawn, noise;
+    double z;
+    int i, k;
+
+    (void)dim;
+    rng_init(&spawn, seed, RNG_STREAM(RNG_SPAWN, 0));
+    rng_init(&noise, seed, RNG_STREAM(RNG_NOISE, 0));
+    world.noise = 1;
+    world.rng = (uint32_t)rng_next(&noise) | 1;
+    z = (1.8 - ROB_RAD) * rng_uniform(&spawn) - (1.8 - ROB_RAD) / 2.0;
+    for (i = 0; i < FLOCK_SIZE; i++) {
+        ksim_add_robot(&world, 0.0, z + offset[i], M_PI / 2 - 1.5708);
+        for (k = 0; k < KSIM_NB_SENSORS; k++) {
+            ctrl[i].braitenberg_right[k] = e_puck_matrix[k];
+            ctrl[i].braitenberg_left[k] = e_puck_matrix[KSIM_NB_SENSORS + k];
+        }
+        ctrl[i].reynolds = 1;
+        ctrl[i].rule1_threshold = x[0] / SCALING_REYNOLD;
+        ctrl[i].rule1_weight = x[1] / SCALING_REYNOLD;
+        ctrl[i].rule2_threshold = x[2] / SCALING_REYNOLD;
+        ctrl[i].rule2_weight = x[3] / SCALING_REYNOLD;
+        ctrl[i].migration_weight = x[4] / SCALING_REYNOLD;
+        ctrl[i].migr[0] = 0;
+        ctrl[i].migr[1] = -25;
+    }
+    ksim_episode(&world, ctrl, SIM_STEPS, &res);
+    return res.flocking;
+}
+
+/* Mean of the flocking fitness over fixed episodes */
+static double flock_truth(const double *x, int dim) {
+    double s = 0;
+    int e;
+    for (e = 0; e < VALIDATION_EPISODES; e++)
+        s += flock(x, dim, rng_derive(1, RNG_STREAM(RNG_FINAL, e)));
+    return s / VALIDATION_EPISODES;
+}
+
+static const problem_t problems[] = {
+    {"sphere", 0, -100.0, 100.0, 1, noisy_sphere, sphere},
+    {"rosenbrock", 0, -5.0, 10.0, 1, noisy_rosenbrock, rosenbrock},
+    {"rastrigin", 0, -5.12, 5.12, 1, noisy_rastrigin, rastrigin},
+    {"ackley", 0, -32.0, 32.0, 1, noisy_ackley, ackley},
+    {"flock", FLOCK_DIM, 1.0, 100.0, 0, flock, flock_truth},  // MIN_REYNOLDS, MAX_REYNOLDS, no DOMAIN_WEIGHT
+};
+#define N_PROBLEMS  (int)(sizeof(problems) / sizeof(problems[0]))
+
+/* Walls and obstacles of a world: top-level Solids with a Box bounding object, as load_arena() */
+static int load_world(const char *path) {
+    char line[256];
+    double t[3] = {0, 0, 0}, r[4] = {0, 1, 0, 0}, size[3];
+    int solid = 0, box = 0, in_box = 0;
+    FILE *fp = fopen(path, "r");
+
+    if (fp == NULL)
+        return 1;
+    ksim_init(&arena, 0, 0);
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (line[0] != ' ' && strstr(line, "Solid {") != NULL) {
+            solid = 1;
+            box = in_box = 0;
+            t[0] = t[1] = t[2] = 0;
+            r[0] = r[2] = r[3] = 0;
+            r[1] = 1;
+        }
+        else if (solid && strncmp(line, "  translation ", 14) == 0)
+            sscanf(line + 14, "%lf %lf %lf", &t[0], &t[1], &t[2]);
+        else if (solid && strncmp(line, "  rotation ", 11) == 0)
+            sscanf(line + 11, "%lf %lf %lf %lf", &r[0], &r[1], &r[2], &r[3]);
+        else if (solid && strncmp(line, "  boundingObject ", 17) == 0)
+            in_box = strstr(line, "Box {") != NULL;
+        else if (in_box && sscanf(line, " size %lf %lf %lf", &size[0], &size[1], &size[2]) == 3)
+            box = 1;
+        else if (solid && line[0] == '}') {
+            if (box && ksim_add_box(&arena, t[0], t[2], size[0], size[2], r[1] * r[3]))
+                fprintf(stderr, "Too many obstacles in %s\n", path);
+            solid = box = in_box = 0;
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+/* Fitness of the jobs of the engine: particle and seed of the evaluation */
+static void evaluate(const double *jobs, int n, double *fit) {
+    int i, dim = swarm.dim;
+    for (i = 0; i < n; i++)
+        fit[i] = problem->f(&jobs[i * swarm.size], dim, (uint64_t)jobs[i * swarm.size + swarm.size - 1]);
+    evaluations += n;
+}
+
+/* Start of an iteration: follow the best personal best of the swarm */
+static void follow(int id, const char *text) {
+    int i, b = 0;
+
+    (void)text;
+    if (id != 0 || evaluations == last_evals || run->n_points >= MAX_POINTS)
+        return;
+    for (i = 1; i < swarm.n; i++)
+        if (swarm.lbestperf[i] > swarm.lbestperf[b])
+            b = i;
+    if (isinf(swarm.lbestperf[b]))
+        return;  // CMA-ES before its first candidates
+    rounds += (evaluations - last_evals + workers - 1) / workers;
+    last_evals = evaluations;
+    run->evals[run->n_points] = evaluations;
+    run->rounds[run->n_points] = rounds;
+    if (run->n_points == 0 || memcmp(last_best, &swarm.lbest[b * swarm.dim], swarm.dim * sizeof(double)) != 0) {
+        memcpy(last_best, &swarm.lbest[b * swarm.dim], swarm.dim * sizeof(double));
+        last_truth = problem->truth(last_best, swarm.dim);  // Only for a new best (episodes of flock)
+    }
+    run->truth[run->n_points] = last_truth;
+    run->n_points++;
+}
+
+/* One run of a configuration on a problem within the budget */
+static void tune(const tune_config_t *t, const problem_t *pb, int budget, uint64_t seed, tune_run_t *out) {
+    pso_config_t cfg;
+    double lo[MAX_DIM], hi[MAX_DIM], best[MAX_DIM];
+    int dim = pb->dim > 0 ? pb->dim : dim_analytic;
+    int k, per_iteration;
+
+    for (k = 0; k < dim; k++) {
+        lo[k] = pb->lo;
+        hi[k] = pb->hi;
+    }
+    pso_config_default(&cfg, t->n, dim);
+    cfg.n_neighbours = t->neighbours;
+    cfg.lweight = t->lweight;
+    cfg.nbweight = t->nbweight;
+    cfg.damping = t->damping;
+    cfg.vmax = t->vmax * (pb->hi - pb->lo) / 99.0;  // VMAX of the supervisors is for the domain 1..100
+    cfg.cmaes = t->cmaes;
+    cfg.noisy = noise_sd > 0 || pb->f == flock;
+    cfg.ocba = cfg.noisy;
+    per_iteration = t->n + (cfg.noisy ? cfg.ocba_budget : 0);
+    cfg.iterations = t->cmaes != CMAES_NONE ? (budget + t->n - 1) / t->n :
+                     (budget - t->n + per_iteration - 1) / per_iteration;
+    if (cfg.iterations < 1)
+        cfg.iterations = 1;
+    cfg.seed = seed;
+    cfg.init_min = lo;
+    cfg.init_max = hi;
+    if (pb->limited) {
+        cfg.limit_min = lo;
+        cfg.limit_max = hi;
+    }
+    cfg.fitness = evaluate;
+    cfg.label = follow;
+
+    problem = pb;
+    run = out;
+    memset(out, 0, sizeof(*out));
+    evaluations = last_evals = rounds = 0;
+    if (pso_init(&swarm, &cfg)) {
+        fprintf(stderr, "Cannot allocate a swarm of %d particles\n", t->n);
+        return;
+    }
+    pso_run(&swarm, best);
+    pso_free(&swarm);
+}
+
+static int parse_list(const char *s, double *v) {
+    int n = 0;
+    char *end;
+    while (n < MAX_VALUES && *s != '\0') {
+        v[n++] = strtod(s, &end);
+        if (end == s)
+            return 0;
+        s = *end == ',' ? end + 1 : end;
+    }
+    return n;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -f problems    sphere,rosenbrock,rastrigin,ackley,flock (default: all)\n"
+            "  -n list        NB_PARTICLE values (default 9)\n"
+            "  -k list        NB_NEIGHBOURS values (default 1,2)\n"
+            "  -l list        LWEIGHT values (default 1,2)\n"
+            "  -g list        NBWEIGHT values (default 2,4)\n"
+            "  -d list        DAMPING values (default 0.4,0.6,0.8)\n"
+            "  -v list        VMAX values, for the domain 1..100 of the supervisors (default 30)\n"
+            "  -c             also CMA-ES with IPOP and BIPOP restarts\n"
+            "  -b evaluations budget of a run (default 500)\n"
+            "  -r runs        runs of each configuration (default 10)\n"
+            "  -s noise       sd of the noise of the analytic functions (default 0)\n"
+            "  -t target      true fitness to reach (default: median of the final fitness of all the runs)\n"
+            "  -D dim         elements of the analytic functions (default 5)\n"
+            "  -w workers     workers of the pool, for the rounds (default 1)\n"
+            "  -j jobs        processes (default: number of cores)\n"
+            "  -S seed        master seed of the runs (default 1)\n"
+            "  -W world       world of flock (default ../worlds/pso_world_simplified_flocking.wbt)\n",
+            name);
+}
+
+static int compare(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* True fitness of a run after evals evaluations (-INFINITY before its first point) */
+static double truth_at(const tune_run_t *r, int evals) {
+    double v = -INFINITY;
+    int i;
+    for (i = 0; i < r->n_points && r->evals[i] <= evals; i++)
+        v = r->truth[i];
+    return v;
+}
+
+static void print_config(const tune_config_t *t) {
+    if (t->cmaes != CMAES_NONE)
+        printf("  CMA-ES %-5s              ", t->cmaes == CMAES_IPOP ? "IPOP" : "BIPOP");
+    else
+        printf("  %3d %2d %5.2f %5.2f %5.2f %6.1f", t->n, t->neighbours, t->lweight, t->nbweight, t->damping, t->vmax);
+}
+
+/* Report of a problem: convergence of each configuration and the fastest to the target */
+static void report(const problem_t *pb, const tune_config_t *configs, int n_configs, const tune_run_t *runs,
+                   int n_runs, int budget, double target, int has_target) {
+    double *final = malloc(n_configs * n_runs * sizeof(double));
+    const int part[3] = {4, 2, 1};  // Budgets b/4, b/2 and b
+    double mean[3], evals, rnds, best_rounds = INFINITY;
+    int c, r, q, i, reached, best = -1, best_reached = 0;
+
+    for (i = 0; i < n_configs * n_runs; i++)
+        final[i] = truth_at(&runs[i], budget);
+    if (!has_target) {
+        qsort(final, n_configs * n_runs, sizeof(double), compare);
+        target = final[n_configs * n_runs / 2];
+    }
+    free(final);
+
+    printf("\n%s: %d elements, %d evaluations, %d runs, target %g\n", pb->name, pb->dim > 0 ? pb->dim : dim_analytic,
+           budget, n_runs, target);
+    printf("    n nb  lw    nbw   damp  vmax   %11s %11s %11s reached  evals  rounds\n", "f(b/4)", "f(b/2)", "f(b)");
+    for (c = 0; c < n_configs; c++) {
+        const tune_run_t *cr = &runs[c * n_runs];
+        for (q = 0; q < 3; q++) {
+            mean[q] = 0;
+            for (r = 0; r < n_runs; r++)
+                mean[q] += truth_at(&cr[r], budget / part[q]) / n_runs;
+        }
+        reached = 0;
+        evals = rnds = 0;
+        for (r = 0; r < n_runs; r++) {
+            for (i = 0; i < cr[r].n_points && cr[r].evals[i] <= budget && cr[r].truth[i] < target; i++)
+                ;
+            if (i < cr[r].n_points && cr[r].evals[i] <= budget) {
+                reached++;
+                evals += cr[r].evals[i];
+                rnds += cr[r].rounds[i];
+            }
+        }
+        print_config(&configs[c]);
+        printf(" %11.4g %11.4g %11.4g %4d/%-3d", mean[0], mean[1], mean[2], reached, n_runs);
+        if (reached > 0)
+            printf(" %6.0f %7.0f\n", evals / reached, rnds / reached);
+        else
+            printf(" %6s %7s\n", "-", "-");
+        // The fastest of the configurations that reach the target the most often
+        if (reached > 0 && (reached > best_reached || (reached == best_reached && rnds / reached < best_rounds))) {
+            best = c;
+            best_reached = reached;
+            best_rounds = rnds / reached;
+        }
+    }
+    if (best >= 0) {
+        printf("Fastest to the target:");
+        print_config(&configs[best]);
+        printf(" (%d/%d runs, %.0f rounds)\n", best_reached, n_runs, best_rounds);
+    }
+    fflush(stdout);
+}
+
+/* Runs of the tasks first, first+stride, ... (one process), task i being the run i % n_runs of the
+   configuration i / n_runs % n_configs on the problem i / (n_configs * n_runs) */
+static void run_tasks(int first, int stride, int n_tasks, const int *selected, const tune_config_t *configs,
+                      int n_configs, int n_runs, int budget, uint64_t seed, tune_run_t *runs) {
+    int i, p;
+
+    for (i = first; i < n_tasks; i += stride) {
+        p = i / (n_configs * n_runs);
+        if (selected[p])
+            tune(&configs[i / n_runs % n_configs], &problems[p], budget,
+                 rng_derive(seed, RNG_STREAM(RNG_RUN, i % n_runs)), &runs[i]);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    double n_list[MAX_VALUES] = {9}, k_list[MAX_VALUES] = {1, 2}, l_list[MAX_VALUES] = {1, 2};
+    double g_list[MAX_VALUES] = {2, 4}, d_list[MAX_VALUES] = {0.4, 0.6, 0.8}, v_list[MAX_VALUES] = {30};
+    int n_n = 1, n_k = 2, n_l = 2, n_g = 2, n_d = 3, n_v = 1;
+    int selected[N_PROBLEMS], cmaes = 0, budget = 500, n_runs = 10, has_target = 0;
+    int jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    const char *world = "../worlds/pso_world_simplified_flocking.wbt";
+    double target = 0;
+    uint64_t seed = 1;
+    tune_config_t *configs;
+    tune_run_t *runs;
+    int n_configs = 0, n_tasks, started, out, p, j, a, b, c, d, e, f, opt;
+    pid_t *pids;
+
+    for (p = 0; p < N_PROBLEMS; p++)
+        selected[p] = 1;
+    while ((opt = getopt(argc, argv, "f:n:k:l:g:d:v:cb:r:s:t:D:w:j:S:W:h")) != -1) {
+        switch (opt) {
+            case 'f':
+                for (p = 0; p < N_PROBLEMS; p++)
+                    selected[p] = strstr(optarg, problems[p].name) != NULL;
+                break;
+            case 'n': n_n = parse_list(optarg, n_list); break;
+            case 'k': n_k = parse_list(optarg, k_list); break;
+            case 'l': n_l = parse_list(optarg, l_list); break;
+            case 'g': n_g = parse_list(optarg, g_list); break;
+            case 'd': n_d = parse_list(optarg, d_list); break;
+            case 'v': n_v = parse_list(optarg, v_list); break;
+            case 'c': cmaes = 1; break;
+            case 'b': budget = atoi(optarg); break;
+            case 'r': n_runs = atoi(optarg); break;
+            case 's': noise_sd = atof(optarg); break;
+            case 't': target = atof(optarg); has_target = 1; break;
+            case 'D': dim_analytic = atoi(optarg); break;
+            case 'w': workers = atoi(optarg); break;
+            case 'j': jobs = atoi(optarg); break;
+            case 'S': seed = strtoull(optarg, NULL, 0); break;
+            case 'W': world = optarg; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (!n_n || !n_k || !n_l || !n_g || !n_d || !n_v || budget < 1 || n_runs < 1 || workers < 1 ||
+        dim_analytic < 2 || dim_analytic > MAX_DIM) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (jobs < 1)
+        jobs = 1;
+    if (selected[N_PROBLEMS - 1] && load_world(world)) {
+        fprintf(stderr, "Cannot read %s, flock skipped (-W)\n", world);
+        selected[N_PROBLEMS - 1] = 0;
+    }
+
+    // Configurations: every combination of the lists, then CMA-ES
+    configs = malloc((n_n * n_k * n_l * n_g * n_d * n_v + 2) * sizeof(tune_config_t));
+    for (a = 0; a < n_n; a++)
+        for (b = 0; b < n_k; b++)
+            for (c = 0; c < n_l; c++)
+                for (d = 0; d < n_g; d++)
+                    for (e = 0; e < n_d; e++)
+                        for (f = 0; f < n_v; f++) {
+                            tune_config_t t = {CMAES_NONE, (int)n_list[a], (int)k_list[b], l_list[c], g_list[d],
+                                               d_list[e], v_list[f]};
+                            configs[n_configs++] = t;
+                        }
+    if (cmaes) {
+        tune_config_t ipop = {CMAES_IPOP, (int)n_list[0], 0, 0, 0, 0, 0};
+        configs[n_configs++] = ipop;
+        configs[n_configs] = ipop;
+        configs[n_configs++].cmaes = CMAES_BIPOP;
+    }
+
+    // Runs of every problem, configuration and seed, shared by the processes
+    n_tasks = N_PROBLEMS * n_configs * n_runs;
+    runs = mmap(NULL, n_tasks * sizeof(tune_run_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    pids = malloc(jobs * sizeof(pid_t));
+    if (runs == MAP_FAILED || pids == NULL || configs == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    fprintf(stderr, "%d configurations, %d runs each, on %d processes\n", n_configs, n_runs, jobs);
+    for (started = 0; started < jobs; started++) {
+        pids[started] = fork();
+        if (pids[started] == 0) {
+            if (freopen("/dev/null", "w", stdout) == NULL)  // Output of the engine
+                _exit(1);
+            run_tasks(started, jobs, n_tasks, selected, configs, n_configs, n_runs, budget, seed, runs);
+            _exit(0);
+        }
+        if (pids[started] < 0) {
+            fprintf(stderr, "Cannot start process %d, its runs and the next ones run in this process\n", started);
+            break;
+        }
+    }
+
+    // Tasks of the processes that could not start, with the output of the engine discarded
+    if (started < jobs) {
+        fflush(stdout);
+        out = dup(STDOUT_FILENO);
+        if (out < 0 || freopen("/dev/null", "w", stdout) == NULL) {
+            fprintf(stderr, "Cannot discard the output of the engine\n");
+            return 1;
+        }
+        for (j = started; j < jobs; j++)
+            run_tasks(j, jobs, n_tasks, selected, configs, n_configs, n_runs, budget, seed, runs);
+        fflush(stdout);
+        dup2(out, STDOUT_FILENO);
+        close(out);
+    }
+    for (j = 0; j < started; j++)
+        waitpid(pids[j], NULL, 0);
+
+    for (p = 0; p < N_PROBLEMS; p++)
+        if (selected[p])
+            report(&problems[p], configs, n_configs, &runs[p * n_configs * n_runs], n_runs, budget, target, has_target);
+    munmap(runs, n_tasks * sizeof(tune_run_t));
+    free(configs);
+    free(pids);
+    return 0;
+}
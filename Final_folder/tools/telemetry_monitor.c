@@ -0,0 +1,84 @@
+/*****************************************************************************/
+/* File:         telemetry_monitor.c                                         */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Live display of the telemetry published by the controllers */
+/*               in shared memory (see controllers/common/telemetry.c)       */
+/*                                                                           */
+/*   Build: gcc -O2 -o telemetry_monitor telemetry_monitor.c ../controllers/common/telemetry.c -lm -lrt
+ *   Usage: telemetry_monitor [period_ms] [-n] [-1]                          */
+/*          -n: print the neighbor tables, -1: print once and exit           */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "../controllers/common/telemetry.h"
+
+static void print_segment(const telemetry_segment_t *seg, int neighbors) {
+    telemetry_slot_t slot;
+    int i, k, n = 0;
+
+    printf("%-16s %7s %9s %8s %8s %8s %8s %4s %10s %10s %9s %9s %3s\n", "controller", "pid", "time[s]", "steps",
+           "x", "y", "heading", "fsm", "fitness", "best", "step[ms]", "max[ms]", "nb");
+    for (i = 0; i < TELEMETRY_MAX_SLOTS; i++) {
+        if (!telemetry_read(seg, i, &slot))
+            continue;
+        const telemetry_state_t *s = &slot.state;
+        printf("%-16.16s %7d %9.2f %8llu %8.3f %8.3f %8.3f %4d %10.4g %10.4g %9.2f %9.2f %3d\n", slot.name, slot.pid,
+               s->time, (unsigned long long)s->step, s->x, s->y, s->heading, s->fsm_state, s->fitness, s->best_fitness,
+               s->step_us / 1000, s->step_max_us / 1000, s->n_neighbors);
+        if (neighbors) {
+            for (k = 0; k < s->n_neighbors && k < TELEMETRY_MAX_NEIGHBORS; k++)
+                printf("    robot %2d: range %6.3f m, bearing %6.3f rad, %5.2f s ago\n", s->neighbors[k].id,
+                       s->neighbors[k].range, s->neighbors[k].bearing, s->time - s->neighbors[k].time);
+        }
+        n++;
+    }
+    printf("%d controller(s)\n", n);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+    const telemetry_segment_t *seg;
+    struct timespec period = {0, 500000000};
+    int neighbors = 0, once = 0, i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0)
+            neighbors = 1;
+        else if (strcmp(argv[i], "-1") == 0)
+            once = 1;
+        else {
+            long ms = atol(argv[i]);
+            if (ms <= 0) {
+                fprintf(stderr, "Usage: %s [period_ms] [-n] [-1]\n", argv[0]);
+                return 1;
+            }
+            period.tv_sec = ms / 1000;
+            period.tv_nsec = (ms % 1000) * 1000000L;
+        }
+    }
+
+    seg = telemetry_attach();
+    if (seg == NULL) {
+        fprintf(stderr, "Error: no telemetry in %s (no controller running?).\n", TELEMETRY_SHM_NAME);
+        return 1;
+    }
+
+    for (;;) {
+        if (!once)
+            printf("\033[H\033[2J");  // clear the terminal
+        print_segment(seg, neighbors);
+        if (once)
+            break;
+        nanosleep(&period, NULL);
+    }
+
+    telemetry_detach(seg);
+    return 0;
+}
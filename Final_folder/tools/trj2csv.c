@@ -0,0 +1,61 @@
+/*****************************************************************************/
+/* File:         trj2csv.c                                                   */
+/* Version:      1.0                                                         */
+/* Date:         19-Oct-26                                                   */
+/* Description:  Decompress a trajectory log (.trj) written by the           */
+/*               supervisor into the csv read by read_log_project.m          */
+/*                                                                           */
+/*   Build: gcc -O2 -o trj2csv trj2csv.c ../controllers/common/trajectory_codec.c -lm
+ *   Usage: trj2csv supervisor_log.trj [supervisor_log.csv] [first_block]    */
+/*                                                                           */
+/* Author:       DIS group 7                                                 */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../controllers/common/trajectory_codec.h"
+
+int main(int argc, char *argv[]) {
+    trj_reader_t *r;
+    FILE *out = stdout;
+    double *row;
+    long rows = 0;
+    int i, n;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s log.trj [log.csv] [first_block]\n", argv[0]);
+        return 1;
+    }
+
+    r = trj_open_read(argv[1]);
+    if (r == NULL) {
+        fprintf(stderr, "Error: %s is not a trajectory log.\n", argv[1]);
+        return 1;
+    }
+    if (argc > 2 && (out = fopen(argv[2], "w")) == NULL) {
+        fprintf(stderr, "Error opening %s.\n", argv[2]);
+        trj_close_read(r);
+        return 1;
+    }
+    if (argc > 3 && trj_seek_block(r, atol(argv[3]))) {
+        fprintf(stderr, "Error: block %s does not exist.\n", argv[3]);
+        trj_close_read(r);
+        return 1;
+    }
+
+    n = trj_n_cols(r);
+    row = malloc(n*sizeof(double));
+    fprintf(out, "%s\n", trj_header(r));
+    while (trj_read_row(r, row)) {
+        for (i = 0; i < n; i++)
+            fprintf(out, i == n-1 ? "%g\n" : "%g; ", row[i]);
+        rows++;
+    }
+    fprintf(stderr, "%ld rows decompressed.\n", rows);
+
+    free(row);
+    trj_close_read(r);
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}